@@ -259,32 +259,44 @@ function radToDeg(deg) {
    return deg * radToDegFac;
 }
 
+// vectors, quats and matrices are Float64Arrays where available,
+// matching the values handed out by the engine
+var __hasTypedArrays = (typeof Float64Array !== "undefined");
+
+function __newVector(len, hint) {
+   var ret = __hasTypedArrays ? new Float64Array(len) : new Array(len);
+   ret.__TYPE_HINT = hint;
+   return ret;
+}
+
 function makeVec2(x,y) {
-   var ret = [x,y];
-   ret.__TYPE_HINT = "V2";
+   var ret = __newVector(2, "V2");
+   ret[0] = x; ret[1] = y;
    return ret;
 }
 
 function makeVec3(x,y,z) {
-   var ret = [x,y,z];
-   ret.__TYPE_HINT = "V3";
+   var ret = __newVector(3, "V3");
+   ret[0] = x; ret[1] = y; ret[2] = z;
    return ret;
 }
 
 function makeVec4(x,y,z,w) {
-   var ret = [x,y,z,w];
-   ret.__TYPE_HINT = "V4";
+   var ret = __newVector(4, "V4");
+   ret[0] = x; ret[1] = y; ret[2] = z; ret[3] = w;
    return ret;
 }
 
 function makeQuat(x,y,z, w) {
-   var ret = [x,y,z,w];
-   ret.__TYPE_HINT = "QT";
+   var ret = __newVector(4, "QT");
+   ret[0] = x; ret[1] = y; ret[2] = z; ret[3] = w;
    return ret;
 }
 
+// matrix is an array of four rows, m[i][j], as handed out by the engine
 function makeMatrix(p1,p2,p3,p4,p5,p6,p7,p8,p9,p10,p11,p12,p13,p14,p15,p16) {
-   var ret = [[p1,p2,p3,p4],[p5,p6,p7,p8],[p9,p10,p11,p12],[p13,p14,p15,p16]];
+   var ret = [makeVec4(p1,p2,p3,p4), makeVec4(p5,p6,p7,p8),
+              makeVec4(p9,p10,p11,p12), makeVec4(p13,p14,p15,p16)];
    ret.__TYPE_HINT = "MT";
    return ret;
 }
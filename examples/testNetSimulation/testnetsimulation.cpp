@@ -0,0 +1,255 @@
+/* -*-c++-*-
+* testNetSimulation - Using 'The MIT License'
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*
+* Martin Scheffler
+*/
+
+// Runs a dead reckoning server and a number of clients in one process,
+// connected by a simulated network. Reports bandwidth, update rate and the
+// error between server and client positions.
+
+#include <dtEntity/dynamicscomponent.h>
+#include <dtEntity/entity.h>
+#include <dtEntity/entitymanager.h>
+#include <dtEntity/init.h>
+#include <dtEntity/logmanager.h>
+#include <dtEntity/mapcomponent.h>
+#include <dtEntity/messagefactory.h>
+#include <dtEntity/spawner.h>
+#include <dtEntity/systemmessages.h>
+#include <dtEntityNet/deadreckoningreceivercomponent.h>
+#include <dtEntityNet/deadreckoningsendercomponent.h>
+#include <dtEntityNet/loopbackcomponent.h>
+#include <dtEntityNet/messages.h>
+#include <dtEntityOSG/positionattitudetransformcomponent.h>
+#include <osg/ArgumentParser>
+#include <iostream>
+#include <math.h>
+
+#define SPAWNER_NAME "Boid"
+
+////////////////////////////////////////////////////////////////////////////////
+struct Peer
+{
+   dtEntity::EntityManager* mEntityManager;
+   dtEntityNet::LoopbackSystem* mLoopback;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+Peer CreatePeer(dtEntityNet::LoopbackNetwork* network)
+{
+   Peer peer;
+   dtEntity::EntityManager* em = new dtEntity::EntityManager();
+   peer.mEntityManager = em;
+
+   dtEntity::MapSystem* mapsys = new dtEntity::MapSystem(*em);
+   em->AddEntitySystem(*mapsys);
+   em->AddEntitySystem(*new dtEntity::DynamicsSystem(*em));
+   em->AddEntitySystem(*new dtEntityOSG::PositionAttitudeTransformSystem(*em));
+   em->AddEntitySystem(*new dtEntityNet::DeadReckoningSenderSystem(*em));
+   em->AddEntitySystem(*new dtEntityNet::DeadReckoningReceiverSystem(*em));
+
+   peer.mLoopback = new dtEntityNet::LoopbackSystem(*em);
+   em->AddEntitySystem(*peer.mLoopback);
+   peer.mLoopback->SetNetwork(network);
+
+   // remote entities are created from this spawner on join
+   dtEntity::Spawner* spawner = new dtEntity::Spawner(SPAWNER_NAME, "");
+   spawner->AddComponent(dtEntity::MapComponent::TYPE, dtEntity::GroupProperty());
+   spawner->AddComponent(dtEntityOSG::PositionAttitudeTransformComponent::TYPE, dtEntity::GroupProperty());
+   spawner->AddComponent(dtEntity::DynamicsComponent::TYPE, dtEntity::GroupProperty());
+   mapsys->AddSpawner(*spawner);
+
+   return peer;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void Tick(dtEntity::EntityManager& em, double simtime, float dt)
+{
+   dtEntity::TickMessage tickmsg;
+   tickmsg.SetSimulationTime(simtime);
+   tickmsg.SetDeltaSimTime(dt);
+   tickmsg.SetDeltaRealTime(dt);
+   em.EmitQueuedMessages(simtime);
+   em.EmitMessage(tickmsg);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// move entity on a circle, with velocities matching the movement
+void MoveEntity(dtEntity::EntityManager& em, dtEntity::EntityId id, unsigned int index, double simtime)
+{
+   double radius = 5 + index % 7;
+   double speed = 0.2 + 0.05 * (index % 5);
+   double angle = speed * simtime + index;
+   osg::Vec3d center(20.0 * index, 0, 0);
+
+   dtEntityOSG::PositionAttitudeTransformComponent* trans;
+   dtEntity::DynamicsComponent* dyn;
+   em.GetComponent(id, trans);
+   em.GetComponent(id, dyn);
+
+   trans->SetPosition(center + osg::Vec3d(cos(angle), sin(angle), 0) * radius);
+   trans->SetRotation(osg::Quat(angle, osg::Vec3d(0, 0, 1)));
+   dyn->SetVelocity(osg::Vec3(-sin(angle), cos(angle), 0) * (radius * speed));
+   dyn->SetAngularVelocity(osg::Quat(speed, osg::Vec3d(0, 0, 1)));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int main(int argc, char** argv)
+{
+   osg::ArgumentParser arguments(&argc, argv);
+
+   unsigned int numClients = 4;
+   unsigned int numEntities = 100;
+   double duration = 60;
+   double framerate = 60;
+   double latency = 0.05;
+   double jitter = 0.01;
+   float loss = 0.01f;
+   float bandwidth = 0;
+   unsigned int seed = 1;
+
+   arguments.read("--clients", numClients);
+   arguments.read("--entities", numEntities);
+   arguments.read("--duration", duration);
+   arguments.read("--framerate", framerate);
+   arguments.read("--latency", latency);
+   arguments.read("--jitter", jitter);
+   arguments.read("--loss", loss);
+   arguments.read("--bandwidth", bandwidth);
+   arguments.read("--seed", seed);
+
+   dtEntity::LogManager::GetInstance().AddListener(new dtEntity::ConsoleLogHandler());
+
+   dtEntity::RegisterSystemMessages(dtEntity::MessageFactory::GetInstance());
+   dtEntityNet::RegisterMessageTypes(dtEntity::MessageFactory::GetInstance());
+
+   osg::ref_ptr<dtEntityNet::LoopbackNetwork> network = new dtEntityNet::LoopbackNetwork(seed);
+   network->SetLatency(latency);
+   network->SetJitter(jitter);
+   network->SetPacketLoss(loss);
+   network->SetBandwidth(bandwidth);
+
+   Peer server = CreatePeer(network.get());
+   server.mLoopback->InitializeServer();
+
+   std::vector<Peer> clients;
+   for(unsigned int i = 0; i < numClients; ++i)
+   {
+      Peer client = CreatePeer(network.get());
+      client.mLoopback->Connect();
+      clients.push_back(client);
+   }
+
+   dtEntity::MapSystem* servermap;
+   server.mEntityManager->GetES(servermap);
+   dtEntity::Spawner* spawner;
+   servermap->GetSpawner(SPAWNER_NAME, spawner);
+
+   std::vector<dtEntity::EntityId> entityids;
+   std::vector<std::string> uniqueids;
+   for(unsigned int i = 0; i < numEntities; ++i)
+   {
+      dtEntity::Entity* entity;
+      server.mEntityManager->CreateEntity(entity);
+      spawner->Spawn(*entity);
+      MoveEntity(*server.mEntityManager, entity->GetId(), i, 0);
+
+      dtEntityNet::DeadReckoningSenderComponent* sender;
+      entity->CreateComponent(sender);
+      sender->SetDeadReckoningAlgorithm(dtEntityNet::DeadReckoningAlgorithm::RVW);
+      sender->SetEntityType(SPAWNER_NAME);
+
+      entityids.push_back(entity->GetId());
+      uniqueids.push_back(sender->GetUniqueId());
+      server.mEntityManager->AddToScene(entity->GetId());
+   }
+
+   const float dt = 1.0f / framerate;
+   unsigned int numFrames = (unsigned int)(duration * framerate);
+
+   double errorSum = 0;
+   double errorMax = 0;
+   unsigned int numSamples = 0;
+   unsigned int numMissing = 0;
+
+   for(unsigned int frame = 1; frame <= numFrames; ++frame)
+   {
+      double simtime = frame * dt;
+      network->SetTime(simtime);
+
+      for(unsigned int i = 0; i < entityids.size(); ++i)
+      {
+         MoveEntity(*server.mEntityManager, entityids[i], i, simtime);
+      }
+      Tick(*server.mEntityManager, simtime, dt);
+
+      for(std::vector<Peer>::iterator c = clients.begin(); c != clients.end(); ++c)
+      {
+         Tick(*c->mEntityManager, simtime, dt);
+
+         dtEntity::MapSystem* clientmap;
+         c->mEntityManager->GetES(clientmap);
+
+         for(unsigned int i = 0; i < entityids.size(); ++i)
+         {
+            dtEntity::Entity* remote;
+            if(!clientmap->GetEntityByUniqueId(uniqueids[i], remote))
+            {
+               ++numMissing;
+               continue;
+            }
+            dtEntityOSG::PositionAttitudeTransformComponent* local;
+            dtEntityOSG::PositionAttitudeTransformComponent* replica;
+            server.mEntityManager->GetComponent(entityids[i], local);
+            remote->GetComponent(replica);
+
+            double err = (local->GetPosition() - replica->GetPosition()).length();
+            errorSum += err;
+            errorMax = osg::maximum(errorMax, err);
+            ++numSamples;
+         }
+      }
+   }
+
+   const dtEntityNet::LoopbackNetwork::Statistics& stats = network->GetStatistics();
+
+   std::cout << "Clients:              " << numClients << "\n";
+   std::cout << "Entities:             " << numEntities << "\n";
+   std::cout << "Simulated seconds:    " << duration << " at " << framerate << " Hz\n";
+   std::cout << "Latency/jitter/loss:  " << latency << "s / " << jitter << "s / " << loss * 100 << "%\n";
+   std::cout << "Packets sent:         " << stats.mPacketsSent << " (" << stats.mPacketsDropped << " dropped)\n";
+   std::cout << "Bandwidth:            " << stats.mBytesSent / duration << " bytes/s total, "
+             << stats.mBytesSent / duration / osg::maximum(numClients, 1u) << " bytes/s per client\n";
+   std::cout << "Update rate:          " << stats.mPacketsDelivered / duration / osg::maximum(numClients * numEntities, 1u)
+             << " updates/s per entity and client\n";
+   std::cout << "Position error:       mean " << (numSamples ? errorSum / numSamples : 0)
+             << ", max " << errorMax << "\n";
+   std::cout << "Samples w/o replica:  " << numMissing << "\n";
+
+   for(std::vector<Peer>::iterator c = clients.begin(); c != clients.end(); ++c)
+   {
+      delete c->mEntityManager;
+   }
+   delete server.mEntityManager;
+
+   return 0;
+}
@@ -0,0 +1,118 @@
+/* -*-c++-*-
+* testScriptDispatch - Using 'The MIT License'
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*
+* Martin Scheffler
+*/
+
+// Compares the cost of calling many per-entity script update functions
+// through individual TickMessage subscriptions with the batched
+// update dispatch of the script system.
+
+#include <dtEntity/entitymanager.h>
+#include <dtEntity/init.h>
+#include <dtEntity/logmanager.h>
+#include <dtEntity/messagefactory.h>
+#include <dtEntity/systemmessages.h>
+#include <dtEntityWrappers/scriptcomponent.h>
+#include <osg/ArgumentParser>
+#include <osg/Timer>
+#include <iostream>
+#include <sstream>
+
+////////////////////////////////////////////////////////////////////////////////
+// emit numTicks tick messages, return average time per tick in seconds
+double RunTicks(dtEntity::EntityManager& em, unsigned int numTicks)
+{
+   osg::Timer_t start = osg::Timer::instance()->tick();
+   for(unsigned int i = 0; i < numTicks; ++i)
+   {
+      dtEntity::TickMessage msg;
+      msg.SetDeltaSimTime(1.0f / 60.0f);
+      msg.SetDeltaRealTime(1.0f / 60.0f);
+      msg.SetSimulationTime(i / 60.0);
+      em.EmitMessage(msg);
+   }
+   return osg::Timer::instance()->delta_s(start, osg::Timer::instance()->tick()) / numTicks;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int main(int argc, char** argv)
+{
+   osg::ArgumentParser arguments(&argc, argv);
+
+   unsigned int numCallbacks = 10000;
+   unsigned int numTicks = 100;
+   arguments.read("--callbacks", numCallbacks);
+   arguments.read("--ticks", numTicks);
+
+   dtEntity::LogManager::GetInstance().AddListener(new dtEntity::ConsoleLogHandler());
+   dtEntity::RegisterSystemMessages(dtEntity::MessageFactory::GetInstance());
+
+   dtEntity::EntityManager em;
+   dtEntityWrappers::ScriptSystem* scriptsys = new dtEntityWrappers::ScriptSystem(em);
+   em.AddEntitySystem(*scriptsys);
+
+   v8::HandleScope scope;
+
+   std::ostringstream setup;
+   setup << "var numCallbacks = " << numCallbacks << ";\n"
+         << "var counter = 0;\n"
+         << "var updates = [];\n"
+         << "for(var i = 0; i < numCallbacks; ++i) {\n"
+         << "  updates.push(function(a, b) { counter += 1; });\n"
+         << "}\n";
+   scriptsys->ExecuteJS(setup.str());
+
+   // one message subscription per entity
+   scriptsys->ExecuteJS(
+      "for(var i = 0; i < numCallbacks; ++i) {\n"
+      "  EntityManager.registerForMessages(\"TickMessage\", updates[i]);\n"
+      "}\n");
+   RunTicks(em, 1);
+   double subscriptionTime = RunTicks(em, numTicks);
+   scriptsys->ExecuteJS(
+      "for(var i = 0; i < numCallbacks; ++i) {\n"
+      "  EntityManager.unregisterForMessages(\"TickMessage\", updates[i]);\n"
+      "}\n");
+
+   // batched update dispatch
+   scriptsys->ExecuteJS(
+      "for(var i = 0; i < numCallbacks; ++i) {\n"
+      "  registerUpdate(i + 1, updates[i]);\n"
+      "}\n");
+   RunTicks(em, 1);
+   double dispatchTime = RunTicks(em, numTicks);
+
+   double perSubscription = subscriptionTime / numCallbacks * 1000000.0;
+   double perDispatch = dispatchTime / numCallbacks * 1000000.0;
+
+   std::cout << "Callbacks:                 " << numCallbacks << " over " << numTicks << " ticks\n";
+   std::cout << "Message subscriptions:     " << subscriptionTime * 1000 << " ms per tick, "
+             << perSubscription << " us per callback\n";
+   std::cout << "Batched update dispatch:   " << dispatchTime * 1000 << " ms per tick, "
+             << perDispatch << " us per callback\n";
+   if(perDispatch > 0)
+   {
+      std::cout << "Speedup:                   " << perSubscription / perDispatch << "x\n";
+   }
+
+   return 0;
+}
@@ -45,6 +45,7 @@ namespace dtEntity
       static const ComponentType TYPE;
       static const StringId TimeScaleId;
       static const StringId CmdLineArgsId;
+      static const StringId MessageStatisticsEnabledId;
 
       ApplicationSystem(EntityManager& em);
       ~ApplicationSystem();
@@ -98,6 +99,24 @@ namespace dtEntity
       ArrayProperty::size_type GetNumCmdLineArgs() const { return  mArgvArray.Size(); }
       std::string GetCmdLineArg(ArrayProperty::size_type i) { return mArgvArray.Get()[i]->StringValue(); }
 
+      /**
+       * Toggle per message type statistics of the entity manager message pump
+       */
+      void SetMessageStatisticsEnabled(bool v);
+      bool GetMessageStatisticsEnabled() const;
+
+      /**
+       * Table of component counts and bytes allocated per entity system,
+       * see EntityManager::GetMemoryStatistics
+       */
+      std::string GetMemoryReport() const;
+
+      /**
+       * Table of dispatch statistics per message type,
+       * see MessagePump::GetStatistics
+       */
+      std::string GetMessageStatisticsReport() const;
+
    private:
 
       /// Holds basic information about the ApplicationSystem instance
@@ -117,6 +136,7 @@ namespace dtEntity
       ArrayProperty mArgvArray;
 
       DynamicFloatProperty mTimeScale;
+      DynamicBoolProperty mMessageStatisticsEnabled;
 
       Property* ScriptGetTimeScale(const PropertyArgs& args)
       {
@@ -140,6 +160,17 @@ namespace dtEntity
 
       Property* ScriptChangeTimeSettings(const PropertyArgs& args);
 
+      // returns group with an entry per message type name
+      Property* ScriptGetMessageStatistics(const PropertyArgs& args);
+      Property* ScriptResetMessageStatistics(const PropertyArgs& args);
+
+      // returns group with an entry per component type name
+      Property* ScriptGetMemoryStatistics(const PropertyArgs& args);
+      Property* ScriptGetMemoryReport(const PropertyArgs& args)
+      {
+         return new StringProperty(GetMemoryReport());
+      }
+
       
       // string holding country code
       //StringProperty mLocale;
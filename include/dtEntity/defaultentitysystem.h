@@ -78,24 +78,32 @@ namespace dtEntity
 #endif
 
    ////////////////////////////////////////////////////////////////////////////////
+   /**
+    * Allocation policies create and destroy components and report
+    * each allocation to the memory statistics of the entity system
+    */
    template<class T>
    struct MemAllocPolicyNew
    {
-      static T* Create()
+      static T* Create(ComponentMemoryStatistics& stats)
       {
-         return new T;
+         T* t = new T;
+         stats.OnAllocate(sizeof(T));
+         return t;
       }
 
-      static void Destroy(T* t)
+      static void Destroy(T* t, ComponentMemoryStatistics& stats)
       {
          delete t;
+         stats.OnDeallocate(sizeof(T));
       }
 
-      static void DestroyAll(ComponentStoreMap<T>& components)
+      static void DestroyAll(ComponentStoreMap<T>& components, ComponentMemoryStatistics& stats)
       {
          for(typename ComponentStoreMap<T>::iterator i = components.begin(); i != components.end(); ++i)
          {
             delete i->second;
+            stats.OnDeallocate(sizeof(T));
          }
       }
 
@@ -109,18 +117,25 @@ namespace dtEntity
    template<class T>
    struct MemAllocPolicyBoostPool
    {
-      static T* Create()
+      static T* Create(ComponentMemoryStatistics& stats)
       {
-         return mComponentPool->construct();
+         T* t = mComponentPool->construct();
+         stats.OnAllocate(sizeof(T));
+         return t;
       }
 
-      static void Destroy(T* t)
+      static void Destroy(T* t, ComponentMemoryStatistics& stats)
       {
          mComponentPool->destroy(t);
+         stats.OnDeallocate(sizeof(T));
       }
 
-      static void DestroyAll(ComponentStoreMap<T>& components)
+      static void DestroyAll(ComponentStoreMap<T>& components, ComponentMemoryStatistics& stats)
       {
+         for(typename ComponentStoreMap<T>::size_type i = 0; i < components.size(); ++i)
+         {
+            stats.OnDeallocate(sizeof(T));
+         }
          delete mComponentPool;
       }
 
@@ -156,7 +171,7 @@ namespace dtEntity
 
       ~DefaultEntitySystem()
       {
-         MemAllocPolicy<T>::DestroyAll(mComponents);
+         MemAllocPolicy<T>::DestroyAll(mComponents, mMemoryStatistics);
       }
 
       virtual ComponentType GetComponentType() const;
@@ -178,6 +193,8 @@ namespace dtEntity
 
       virtual GroupProperty GetComponentProperties() const;
 
+      virtual bool GetMemoryStatistics(ComponentMemoryStatistics& stats) const;
+
       typename ComponentStore::iterator begin();
       typename ComponentStore::const_iterator begin() const;
 
@@ -188,6 +205,7 @@ namespace dtEntity
 
       ComponentStore mComponents;
       ComponentType mComponentType;
+      ComponentMemoryStatistics mMemoryStatistics;
    };
 
 
@@ -267,7 +285,7 @@ namespace dtEntity
          return false;
       }
 
-      T* t = MemAllocPolicy<T>::Create();
+      T* t = MemAllocPolicy<T>::Create(mMemoryStatistics);
 
       if(t == NULL)
       {
@@ -301,7 +319,7 @@ namespace dtEntity
       assert(found);
       component->OnRemovedFromEntity(*e);
       mComponents.erase(i);
-      MemAllocPolicy<T>::Destroy(component);
+      MemAllocPolicy<T>::Destroy(component, mMemoryStatistics);
       return true;
    }
 
@@ -345,6 +363,14 @@ namespace dtEntity
       return mComponents.begin();
    }
 
+   ////////////////////////////////////////////////////////////////////////////////
+   template<typename T, template<class> class MemAllocPolicy>
+      bool DefaultEntitySystem<T, MemAllocPolicy>::GetMemoryStatistics(ComponentMemoryStatistics& stats) const
+   {
+      stats = mMemoryStatistics;
+      return true;
+   }
+
    ////////////////////////////////////////////////////////////////////////////////
    template<typename T, template<class> class MemAllocPolicy>
       typename ComponentStoreMap<T>::iterator DefaultEntitySystem<T, MemAllocPolicy>::end()
@@ -34,6 +34,7 @@ namespace dtEntity
    class Component;
    class Entity;
    class EntitySystem;
+   struct ComponentMemoryStatistics;
    class Message;
 
    /**
@@ -201,6 +202,15 @@ namespace dtEntity
       void GetEntitySystems(std::vector<EntitySystem*>& toFill);
       void GetEntitySystems(std::vector<const EntitySystem*>& toFill) const;
 
+      typedef std::map<ComponentType, ComponentMemoryStatistics> MemoryStatisticsMap;
+
+      /**
+       * Fill map with component counts and bytes allocated of all entity systems
+       * that track their allocations (see EntitySystem::GetMemoryStatistics),
+       * keyed by component type
+       */
+      void GetMemoryStatistics(MemoryStatisticsMap& toFill) const;
+
       /**
        * @param eid Get component of this entity
        * @param t Get component with this component type
@@ -24,6 +24,7 @@
 #include <dtEntity/property.h>
 #include <dtEntity/entityid.h>
 #include <dtEntity/stringid.h>
+#include <cstddef>
 #include <list>
 
 namespace dtEntity
@@ -31,6 +32,51 @@ namespace dtEntity
    class Component;
    class EntityManager;
 
+   /**
+    * Component allocations of an entity system, see EntitySystem::GetMemoryStatistics.
+    * Bytes only count the component objects themselves, not memory the
+    * components allocate on their own, for example OSG nodes
+    */
+   struct ComponentMemoryStatistics
+   {
+      ComponentMemoryStatistics()
+         : mNumComponents(0)
+         , mPeakNumComponents(0)
+         , mNumAllocations(0)
+         , mBytesAllocated(0)
+         , mPeakBytesAllocated(0)
+      {
+      }
+
+      void OnAllocate(std::size_t bytes)
+      {
+         ++mNumComponents;
+         ++mNumAllocations;
+         mBytesAllocated += bytes;
+         if(mNumComponents > mPeakNumComponents)
+         {
+            mPeakNumComponents = mNumComponents;
+         }
+         if(mBytesAllocated > mPeakBytesAllocated)
+         {
+            mPeakBytesAllocated = mBytesAllocated;
+         }
+      }
+
+      void OnDeallocate(std::size_t bytes)
+      {
+         --mNumComponents;
+         mBytesAllocated -= bytes;
+      }
+
+      unsigned int mNumComponents;
+      unsigned int mPeakNumComponents;
+      // total number of allocations since system was created
+      unsigned int mNumAllocations;
+      std::size_t mBytesAllocated;
+      std::size_t mPeakBytesAllocated;
+   };
+
 
    /**
     * Each entity system holds a number of components.
@@ -115,6 +161,12 @@ namespace dtEntity
        */
       virtual GroupProperty GetComponentProperties() const { return GroupProperty(); }
 
+      /**
+       * Override to report component allocations of this system.
+       * @return false if system does not track its allocations
+       */
+      virtual bool GetMemoryStatistics(ComponentMemoryStatistics& stats) const { return false; }
+
 	  /**
 	   * @return entity manager that the entity system was added to
 	   */
@@ -0,0 +1,96 @@
+#pragma once
+
+/* -*-c++-*-
+ * dtEntity Game and Simulation Engine
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation; either version 2.1 of the License, or (at your option)
+ * any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * Martin Scheffler
+ */
+
+#include <dtEntity/export.h>
+#include <dtEntity/systeminterface.h>
+
+namespace dtEntity
+{
+   class MessagePump;
+
+   /**
+    * System interface that does not need a viewer or a window.
+    * Each call to EmitTickMessagesAndQueuedMessages advances the simulation
+    * by a fixed time step, independent of how long the call took. The real
+    * time delta is the time step, the simulation time delta is the time step
+    * multiplied by the time scale. A simulation stepped with the same time step
+    * gets the same tick messages on every run.
+    */
+   class DT_ENTITY_EXPORT HeadlessSystemInterface : public SystemInterface
+   {
+   public:
+
+      HeadlessSystemInterface(MessagePump&);
+      ~HeadlessSystemInterface();
+
+      /** seconds the simulation advances per tick, 1/60 by default */
+      void SetFixedTimeStep(float v) { mFixedTimeStep = v; }
+      float GetFixedTimeStep() const { return mFixedTimeStep; }
+
+      /** number of ticks since construction */
+      unsigned int GetNumTicks() const { return mNumTicks; }
+
+      virtual void EmitTickMessagesAndQueuedMessages();
+
+      virtual float GetDeltaSimTime() const;
+      virtual float GetDeltaRealTime() const;
+
+      virtual float GetTimeScale() const;
+      virtual void SetTimeScale(float v);
+
+      virtual double GetSimulationTime() const;
+      virtual void SetSimulationTime(double);
+
+      /**
+       * Microseconds, starts at 0 and advances with simulation time
+       */
+      virtual Timer_t GetSimulationClockTime() const;
+      virtual void SetSimulationClockTime(Timer_t t);
+
+      virtual Timer_t GetRealClockTime();
+
+      /**
+       * No scene graph to intersect with, always returns false
+       */
+      virtual bool GetIntersections(const Vec3d& start, const Vec3d& end,
+         std::vector<Intersection>& isects,
+         unsigned int nodemask = NodeMasks::PICKABLE | NodeMasks::TERRAIN
+         ) const;
+
+      virtual std::string FindDataFile(const std::string& filename);
+      virtual bool FileExists(const std::string& filename);
+
+   private:
+
+      void EmitTimeChanged();
+
+      MessagePump* mMessagePump;
+      float mFixedTimeStep;
+      float mTimeScale;
+      float mDeltaSimTime;
+      float mDeltaRealTime;
+      double mSimTime;
+      // simulation clock time at simulation time 0
+      Timer_t mClockOffset;
+      unsigned int mNumTicks;
+   };
+}
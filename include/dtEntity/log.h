@@ -25,33 +25,55 @@
 
 #define DT_LOG_SOURCE __FILE__, __FUNCTION__, __LINE__
 
+// Messages are only formatted if their level is enabled, see LogManager::SetLogLevel
+
 #define LOG_DEBUG(msg)\
 {\
-   std::ostringstream os; os << msg; \
-   dtEntity::LogManager::GetInstance().LogMessage(dtEntity::LogLevel::LVL_DEBUG, __FILE__, __FUNCTION__, __LINE__, os.str());\
+   dtEntity::LogManager& logManager_ = dtEntity::LogManager::GetInstance(); \
+   if(logManager_.IsEnabled(dtEntity::LogLevel::LVL_DEBUG)) \
+   { \
+      std::ostringstream os; os << msg; \
+      logManager_.LogMessage(dtEntity::LogLevel::LVL_DEBUG, __FILE__, __FUNCTION__, __LINE__, os.str());\
+   } \
 }\
 
 #define LOG_INFO(msg)\
 {\
-   std::ostringstream os; os << msg; \
-   dtEntity::LogManager::GetInstance().LogMessage(dtEntity::LogLevel::LVL_INFO, __FILE__, __FUNCTION__, __LINE__, os.str());\
+   dtEntity::LogManager& logManager_ = dtEntity::LogManager::GetInstance(); \
+   if(logManager_.IsEnabled(dtEntity::LogLevel::LVL_INFO)) \
+   { \
+      std::ostringstream os; os << msg; \
+      logManager_.LogMessage(dtEntity::LogLevel::LVL_INFO, __FILE__, __FUNCTION__, __LINE__, os.str());\
+   } \
 }\
 
 #define LOG_WARNING(msg)\
 {\
-   std::ostringstream os; os << msg; \
-   dtEntity::LogManager::GetInstance().LogMessage(dtEntity::LogLevel::LVL_WARNING, __FILE__, __FUNCTION__, __LINE__, os.str());\
+   dtEntity::LogManager& logManager_ = dtEntity::LogManager::GetInstance(); \
+   if(logManager_.IsEnabled(dtEntity::LogLevel::LVL_WARNING)) \
+   { \
+      std::ostringstream os; os << msg; \
+      logManager_.LogMessage(dtEntity::LogLevel::LVL_WARNING, __FILE__, __FUNCTION__, __LINE__, os.str());\
+   } \
 }\
 
 #define LOG_ERROR(msg)\
 {\
-   std::ostringstream os; os << msg; \
-   dtEntity::LogManager::GetInstance().LogMessage(dtEntity::LogLevel::LVL_ERROR, __FILE__, __FUNCTION__, __LINE__, os.str());\
+   dtEntity::LogManager& logManager_ = dtEntity::LogManager::GetInstance(); \
+   if(logManager_.IsEnabled(dtEntity::LogLevel::LVL_ERROR)) \
+   { \
+      std::ostringstream os; os << msg; \
+      logManager_.LogMessage(dtEntity::LogLevel::LVL_ERROR, __FILE__, __FUNCTION__, __LINE__, os.str());\
+   } \
 }\
 
 #define LOG_ALWAYS(msg)\
 {\
-   std::ostringstream os; os << msg; \
-   dtEntity::LogManager::GetInstance().LogMessage(dtEntity::LogLevel::LVL_ALWAYS, __FILE__, __FUNCTION__, __LINE__, os.str());\
+   dtEntity::LogManager& logManager_ = dtEntity::LogManager::GetInstance(); \
+   if(logManager_.IsEnabled(dtEntity::LogLevel::LVL_ALWAYS)) \
+   { \
+      std::ostringstream os; os << msg; \
+      logManager_.LogMessage(dtEntity::LogLevel::LVL_ALWAYS, __FILE__, __FUNCTION__, __LINE__, os.str());\
+   } \
 }\
 
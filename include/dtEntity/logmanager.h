@@ -26,6 +26,8 @@
 #include <osg/ref_ptr>
 #include <string>
 #include <vector>
+#include <OpenThreads/Atomic>
+#include <OpenThreads/Condition>
 #include <OpenThreads/Mutex>
 
 namespace dtEntity
@@ -55,6 +57,61 @@ namespace dtEntity
       virtual ~LogListener() { }
    };
 
+   ////////////////////////////////////////////////////////////////////////////////
+   /**
+    * Forwards log messages to another listener from a background thread.
+    * Messages are copied to a ring buffer of fixed size, if it is full
+    * messages are dropped instead of blocking the logging thread.
+    */
+   class DT_ENTITY_EXPORT AsyncLogListener
+         : public LogListener
+   {
+   public:
+
+      AsyncLogListener(LogListener* target, unsigned int capacity = 1024);
+
+      virtual void LogMessage(LogLevel::e level, const std::string& filename, const std::string& methodname, int linenumber,
+                      const std::string& msg);
+
+      /** block until all buffered messages were passed to target */
+      void Flush();
+
+      /** number of messages dropped because ring buffer was full */
+      unsigned int GetNumDropped() const;
+
+   protected:
+      // writes remaining messages, then stops thread
+      ~AsyncLogListener();
+
+   private:
+      class WriterThread;
+      friend class WriterThread;
+
+      struct Record
+      {
+         LogLevel::e mLevel;
+         std::string mFilename;
+         std::string mMethodname;
+         int mLinenumber;
+         std::string mMsg;
+      };
+
+      void Run();
+
+      osg::ref_ptr<LogListener> mTarget;
+      WriterThread* mThread;
+      // records are reused, their strings keep their capacity
+      std::vector<Record> mRecords;
+      unsigned int mFirst;
+      unsigned int mCount;
+      bool mWriting;
+      bool mQuit;
+      unsigned int mNumDropped;
+      unsigned int mNumDroppedReported;
+      mutable OpenThreads::Mutex mMutex;
+      OpenThreads::Condition mCondition;
+   };
+
    ////////////////////////////////////////////////////////////////////////////////
    class DT_ENTITY_EXPORT LogManager
          : public dtEntity::Singleton<LogManager>
@@ -63,9 +120,27 @@ namespace dtEntity
 
       typedef std::vector<osg::ref_ptr<LogListener> > Listeners;
 
+      LogManager();
+      ~LogManager();
+
       void LogMessage(LogLevel::e level, const std::string& filename, const std::string& methodname, int linenumber,
                       const std::string& msg) const;
 
+      /**
+       * Messages less severe than level are discarded by the log macros
+       * before they are formatted. Severity from low to high is
+       * debug, info, warning, error, always. Default is LVL_DEBUG, all
+       * messages are logged
+       */
+      void SetLogLevel(LogLevel::e level);
+      LogLevel::e GetLogLevel() const { return mLogLevel; }
+
+      /**
+       * @return true if a message of given level passes the log level
+       * and there is a listener to receive it
+       */
+      bool IsEnabled(LogLevel::e level) const { return (mEnabledLevels & (1u << level)) != 0; }
+
       void AddListener(LogListener* l);
       void RemoveListener(LogListener* l);
 
@@ -73,7 +148,24 @@ namespace dtEntity
       LogListener* GetListener(Listeners::size_type index) const;
 
    private:
-      Listeners mListeners;
+
+      // call with mMutex locked
+      void SetListeners(Listeners* listeners);
+      void UpdateEnabledLevels();
+
+      LogLevel::e mLogLevel;
+      volatile unsigned int mEnabledLevels;
+
+      // Current listeners, read without locking. A changed list replaces the
+      // pointer, old lists are kept while a log call on another thread may
+      // still be iterating them. They are deleted by the next change that
+      // sees no log call in progress
+      OpenThreads::AtomicPtr mListeners;
+      std::vector<Listeners*> mOldListeners;
+      // number of log calls currently iterating a listener list
+      mutable OpenThreads::Atomic mNumReaders;
+
+      // serializes changes to listeners
       mutable OpenThreads::Mutex mMutex;
    };
 
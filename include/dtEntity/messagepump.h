@@ -78,6 +78,35 @@ namespace dtEntity
       StringId mFuncName;
    };
 
+   /*
+    * Dispatch statistics of a single message type, see MessagePump::SetStatisticsEnabled
+    */
+   struct DT_ENTITY_EXPORT MessageTypeStatistics
+   {
+      MessageTypeStatistics();
+
+      unsigned int mNumEmitted;
+      unsigned int mNumEnqueued;
+      unsigned int mNumSubscribers;
+      // time in seconds spent calling functors, including messages emitted by them
+      double mTotalDispatchTime;
+      double mMaxDispatchTime;
+      // messages of this type currently waiting in the queue
+      unsigned int mQueueDepth;
+      unsigned int mMaxQueueDepth;
+   };
+
+   /*
+    * Time spent in a single subscriber, see MessagePump::SetSubscriberTimingEnabled
+    */
+   struct SubscriberTiming
+   {
+      SubscriberTiming() : mNumCalls(0), mTime(0) {}
+      unsigned int mNumCalls;
+      // seconds, including messages emitted by the subscriber
+      double mTime;
+   };
+
    struct FutureMessageEntry
    {
       double mTimeToPost;
@@ -176,6 +205,44 @@ namespace dtEntity
        */
       void UnregisterAll();
 
+      typedef std::map<MessageType, MessageTypeStatistics> StatisticsMap;
+
+      /**
+       * If enabled, emits, enqueues, dispatch times and queue depths are
+       * counted per message type. When disabled, only a flag is checked.
+       */
+      void SetStatisticsEnabled(bool v) { mStatisticsEnabled = v; }
+      bool GetStatisticsEnabled() const { return mStatisticsEnabled; }
+
+      /**
+       * Get statistics of message type, returns false if no statistics
+       * were collected for it
+       */
+      bool GetStatistics(MessageType msgtype, MessageTypeStatistics& stats) const;
+
+      /** Get statistics of all message types that were sent since last reset */
+      void GetStatistics(StatisticsMap& stats) const;
+
+      void ResetStatistics();
+
+      // subscriber timings by funcname given on registration
+      typedef std::map<StringId, SubscriberTiming> SubscriberTimingMap;
+
+      /**
+       * If enabled, time spent in each subscriber is accumulated until
+       * ResetSubscriberTimings is called. Subscribers without a funcname
+       * are accumulated under the message type name.
+       * Timings are not synchronized, only access them from the thread
+       * that emits the messages.
+       */
+      void SetSubscriberTimingEnabled(bool v) { mSubscriberTimingEnabled = v; }
+      bool GetSubscriberTimingEnabled() const { return mSubscriberTimingEnabled; }
+
+      const SubscriberTimingMap& GetSubscriberTimings() const { return mSubscriberTimings; }
+
+      // set all timings to zero. Entries are kept to avoid reallocating them each frame
+      void ResetSubscriberTimings();
+
    protected:
 
       // Registry for message functors
@@ -190,5 +257,19 @@ namespace dtEntity
       // stores messages until their time to post has come
       std::list<FutureMessageEntry> mFutureMessages;
 
+   private:
+
+      unsigned int GetNumSubscribers(MessageType msgtype) const;
+      void CountEnqueued(MessageType msgtype);
+      void CountDequeued(MessageType msgtype);
+
+      bool mStatisticsEnabled;
+      // messages can be enqueued from other threads
+      mutable OpenThreads::Mutex mStatisticsMutex;
+      StatisticsMap mStatistics;
+
+      bool mSubscriberTimingEnabled;
+      SubscriberTimingMap mSubscriberTimings;
+
    };
 }
@@ -8,14 +8,98 @@
 **
 ** by Greg Hjelstrom & Byon Garrabrant
 **
+** Extended to keep a separate profile tree per thread and a history of per frame times.
+**
 ***************************************************************************************************/
 #include <dtEntity/export.h>
+#include <dtEntity/dtentity_config.h>
 #include <dtEntity/stringid.h>
 #include <dtEntity/systeminterface.h>
+#include <string>
+#include <vector>
+
+// number of frames the min/avg/max frame times are computed over
+#define PROFILE_FRAME_HISTORY 64
+
+#if defined(__GNUC__)
+#define	PROFILE_UNLIKELY( x )	__builtin_expect( !!( x ), 0 )
+#define	PROFILE_RETURN_ADDRESS	__builtin_return_address( 0 )
+#elif defined(_MSC_VER)
+#include <intrin.h>
+#define	PROFILE_UNLIKELY( x )	( x )
+#define	PROFILE_RETURN_ADDRESS	_ReturnAddress()
+#else
+#define	PROFILE_UNLIKELY( x )	( x )
+#define	PROFILE_RETURN_ADDRESS	0
+#endif
+
+/*
+** Categories of instrumentation points, can be combined. All categories are
+** disabled by default, instrumentation points of disabled categories only
+** test a bit
+*/
+namespace ProfileCategory
+{
+	enum e
+	{
+		NONE		= 0,
+		MESSAGES	= 1 << 0,	// dispatch of each message type
+		SYSTEMS	= 1 << 1,	// each message subscriber, usually an entity system
+		SCRIPTS	= 1 << 2,	// script ticks, update functions, script jobs and garbage collection
+		IO			= 1 << 3,	// loading scenes and maps
+		LOOKUPS	= 1 << 4,	// counts of component, entity and string id lookups, not part of ALL
+		ALL		= MESSAGES | SYSTEMS | SCRIPTS | IO
+	};
+}
+
+/*
+** Kinds of lookups counted when ProfileCategory::LOOKUPS is enabled
+*/
+namespace ProfileLookup
+{
+	enum e
+	{
+		GET_COMPONENT,
+		GET_COMPONENT_DERIVED,	// GetComponent with searchDerived set
+		DERIVED_SEARCH_STEP,		// entity system visited while walking the type hierarchy
+		HAS_COMPONENT,
+		GET_ENTITY,
+		SID,
+		NUM_KINDS
+	};
+}
+
+/*
+** Number of lookups of one kind and component type, made while the calling
+** thread was in the profile scope Caller. Enable ProfileCategory::SYSTEMS
+** to get the message subscriber as caller
+*/
+struct CProfileLookupCount
+{
+	ProfileLookup::e		Kind;
+	dtEntity::StringId	ComponentType;
+	dtEntity::StringId	Caller;
+	unsigned int			Count;
+};
+
+/*
+** Number of sampled lookups made from one call site
+*/
+struct CProfileLookupSample
+{
+	ProfileLookup::e		Kind;
+	dtEntity::StringId	ComponentType;
+	dtEntity::StringId	Caller;
+	const void *			CallSite;
+	unsigned int			Count;
+};
+
+class CProfileThread;
+
 /*
 ** A node in the Profile Hierarchy Tree
 */
-class	CProfileNode {
+class	DT_ENTITY_EXPORT CProfileNode {
 
 public:
 	CProfileNode( dtEntity::StringId name, CProfileNode * parent );
@@ -31,27 +115,41 @@ public:
 	void				Call( void );
 	bool				Return( void );
 
+	// store time of current frame in history, recurses into children and siblings
+	void				End_Frame( void );
+
 	const dtEntity::StringId	Get_Name( void )				{ return Name; }
 	int				Get_Total_Calls( void )		{ return TotalCalls; }
 	float				Get_Total_Time( void )		{ return TotalTime; }
 
+	// statistics over the last PROFILE_FRAME_HISTORY frames, in seconds
+	float				Get_Min_Frame_Time( void );
+	float				Get_Avg_Frame_Time( void );
+	float				Get_Max_Frame_Time( void );
+
 protected:
 
    dtEntity::StringId Name;
    int				    TotalCalls;
    float				    TotalTime;
+   float				    FrameTime;
    dtEntity::Timer_t  StartTime;
    int				    RecursionCounter;
 
+   float				    FrameHistory[PROFILE_FRAME_HISTORY];
+   int				    FrameHistoryCount;
+   int				    FrameHistoryIndex;
+
    CProfileNode *	    Parent;
    CProfileNode *	    Child;
    CProfileNode *	    Sibling;
+   CProfileNode *	    LastSubNode;	// sub node found by last Get_Sub_Node call
 };
 
 /*
 ** An iterator to navigate through the tree
 */
-class CProfileIterator
+class DT_ENTITY_EXPORT CProfileIterator
 {
 public:
 	// Access all the children of the current parent
@@ -68,45 +166,124 @@ public:
 	dtEntity::StringId	Get_Current_Name( void )			{ return CurrentChild->Get_Name(); }
 	int				Get_Current_Total_Calls( void )	{ return CurrentChild->Get_Total_Calls(); }
 	float				Get_Current_Total_Time( void )	{ return CurrentChild->Get_Total_Time(); }
+	float				Get_Current_Min_Frame_Time( void )	{ return CurrentChild->Get_Min_Frame_Time(); }
+	float				Get_Current_Avg_Frame_Time( void )	{ return CurrentChild->Get_Avg_Frame_Time(); }
+	float				Get_Current_Max_Frame_Time( void )	{ return CurrentChild->Get_Max_Frame_Time(); }
 
 	// Access the current parent
 	const dtEntity::StringId	Get_Current_Parent_Name( void )			{ return CurrentParent->Get_Name(); }
 	int				Get_Current_Parent_Total_Calls( void )	{ return CurrentParent->Get_Total_Calls(); }
 	float				Get_Current_Parent_Total_Time( void )	{ return CurrentParent->Get_Total_Time(); }
 
+	// Access the thread the tree belongs to
+	const std::string&	Get_Thread_Name( void );
+	int				Get_Frame_Count_Since_Reset( void );
+
 protected:
 
+	CProfileThread *	Thread;
 	CProfileNode *	CurrentParent;
 	CProfileNode *	CurrentChild;
 
-	CProfileIterator( CProfileNode * start );
+	CProfileIterator( CProfileThread * thread );
 	friend	class		CProfileManager;
 };
 
 
+/*
+** Additional section of the profile report, for example timings
+** collected by a script engine profiler. Printed by dumpAll after
+** the profile tree
+*/
+class CProfileReportSection
+{
+public:
+	virtual ~CProfileReportSection( void ) {}
+	virtual void		Dump( void ) = 0;
+};
+
+
 /*
 ** The Manager for the Profile system
+**
+** Each thread records samples into its own tree, so Start_Profile and Stop_Profile
+** take no locks and can be called from any thread. Frames are counted per thread,
+** each thread that wants min/avg/max frame times calls Increment_Frame_Counter
+** at the start of its frames. Reports read the trees of other threads without
+** synchronization, values of a thread that is running may be one sample off.
 */
 class	DT_ENTITY_EXPORT CProfileManager {
 public:
 	static	void						Start_Profile( dtEntity::StringId name );
 	static	void						Stop_Profile( void );
 
+	// Reset the trees of all threads. Other threads reset their tree the next time
+	// they start a profile on top level
 	static	void						Reset( void );
 	static	void						Increment_Frame_Counter( void );
-	static	int						Get_Frame_Count_Since_Reset( void )		{ return FrameCounter; }
+	static	int						Get_Frame_Count_Since_Reset( void );
 	static	float						Get_Time_Since_Reset( void );
 
-	static	CProfileIterator *	Get_Iterator( void )	{ return new CProfileIterator( &Root ); }
+	// Name of calling thread in reports
+	static	void						Set_Thread_Name( const std::string& name );
+
+	// Threads that have recorded samples
+	static	int						Get_Number_Of_Threads( void );
+
+	// Iterator for tree of calling thread
+	static	CProfileIterator *	Get_Iterator( void );
+	// Iterator for tree of given thread
+	static	CProfileIterator *	Get_Iterator( int thread );
 	static	void						Release_Iterator( CProfileIterator * iterator ) { delete iterator; }
 
    static void	dumpRecursive(CProfileIterator* profileIterator, int spacing);
    static void	dumpAll();
+
+	// Enable instrumentation points of given ProfileCategory bits at runtime
+	static	void						Set_Enabled_Categories( unsigned int categories );
+	static	unsigned int			Get_Enabled_Categories( void )				{ return EnabledCategories; }
+	static	bool						Is_Enabled( unsigned int categories )		{ return PROFILE_UNLIKELY( ( EnabledCategories & categories ) != 0 ); }
+
+	// Parse a comma separated list of category names: messages, systems, scripts, io, lookups, all.
+	// Lookups are counted on every component access, so they are only enabled when named,
+	// all does not include them. Returns false if a name is unknown
+	static	bool						Parse_Categories( const std::string& str, unsigned int& categories );
+
+	// Enable categories given as --profile <categories> on command line, returns true if found
+	static	bool						Setup_From_Command_Line( int argc, char** argv );
+
+	// Count a lookup in the current scope of the calling thread, use PROFILE_LOOKUP
+	static	void						Count_Lookup( ProfileLookup::e kind, dtEntity::StringId componentType, const void * callSite );
+	// Every interval-th lookup of a thread records its call site, 64 by default
+	static	void						Set_Lookup_Sample_Interval( unsigned int interval );
+	// Lookup counts and samples summed over all threads, sorted by count. Counts are
+	// read while other threads write them and may be slightly behind
+	static	void						Get_Lookup_Counts( std::vector<CProfileLookupCount>& toFill );
+	// Number of lookups of each ProfileLookup kind summed over all threads, including
+	// lookups of scopes that did not fit into the per thread count table
+	static	void						Get_Lookup_Totals( unsigned int totals[ProfileLookup::NUM_KINDS] );
+	static	void						Get_Lookup_Samples( std::vector<CProfileLookupSample>& toFill );
+	static	void						dumpLookups();
+
+	static	void						Add_Report_Section( CProfileReportSection * section );
+	static	void						Remove_Report_Section( CProfileReportSection * section );
+
+	// Start recording each profile scope with its start time and duration. Each thread
+	// keeps the last maxEvents scopes in a ring buffer, older ones are overwritten.
+	// Ignored while a capture is running
+	static	void						Start_Capture( unsigned int maxEvents = 65536 );
+	static	void						Stop_Capture( void );
+	static	bool						Is_Capturing( void );
+
+	// Write recorded scopes of all threads as Chrome Trace Event JSON, can be opened
+	// in chrome://tracing or Perfetto. Returns false if capture was not stopped
+	static	bool						Write_Capture( const std::string& path );
 private:
-   static	CProfileNode Root;
-   static	CProfileNode* CurrentNode;
-   static	int FrameCounter;
+	static	CProfileThread *		Get_Current_Thread( void );
+
+   static	std::vector<CProfileReportSection*> ReportSections;
    static	dtEntity::Timer_t ResetTime;
+   static	volatile unsigned int EnabledCategories;
 };
 
 
@@ -117,21 +294,64 @@ private:
 class	CProfileSample {
 public:
 	CProfileSample( dtEntity::StringId name )
-	{ 
-		CProfileManager::Start_Profile( name ); 
+	{
+		CProfileManager::Start_Profile( name );
 	}
-	
-	~CProfileSample( void )					
-	{ 
-		CProfileManager::Stop_Profile(); 
+
+	~CProfileSample( void )
+	{
+		CProfileManager::Stop_Profile();
 	}
 };
 
-#ifdef _DEBUG
-#define	PROFILE( name )			CProfileSample __profile( name )
+/*
+** Profiles a scope only if its category was enabled when the scope was entered
+*/
+class	CProfileCategorySample {
+public:
+	CProfileCategorySample( unsigned int category, dtEntity::StringId name )
+		: Active( CProfileManager::Is_Enabled( category ) )
+	{
+		if ( Active ) {
+			CProfileManager::Start_Profile( name );
+		}
+	}
+
+	~CProfileCategorySample( void )
+	{
+		if ( Active ) {
+			CProfileManager::Stop_Profile();
+		}
+	}
+
+private:
+	bool Active;
+};
+
+#define	PROFILE_CONCAT_IMPL( a, b )	a##b
+#define	PROFILE_CONCAT( a, b )			PROFILE_CONCAT_IMPL( a, b )
+
+#if DTENTITY_PROFILING_ENABLED
+// profile scope with a string id
+#define	PROFILE( name )			CProfileSample PROFILE_CONCAT( __profile, __LINE__ )( name )
+// profile scope with a string literal, string id is only computed once
+#define	PROFILE_SCOPE( name )	static const dtEntity::StringId PROFILE_CONCAT( __profileId, __LINE__ ) = dtEntity::SID( name ); \
+										CProfileSample PROFILE_CONCAT( __profile, __LINE__ )( PROFILE_CONCAT( __profileId, __LINE__ ) )
+// same as above, but only if given ProfileCategory is enabled at runtime
+#define	PROFILE_CATEGORY( category, name )			CProfileCategorySample PROFILE_CONCAT( __profile, __LINE__ )( category, name )
+#define	PROFILE_CATEGORY_SCOPE( category, name )	static const dtEntity::StringId PROFILE_CONCAT( __profileId, __LINE__ ) = dtEntity::SID( name ); \
+										CProfileCategorySample PROFILE_CONCAT( __profile, __LINE__ )( category, PROFILE_CONCAT( __profileId, __LINE__ ) )
 #else
 #define	PROFILE( name )
+#define	PROFILE_SCOPE( name )
+#define	PROFILE_CATEGORY( category, name )
+#define	PROFILE_CATEGORY_SCOPE( category, name )
 #endif
 
-
-
+// count a lookup of given ProfileLookup kind if lookups are profiled
+#if DTENTITY_PROFILING_ENABLED
+#define	PROFILE_LOOKUP( kind, componentType )	do { if ( CProfileManager::Is_Enabled( ProfileCategory::LOOKUPS ) ) { \
+										CProfileManager::Count_Lookup( kind, componentType, PROFILE_RETURN_ADDRESS ); } } while ( 0 )
+#else
+#define	PROFILE_LOOKUP( kind, componentType )
+#endif
@@ -24,6 +24,12 @@
 #include <dtEntity/entitymanager.h>
 #include <dtEntity/mapencoder.h>
 #include <iostream>
+#include <map>
+
+namespace dtProtoBuf
+{
+   class Message;
+}
 
 namespace dtEntity
 {
@@ -67,5 +73,45 @@ namespace dtEntity
       MapSystem* mMapSystem;
 
    };
+
+   ////////////////////////////////////////////////////////////////////////////////
+   /**
+    * Decodes messages encoded with ProtoBufMapEncoder::EncodeMessage directly
+    * from a byte buffer, without copying it to a stream first.
+    * One message object is kept per message type and reused for the next
+    * message of that type, so the returned message is only valid until
+    * the next call to Decode. Do not delete it.
+    */
+   class DT_ENTITY_EXPORT ProtoBufMessageDecoder
+   {
+   public:
+
+      ProtoBufMessageDecoder();
+      ~ProtoBufMessageDecoder();
+
+      /**
+       * Decode message from data. Returns NULL if data could not be parsed
+       * or message type is not registered with the message factory.
+       */
+      Message* Decode(const void* data, unsigned int size);
+
+   private:
+
+      // not copyable
+      ProtoBufMessageDecoder(const ProtoBufMessageDecoder&);
+      ProtoBufMessageDecoder& operator=(const ProtoBufMessageDecoder&);
+
+      // parse buffer, reused to keep its allocated memory
+      dtProtoBuf::Message* mParsed;
+
+      // reused message and a default constructed copy to reset it from
+      struct PooledMessage
+      {
+         Message* mMessage;
+         Message* mDefaults;
+      };
+      typedef std::map<MessageType, PooledMessage> MessagePool;
+      MessagePool mMessagePool;
+   };
 }
 
@@ -91,6 +91,13 @@ namespace dtEntity
        */
       virtual Timer_t GetRealClockTime() = 0;
 
+      /**
+       * Seconds left in the current frame before the frame budget is used up.
+       * Systems can use this to schedule work that can be deferred.
+       * Returns a negative value if the frame budget is not known.
+       */
+      virtual double GetFrameTimeLeft() const { return -1; }
+
       /**
        * Holds intersection info
        */
@@ -478,6 +478,70 @@ namespace dtEntity
       BoolProperty mIsNull;
    };
 
+   ////////////////////////////////////////////////////////////////////////////////
+   /**
+    * Sent by the frame budget monitor of the system interface when a frame
+    * took longer than the frame budget. Times are in seconds.
+    * SlowestSubscribers is an array of groups with entries
+    * Name (funcname of message subscriber) and Time, slowest first
+    */
+   class DT_ENTITY_EXPORT FrameHitchMessage
+      : public Message
+   {
+   public:
+
+      static const MessageType TYPE;
+      static const StringId FrameTimeId;
+      static const StringId FrameBudgetId;
+      static const StringId PostFrameTimeId;
+      static const StringId TickTimeId;
+      static const StringId QueuedMessagesTimeId;
+      static const StringId EndOfFrameTimeId;
+      static const StringId RenderTimeId;
+      static const StringId SlowestSubscribersId;
+      static const StringId NameId;
+      static const StringId TimeId;
+
+      FrameHitchMessage();
+
+      virtual Message* Clone() const { return CloneContainer<FrameHitchMessage>(); }
+
+      double GetFrameTime() const { return mFrameTime.Get(); }
+      void SetFrameTime(double v) { mFrameTime.Set(v); }
+
+      double GetFrameBudget() const { return mFrameBudget.Get(); }
+      void SetFrameBudget(double v) { mFrameBudget.Set(v); }
+
+      double GetPostFrameTime() const { return mPostFrameTime.Get(); }
+      void SetPostFrameTime(double v) { mPostFrameTime.Set(v); }
+
+      double GetTickTime() const { return mTickTime.Get(); }
+      void SetTickTime(double v) { mTickTime.Set(v); }
+
+      double GetQueuedMessagesTime() const { return mQueuedMessagesTime.Get(); }
+      void SetQueuedMessagesTime(double v) { mQueuedMessagesTime.Set(v); }
+
+      double GetEndOfFrameTime() const { return mEndOfFrameTime.Get(); }
+      void SetEndOfFrameTime(double v) { mEndOfFrameTime.Set(v); }
+
+      double GetRenderTime() const { return mRenderTime.Get(); }
+      void SetRenderTime(double v) { mRenderTime.Set(v); }
+
+      PropertyArray GetSlowestSubscribers() const { return mSlowestSubscribers.Get(); }
+      void SetSlowestSubscribers(const PropertyArray& v) { mSlowestSubscribers.Set(v); }
+
+   private:
+
+      DoubleProperty mFrameTime;
+      DoubleProperty mFrameBudget;
+      DoubleProperty mPostFrameTime;
+      DoubleProperty mTickTime;
+      DoubleProperty mQueuedMessagesTime;
+      DoubleProperty mEndOfFrameTime;
+      DoubleProperty mRenderTime;
+      ArrayProperty mSlowestSubscribers;
+   };
+
    ////////////////////////////////////////////////////////////////////////////////
    /**
     * Gets sent before a map is loaded
@@ -112,6 +112,16 @@ namespace dtEntityEditor
 
       void SaveScene(const QString& path);
 
+      /**
+       * Create memory report of entity systems, sent back with MemoryReportCreated
+       */
+      void CreateMemoryReport();
+
+      /**
+       * Create table of message pump statistics, sent back with MessageStatisticsReportCreated
+       */
+      void CreateMessageStatisticsReport();
+
       void ViewResized(const QSize& size);
 
       void InitializeScripting();
@@ -129,6 +139,8 @@ namespace dtEntityEditor
    signals: 
       
       void ErrorOccurred(const QString&);
+      void MemoryReportCreated(const QString& report);
+      void MessageStatisticsReportCreated(const QString& report);
       void SceneLoaded(const QString& path);
       void DataPathsChanged(const QStringList& paths);
 
@@ -85,6 +85,9 @@ namespace dtEntityEditor
 
       void SaveScene(const QString& path);
 
+      void RequestMemoryReport();
+      void RequestMessageStatisticsReport();
+
       void TextDroppedOntoGLWidget(const QPointF& pos, const QString&);
 
       void MapLoaded(const QString& map);
@@ -93,6 +96,8 @@ namespace dtEntityEditor
    public slots:
 
       void OnDisplayError(const QString& msg);
+      void OnMemoryReport(const QString& report);
+      void OnMessageStatisticsReport(const QString& report);
       void SetOSGWindow(dtEntityQtWidgets::OSGGraphicsWindowQt*);
 
       void OnViewResized(const QSize& size);
@@ -121,6 +126,8 @@ namespace dtEntityEditor
       void OnSaveScene();
       void OnSaveSceneAs();
       void OnAddPlugin();
+      void OnShowMemoryReport();
+      void OnShowMessageStatisticsReport();
       void EmitQueuedMessages();
 
    protected:
@@ -149,6 +156,8 @@ namespace dtEntityEditor
       QAction* mSaveSceneAct;
       QAction* mSaveSceneAsAct;
       QAction* mAddPluginAct;
+      QAction* mMemoryReportAct;
+      QAction* mMessageStatisticsAct;
       QAction* mExitAct;
 
       // line edit for jump line in tool box
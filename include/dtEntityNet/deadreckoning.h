@@ -26,39 +26,229 @@
 #include <osg/Vec3d>
 #include <osg/Quat>
 #include <string>
+#include <vector>
 
 namespace dtEntityNet
 {
 
    ////////////////////////////////////////////////////////////////////////////////
+   /**
+    * Dead reckoning algorithms as defined by the DIS standard (IEEE 1278.1).
+    * Numbering follows the standard so values can be sent over the wire.
+    * F/R: Fixed orientation or Rotating with angular velocity
+    * P/V: constant velocity (Position) or Velocity changed by acceleration
+    * W/B: linear velocity and acceleration given in World or Body coordinates
+    */
    namespace DeadReckoningAlgorithm
    {
       enum e
       {
         DISABLED = 0,
         STATIC = 1,
-        FPW = 2/*, NOT YET IMPLEMENTED!
-        FPB,
-        FVW,
-        FVB,
-        RPW,
-        RPB,
-        RVW,
-        RVB*/
+        FPW = 2,
+        RPW = 3,
+        RVW = 4,
+        FVW = 5,
+        FPB = 6,
+        RPB = 7,
+        RVB = 8,
+        FVB = 9
       };
 
       e fromString(const std::string& v);
       std::string toString(e v);
+
+      // true if orientation changes with angular velocity
+      bool IsRotating(e v);
+
+      // true if velocity changes with acceleration
+      bool UsesAcceleration(e v);
+
+      // true if velocity and acceleration are given in body coordinates
+      bool IsBodyCoordinates(e v);
    }
 
-   void CalculateDRFPW(const osg::Vec3d& lastpos,
-                       const osg::Vec3f& lastrot,
+   ////////////////////////////////////////////////////////////////////////////////
+   /**
+    * Methods to converge from the displayed state of a remote entity to the
+    * dead reckoned state after a new update was received.
+    * NONE: Snap to new state
+    * PVB: Projective velocity blending, blend velocity from displayed to received
+    *      velocity and interpolate between projected old and new positions
+    * BEZIER: Cubic bezier curve from displayed position to dead reckoned
+    *         position at end of convergence time
+    */
+   namespace ConvergenceMethod
+   {
+      enum e
+      {
+         NONE = 0,
+         PVB = 1,
+         BEZIER = 2
+      };
+
+      e fromString(const std::string& v);
+      std::string toString(e v);
+   }
+
+   /**
+    * Extrapolate position and orientation.
+    * Angular velocity is given as rotation axis scaled by rotation rate in rad/s,
+    * it is applied in world coordinates after the last orientation.
+    * Velocity and acceleration are interpreted in world or body coordinates
+    * depending on the algorithm.
+    */
+   DTENTITY_NET_EXPORT void CalculateDeadReckoning(DeadReckoningAlgorithm::e alg,
+                       const osg::Vec3d& lastpos,
+                       const osg::Quat& lastrot,
                        const osg::Vec3f& lastvel,
+                       const osg::Vec3f& lastacc,
                        const osg::Vec3f& lastangularvel,
                        float timeSinceLastData,
                        osg::Vec3d& newpos,
-                       osg::Vec3f& newrot);
+                       osg::Quat& newrot);
+
+   /**
+    * Projective velocity blending.
+    * @param startpos Displayed position when update was received
+    * @param startvel Displayed velocity when update was received
+    * @param newvel Received velocity in world coordinates
+    * @param newacc Received acceleration in world coordinates
+    * @param extrapolated Dead reckoned position of received state at time t
+    * @param t Time since update was received
+    * @param blendtime Convergence time
+    */
+   DTENTITY_NET_EXPORT osg::Vec3d ProjectiveVelocityBlend(const osg::Vec3d& startpos,
+                       const osg::Vec3d& startvel,
+                       const osg::Vec3d& newvel,
+                       const osg::Vec3d& newacc,
+                       const osg::Vec3d& extrapolated,
+                       double t,
+                       double blendtime);
+
+   /**
+    * Cubic bezier blend from displayed position and velocity to dead reckoned position
+    * and velocity at end of convergence time.
+    */
+   DTENTITY_NET_EXPORT osg::Vec3d BezierBlend(const osg::Vec3d& startpos,
+                       const osg::Vec3d& startvel,
+                       const osg::Vec3d& endpos,
+                       const osg::Vec3d& endvel,
+                       double t,
+                       double blendtime);
+
+   /**
+    * Conversion between rotation-per-second quaternion (as stored in DynamicsComponent)
+    * and angular velocity vector (axis scaled by rate in rad/s)
+    */
+   DTENTITY_NET_EXPORT osg::Vec3f AngularVelocityFromQuat(const osg::Quat& q);
+   DTENTITY_NET_EXPORT osg::Quat AngularVelocityToQuat(const osg::Vec3f& v);
 
    osg::Vec3f QuatToEuler(const osg::Quat& q);
    osg::Quat EulerToQuat(const osg::Vec3f& euler);
+
+   ////////////////////////////////////////////////////////////////////////////////
+   /**
+    * Extrapolates a large number of dead reckoned states in one pass.
+    * States are held as structure of arrays so that the linear part of
+    * the extrapolation runs as tight loops over contiguous memory that the compiler
+    * can vectorize. Rotating entities are handled in a second pass over
+    * the subset of slots that need it.
+    * Slots are stable until removed. Removing a slot moves the last slot into
+    * its place, caller has to update the index of the moved owner.
+    */
+   class DTENTITY_NET_EXPORT DeadReckoningBatch
+   {
+   public:
+
+      DeadReckoningBatch();
+
+      /**
+       * Add a new slot with algorithm DISABLED
+       * @return index of new slot
+       */
+      unsigned int Add();
+
+      /**
+       * Remove slot. Last slot is moved to index idx.
+       * @return true if a slot was moved into idx
+       */
+      bool Remove(unsigned int idx);
+
+      unsigned int Size() const { return mTime.size(); }
+
+      void Clear();
+
+      /**
+       * Set state of slot at time simtime. Body velocity and acceleration
+       * are transformed to world coordinates once here, not on every extrapolation
+       */
+      void Set(unsigned int idx,
+               DeadReckoningAlgorithm::e alg,
+               double simtime,
+               const osg::Vec3d& pos,
+               const osg::Quat& rot,
+               const osg::Vec3f& vel,
+               const osg::Vec3f& acc,
+               const osg::Vec3f& angularvel);
+
+      DeadReckoningAlgorithm::e GetAlgorithm(unsigned int idx) const
+      {
+         return static_cast<DeadReckoningAlgorithm::e>(mAlgorithm[idx]);
+      }
+
+      /**
+       * Calculate extrapolated states of all slots for given simulation time
+       */
+      void Extrapolate(double simtime);
+
+      /**
+       * Results of last call to Extrapolate
+       */
+      osg::Vec3d GetPosition(unsigned int idx) const
+      {
+         return osg::Vec3d(mOutPos[0][idx], mOutPos[1][idx], mOutPos[2][idx]);
+      }
+
+      osg::Quat GetOrientation(unsigned int idx) const
+      {
+         return osg::Quat(mOutRot[0][idx], mOutRot[1][idx], mOutRot[2][idx], mOutRot[3][idx]);
+      }
+
+      /**
+       * Velocity and acceleration of slot in world coordinates as given to Set
+       */
+      osg::Vec3d GetVelocity(unsigned int idx) const
+      {
+         return osg::Vec3d(mVel[0][idx], mVel[1][idx], mVel[2][idx]);
+      }
+
+      osg::Vec3d GetAcceleration(unsigned int idx) const
+      {
+         return osg::Vec3d(mAcc[0][idx], mAcc[1][idx], mAcc[2][idx]);
+      }
+
+   private:
+
+      void UpdateRotatingList();
+
+      typedef std::vector<double> Array;
+
+      std::vector<unsigned int> mAlgorithm;
+      Array mTime;
+      Array mPos[3];
+      Array mRot[4];
+      // velocity and acceleration, in world coordinates
+      Array mVel[3];
+      Array mAcc[3];
+      // angular velocity, world coordinates
+      Array mAngVel[3];
+
+      Array mOutPos[3];
+      Array mOutRot[4];
+
+      // indices of slots with rotating algorithms
+      std::vector<unsigned int> mRotating;
+      bool mRotatingDirty;
+   };
 }
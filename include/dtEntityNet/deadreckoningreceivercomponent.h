@@ -23,6 +23,7 @@
 
 #include <dtEntity/component.h>
 #include <dtEntity/defaultentitysystem.h>
+#include <dtEntity/dynamicproperty.h>
 #include <dtEntity/messagepump.h>
 #include <dtEntity/scriptaccessor.h>
 #include <dtEntityNet/deadreckoning.h>
@@ -69,12 +70,27 @@ namespace dtEntityNet
       dtEntity::DynamicsComponent* mDynamicsComponent;
       double mTimeLastReceive;
       dtEntity::Vec3d mPosition;
-      dtEntity::Vec3f mOrientation;
+      dtEntity::Quat mOrientation;
       dtEntity::Vec3f mVelocity;
+      dtEntity::Vec3f mAcceleration;
       dtEntity::Vec3f mAngularVelocity;
       std::string mEntityType;
       dtEntity::StringProperty mUniqueId;
       DeadReckoningAlgorithm::e mDeadRecAlg;
+
+      // index of slot in dead reckoning batch of receiver system
+      unsigned int mBatchIndex;
+
+      // convergence state, set when an update arrives for an entity that is already displayed
+      bool mIsBlending;
+      dtEntity::Vec3d mBlendStartPosition;
+      dtEntity::Vec3d mBlendStartVelocity;
+      dtEntity::Quat mBlendStartOrientation;
+      dtEntity::Vec3d mBlendEndPosition;
+      dtEntity::Vec3d mBlendEndVelocity;
+
+      // velocity of entity as displayed, estimated from last tick
+      dtEntity::Vec3d mDisplayedVelocity;
    };
 
    ////////////////////////////////////////////////////////////////////////////////
@@ -88,6 +104,8 @@ namespace dtEntityNet
 
       static const dtEntity::ComponentType TYPE;
       static const dtEntity::StringId SpawnFromEntityTypeId;
+      static const dtEntity::StringId ConvergenceMethodId;
+      static const dtEntity::StringId ConvergenceTimeId;
 
       DeadReckoningReceiverSystem(dtEntity::EntityManager& em);
       ~DeadReckoningReceiverSystem();
@@ -95,6 +113,8 @@ namespace dtEntityNet
       void OnAddedToEntityManager(dtEntity::EntityManager&);
       void OnRemovedFromEntityManager(dtEntity::EntityManager&);
 
+      virtual bool DeleteComponent(dtEntity::EntityId eid);
+
       void OnUpdateTransform(const dtEntity::Message& msg);
       void OnJoin(const dtEntity::Message& msg);
       void OnResign(const dtEntity::Message& msg);
@@ -109,14 +129,45 @@ namespace dtEntityNet
       void SetSpawnFromEntityType(bool v) { mSpawnFromEntityType.Set(v); }
       bool GetSpawnFromEntityType() const { return mSpawnFromEntityType.Get(); }
 
+      /**
+       * How to converge from displayed state to dead reckoned state
+       * when an update is received. Default is PVB.
+       */
+      void SetConvergenceMethod(ConvergenceMethod::e v) { mConvergence = v; }
+      ConvergenceMethod::e GetConvergenceMethod() const { return mConvergence; }
+
+      void SetConvergenceMethodString(const std::string& v);
+      std::string GetConvergenceMethodString() const;
+
+      /**
+       * Time in seconds to converge to dead reckoned state. A longer time gives
+       * smoother movement and allows senders to use larger deviation thresholds.
+       */
+      void SetConvergenceTime(float v) { mConvergenceTime.Set(v); }
+      float GetConvergenceTime() const { return mConvergenceTime.Get(); }
+
    private:
 
       dtEntity::Property* ScriptConnect(const dtEntity::PropertyArgs& args);
       void Tick(const dtEntity::Message& m);
 
+      void ReleaseBatchSlot(DeadReckoningReceiverComponent* comp);
+
+      // extrapolation state of all components that received a transform
+      DeadReckoningBatch mBatch;
+
+      // maps batch slot index to component
+      std::vector<DeadReckoningReceiverComponent*> mSlotOwners;
+
       dtEntity::MapSystem* mMapSystem;
       dtEntity::MessageFunctor mTickFunctor;
       dtEntity::BoolProperty mSpawnFromEntityType;
+      dtEntity::DynamicStringProperty mConvergenceMethod;
+      ConvergenceMethod::e mConvergence;
+      dtEntity::FloatProperty mConvergenceTime;
+
+      // simulation time of current tick
+      double mSimulationTime;
 
    };
 }
@@ -49,6 +49,7 @@ namespace dtEntityNet
    public:
       static const dtEntity::ComponentType TYPE;
       static const dtEntity::StringId DeadReckoningAlgorithmId;
+      static const dtEntity::StringId PriorityId;
 
       DeadReckoningSenderComponent();
 
@@ -75,6 +76,13 @@ namespace dtEntityNet
 
       bool IsInScene() const { return mIsInScene; }
 
+      /**
+       * Weight of this entity when updates compete for bandwidth.
+       * Use higher values for important entity classes. Default is 1.
+       */
+      void SetPriority(float v) { mPriority.Set(v); }
+      float GetPriority() const { return mPriority.Get(); }
+
    private:
       dtEntity::DynamicStringProperty mDeadReckoningAlgorithm;
       DeadReckoningAlgorithm::e mDeadReck;
@@ -82,13 +90,18 @@ namespace dtEntityNet
       dtEntity::DynamicsComponent* mDynamicsComponent;
       double mTimeLastSend;
       osg::Vec3d mLastPosition;
-      osg::Vec3 mLastOrientation;
+      osg::Quat mLastOrientation;
+      // velocity and acceleration in coordinate frame of dead reckoning algorithm
       osg::Vec3 mLastVelocity;
+      osg::Vec3 mLastAcceleration;
       osg::Vec3 mLastAngularVelocity;
       std::string mEntityType;
       std::string mUniqueId;
       bool mIsInScene;
+      dtEntity::FloatProperty mPriority;
 
+      // grows each tick an update is due but not sent, reset on send
+      float mAccumulatedPriority;
    };
 
    ////////////////////////////////////////////////////////////////////////////////
@@ -104,6 +117,9 @@ namespace dtEntityNet
       static const dtEntity::StringId MaxUpdateIntervalId;
       static const dtEntity::StringId MaxPositionDeviationId;
       static const dtEntity::StringId MaxOrientationDeviationId;
+      static const dtEntity::StringId BandwidthBudgetId;
+      static const dtEntity::StringId MaxUpdatesPerTickId;
+      static const dtEntity::StringId PriorityDistanceId;
 
       DeadReckoningSenderSystem(dtEntity::EntityManager& em);
       ~DeadReckoningSenderSystem();
@@ -122,6 +138,37 @@ namespace dtEntityNet
       float GetMaxOrientationDeviation() const { return mMaxOrientationDeviation.Get(); }
       void SetMaxOrientationDeviation(float v) { mMaxOrientationDeviation.Set(v); }
 
+      /**
+       * Maximum number of bytes per second used for transform updates.
+       * When more updates are due than fit into the budget then the entities
+       * with highest accumulated priority are sent first.
+       * A budget smaller than one update message still sends one update
+       * whenever a message size worth of budget has accumulated.
+       * 0 means unlimited (default)
+       */
+      float GetBandwidthBudget() const { return mBandwidthBudget.Get(); }
+      void SetBandwidthBudget(float v) { mBandwidthBudget.Set(v); }
+
+      /**
+       * Maximum number of transform updates sent per tick. 0 means unlimited (default)
+       */
+      unsigned int GetMaxUpdatesPerTick() const { return mMaxUpdatesPerTick.Get(); }
+      void SetMaxUpdatesPerTick(unsigned int v) { mMaxUpdatesPerTick.Set(v); }
+
+      /**
+       * Distance to nearest observer at which priority of an entity is halved
+       */
+      float GetPriorityDistance() const { return mPriorityDistance.Get(); }
+      void SetPriorityDistance(float v) { mPriorityDistance.Set(v); }
+
+      /**
+       * Positions of observers (for example the avatars of connected clients).
+       * Entities close to an observer get a higher send priority.
+       * If no observers are set then distance is not considered.
+       */
+      void SetObserverPositions(const std::vector<osg::Vec3d>& v) { mObserverPositions = v; }
+      const std::vector<osg::Vec3d>& GetObserverPositions() const { return mObserverPositions; }
+
       dtEntity::MessagePump& GetOutgoingMessagePump() { return mOutgoing; }
 
       void ResendJoinMessages(dtEntity::MessageReceiver& rcvr);
@@ -129,6 +176,11 @@ namespace dtEntityNet
    private:
 
       void Tick(const dtEntity::Message& m);
+      // returns false if no update could be sent
+      bool SendUpdate(dtEntity::EntityId id, DeadReckoningSenderComponent* comp, double simtime);
+      float GetDistanceFactor(const osg::Vec3d& pos) const;
+      unsigned int GetUpdateMessageSize();
+
       void OnAddedToScene(const dtEntity::Message& m);
       void OnRemovedFromScene(const dtEntity::Message& m);
 
@@ -140,6 +192,32 @@ namespace dtEntityNet
       dtEntity::FloatProperty mMaxUpdateInterval;
       dtEntity::FloatProperty mMaxPositionDeviation;
       dtEntity::FloatProperty mMaxOrientationDeviation;
+      dtEntity::FloatProperty mBandwidthBudget;
+      dtEntity::UIntProperty mMaxUpdatesPerTick;
+      dtEntity::FloatProperty mPriorityDistance;
+
+      std::vector<osg::Vec3d> mObserverPositions;
+
+      // bytes that may be sent, refilled each tick from bandwidth budget
+      float mAvailableBytes;
+
+      // encoded size of an update message, determined on first use
+      unsigned int mUpdateMessageSize;
+
+      // entities that are due for an update, reused each tick
+      struct UpdateCandidate
+      {
+         float mPriority;
+         dtEntity::EntityId mEntityId;
+         DeadReckoningSenderComponent* mComponent;
+      };
+      typedef std::vector<UpdateCandidate> UpdateCandidates;
+      UpdateCandidates mUpdateCandidates;
+
+      static bool HigherPriority(const UpdateCandidate& a, const UpdateCandidate& b)
+      {
+         return a.mPriority > b.mPriority;
+      }
 
       dtEntity::MessagePump mOutgoing;
    };
@@ -23,6 +23,7 @@
 
 #include <dtEntity/entitysystem.h>
 #include <dtEntity/messagepump.h>
+#include <dtEntity/protobufmapencoder.h>
 #include <dtEntity/scriptaccessor.h>
 #include <dtEntityNet/export.h>
 
@@ -77,6 +78,7 @@ namespace dtEntityNet
 
       dtEntity::MessagePump mIncoming;
       dtEntity::MessageFunctor mTickFunctor;
+      dtEntity::ProtoBufMessageDecoder mDecoder;
       _ENetHost* mHost;
       _ENetPeer* mPeer;
       typedef std::vector<_ENetPeer*> Clients;
@@ -0,0 +1,234 @@
+#pragma once
+
+/* -*-c++-*-
+* dtEntity Game and Simulation Engine
+*
+* This library is free software; you can redistribute it and/or modify it under
+* the terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; either version 2.1 of the License, or (at your option)
+* any later version.
+*
+* This library is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+* details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this library; if not, write to the Free Software Foundation, Inc.,
+* 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*
+* Martin Scheffler
+*/
+
+
+#include <dtEntity/entitysystem.h>
+#include <dtEntity/messagepump.h>
+#include <dtEntity/protobufmapencoder.h>
+#include <dtEntity/scriptaccessor.h>
+#include <dtEntityNet/export.h>
+#include <osg/Referenced>
+#include <osg/ref_ptr>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace dtEntityNet
+{
+
+   ////////////////////////////////////////////////////////////////////////////////
+   /**
+    * Simulated in-process network. Endpoints exchange byte packets that are
+    * delayed, dropped and throttled according to the configured link
+    * properties. All randomness comes from a seeded generator and time is
+    * advanced explicitly, so a run with the same inputs always produces
+    * the same packet schedule.
+    */
+   class DTENTITY_NET_EXPORT LoopbackNetwork : public osg::Referenced
+   {
+   public:
+
+      typedef unsigned int EndpointId;
+      static const EndpointId SERVER_ENDPOINT = 0;
+
+      enum PacketType
+      {
+         CONNECT,
+         DISCONNECT,
+         DATA
+      };
+
+      struct Statistics
+      {
+         Statistics();
+         unsigned int mPacketsSent;
+         unsigned int mPacketsDropped;
+         unsigned int mPacketsDelivered;
+         unsigned int mBytesSent;
+         unsigned int mBytesDelivered;
+      };
+
+      LoopbackNetwork(unsigned int seed = 0);
+
+      /** one way delay of each packet in seconds */
+      void SetLatency(double v) { mLatency = v; }
+      double GetLatency() const { return mLatency; }
+
+      /** maximum random delay in seconds added to latency */
+      void SetJitter(double v) { mJitter = v; }
+      double GetJitter() const { return mJitter; }
+
+      /**
+       * Probability in [0, 1] of a packet being lost. Lost unreliable packets
+       * are dropped, lost reliable packets are delivered after a resend delay
+       */
+      void SetPacketLoss(float v) { mPacketLoss = v; }
+      float GetPacketLoss() const { return mPacketLoss; }
+
+      /** bytes per second each link can transmit, 0 for unlimited */
+      void SetBandwidth(float v) { mBandwidth = v; }
+      float GetBandwidth() const { return mBandwidth; }
+
+      /**
+       * Set current network time. Packets are delivered when their
+       * arrival time is reached
+       */
+      void SetTime(double t) { mTime = t; }
+      double GetTime() const { return mTime; }
+
+      /** Create a client endpoint and send a connect event to the server */
+      EndpointId Connect();
+
+      /**
+       * Remove endpoint, drop its packets and notify the other side.
+       * Disconnecting the server sends a disconnect to every client, a client
+       * endpoint is closed when it receives that packet
+       */
+      void Disconnect(EndpointId ep);
+
+      bool IsConnected(EndpointId ep) const;
+
+      void Send(EndpointId from, EndpointId to, const std::string& data, bool reliable);
+
+      /**
+       * Get next packet that has arrived at endpoint ep.
+       * Returns false if no packet is due
+       */
+      bool Receive(EndpointId ep, PacketType& type, EndpointId& from, std::string& data);
+
+      const Statistics& GetStatistics() const { return mStatistics; }
+      void ResetStatistics() { mStatistics = Statistics(); }
+
+   protected:
+
+      ~LoopbackNetwork();
+
+   private:
+
+      struct Packet
+      {
+         double mArrivalTime;
+         unsigned int mSequence;
+         PacketType mType;
+         EndpointId mFrom;
+         std::string mData;
+      };
+
+      // orders packets by arrival time, sequence number breaks ties
+      struct PacketOrder
+      {
+         bool operator()(const Packet* a, const Packet* b) const
+         {
+            if(a->mArrivalTime != b->mArrivalTime) return a->mArrivalTime < b->mArrivalTime;
+            return a->mSequence < b->mSequence;
+         }
+      };
+
+      typedef std::set<Packet*, PacketOrder> PacketQueue;
+
+      struct Link
+      {
+         Link() : mBusyUntil(0), mLastArrival(0) {}
+         double mBusyUntil;
+         double mLastArrival;
+      };
+
+      void Enqueue(EndpointId from, EndpointId to, PacketType type, const std::string& data, bool reliable);
+
+      // uniform random number in [0, 1)
+      double Random();
+
+      double mLatency;
+      double mJitter;
+      float mPacketLoss;
+      float mBandwidth;
+      double mTime;
+      unsigned int mRandomState;
+      unsigned int mSequence;
+      EndpointId mNextEndpoint;
+      std::set<EndpointId> mEndpoints;
+      std::map<EndpointId, PacketQueue> mQueues;
+      std::map<std::pair<EndpointId, EndpointId>, Link> mLinks;
+      Statistics mStatistics;
+   };
+
+   ////////////////////////////////////////////////////////////////////////////////
+   /**
+    * Drop-in replacement for ENetSystem that exchanges messages over a
+    * LoopbackNetwork. Allows running a server and any number of clients
+    * in a single process, each with its own entity manager.
+    * Transform updates are sent unreliable, all other messages reliable.
+    */
+   class DTENTITY_NET_EXPORT LoopbackSystem
+      : public dtEntity::EntitySystem
+      , public dtEntity::ScriptAccessor
+   {
+      typedef dtEntity::EntitySystem BaseClass;
+
+   public:
+
+      static const dtEntity::ComponentType TYPE;
+
+      LoopbackSystem(dtEntity::EntityManager& em);
+      ~LoopbackSystem();
+
+      virtual void OnAddedToEntityManager(dtEntity::EntityManager &em);
+
+      dtEntity::ComponentType GetComponentType() const { return TYPE; }
+
+      dtEntity::MessagePump& GetIncomingMessagePump() { return mIncoming; }
+
+      void SetNetwork(LoopbackNetwork* n);
+      LoopbackNetwork* GetNetwork() const { return mNetwork.get(); }
+
+      bool InitializeServer();
+      bool Connect();
+
+      bool IsConnected() const;
+
+      void Disconnect();
+
+      void SendToClients(const dtEntity::Message&);
+      void SendToServer(const dtEntity::Message&);
+      void SendToPeer(const dtEntity::Message&, LoopbackNetwork::EndpointId peer);
+
+      void Flush() {}
+
+   private:
+
+      void Tick(const dtEntity::Message& m);
+      bool Encode(const dtEntity::Message& msg);
+
+      dtEntity::MessagePump mIncoming;
+      dtEntity::MessageFunctor mTickFunctor;
+      dtEntity::ProtoBufMessageDecoder mDecoder;
+      osg::ref_ptr<LoopbackNetwork> mNetwork;
+      bool mActive;
+      bool mIsServer;
+      LoopbackNetwork::EndpointId mEndpoint;
+      typedef std::vector<LoopbackNetwork::EndpointId> Clients;
+      Clients mConnectedClients;
+      std::string mSendBuffer;
+      std::string mReceiveBuffer;
+   };
+}
@@ -124,7 +124,11 @@ namespace dtEntityNet
 
    ////////////////////////////////////////////////////////////////////////////////
    /**
-    * send this message to cause a script to be loaded
+    * Dead reckoning state of a replicated entity.
+    * Wire format history:
+    * version 0 (no ProtocolVersion property): orientation as euler angles in a vec3
+    * version 2: orientation as quaternion, additional acceleration
+    * Receivers drop updates with a different version instead of misreading them.
     */
    class DTENTITY_NET_EXPORT UpdateTransformMessage
       : public dtEntity::Message
@@ -132,9 +136,15 @@ namespace dtEntityNet
    public:
 
       static const dtEntity::MessageType TYPE;
+
+      // current wire format version, see class comment
+      static const unsigned int PROTOCOL_VERSION = 2;
+
+      static const dtEntity::StringId ProtocolVersionId;
       static const dtEntity::StringId DeadReckoningAlgorithmId;
       static const dtEntity::StringId PositionId;
       static const dtEntity::StringId VelocityId;
+      static const dtEntity::StringId AccelerationId;
       static const dtEntity::StringId OrientationId;
       static const dtEntity::StringId AngularVelocityId;
       static const dtEntity::StringId SimTimeId;
@@ -145,6 +155,10 @@ namespace dtEntityNet
       // Create a copy of this message on the heap
       virtual dtEntity::Message* Clone() const { return CloneContainer<UpdateTransformMessage>(); }
 
+      // 0 if sender did not send a version
+      void SetProtocolVersion(unsigned int v) { mProtocolVersion.Set(v); }
+      unsigned int GetProtocolVersion() const { return mProtocolVersion.Get(); }
+
       void SetDeadReckoning(DeadReckoningAlgorithm::e v)
       {
          mDeadReckoningAlgorithm.Set(v);
@@ -161,9 +175,13 @@ namespace dtEntityNet
       void SetVelocity(const osg::Vec3f& v) { mVelocity.Set(v); }
       const osg::Vec3f& GetVelocity() const { return mVelocity.GetAsVec3(); }
 
-      void SetOrientation(const osg::Vec3f& v) { mOrientation.Set(v); }
-      const osg::Vec3f& GetOrientation() const { return mOrientation.GetAsVec3(); }
+      void SetAcceleration(const osg::Vec3f& v) { mAcceleration.Set(v); }
+      const osg::Vec3f& GetAcceleration() const { return mAcceleration.GetAsVec3(); }
+
+      void SetOrientation(const osg::Quat& v) { mOrientation.Set(v); }
+      const osg::Quat& GetOrientation() const { return mOrientation.GetAsQuat(); }
 
+      // rotation axis scaled by rotation rate in rad/s
       void SetAngularVelocity(const osg::Vec3f& v) { mAngularVelocity.Set(v); }
       const osg::Vec3f& GetAngularVelocity() const { return mAngularVelocity.GetAsVec3(); }
 
@@ -175,10 +193,12 @@ namespace dtEntityNet
 
    private:
 
+      dtEntity::UIntProperty mProtocolVersion;
       dtEntity::UIntProperty mDeadReckoningAlgorithm;
       dtEntity::Vec3dProperty mPosition;
       dtEntity::Vec3Property mVelocity;
-      dtEntity::Vec3Property mOrientation;
+      dtEntity::Vec3Property mAcceleration;
+      dtEntity::QuatProperty mOrientation;
       dtEntity::Vec3Property mAngularVelocity;
       dtEntity::DoubleProperty mSimTime;
       dtEntity::StringProperty mUniqueId;
@@ -0,0 +1,141 @@
+#pragma once
+
+/* -*-c++-*-
+ * dtEntity Game and Simulation Engine
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation; either version 2.1 of the License, or (at your option)
+ * any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * Martin Scheffler
+ */
+
+#include <dtEntityOSG/export.h>
+#include <dtEntity/systeminterface.h>
+#include <vector>
+
+namespace dtEntity
+{
+   class MessagePump;
+}
+
+namespace dtEntityOSG
+{
+   ////////////////////////////////////////////////////////////////////////////////
+   namespace FrameStage
+   {
+      enum e
+      {
+         POST_FRAME,
+         TICK,
+         QUEUED_MESSAGES,
+         END_OF_FRAME,
+         // everything between two calls to EmitTickMessagesAndQueuedMessages:
+         // event and update traversal, cull and draw
+         RENDER,
+         NUM_STAGES
+      };
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   /**
+    * Measures the stages of each frame and keeps a histogram of the
+    * frame times of the last frames. When a frame takes longer than the frame
+    * budget, the stage times and the slowest message subscribers of that frame
+    * are written to the log and a FrameHitchMessage is emitted.
+    * Subscribers are identified by the funcname given when registering
+    * for messages.
+    *
+    * A frame ends when the next one begins, so hitches are reported at the
+    * start of the following frame.
+    */
+   class DTENTITY_OSG_EXPORT FrameBudgetMonitor
+   {
+   public:
+
+      FrameBudgetMonitor(dtEntity::MessagePump& mp);
+      ~FrameBudgetMonitor();
+
+      /**
+       * Enable stage timing and subscriber timing of the message pump.
+       * When disabled, BeginFrame, BeginStage and EndStage only check a flag
+       */
+      void SetEnabled(bool v);
+      bool GetEnabled() const { return mEnabled; }
+
+      /** number of subscribers reported for a hitch, 5 by default */
+      void SetNumReportedSubscribers(unsigned int v) { mNumReportedSubscribers = v; }
+      unsigned int GetNumReportedSubscribers() const { return mNumReportedSubscribers; }
+
+      /** number of frames the histogram and the averages are computed over, 600 by default */
+      void SetHistorySize(unsigned int v);
+      unsigned int GetHistorySize() const { return static_cast<unsigned int>(mFrameTimes.size()); }
+
+      /**
+       * Finish previous frame and start a new one. Previous frame is
+       * reported as hitch if it took longer than budget seconds
+       */
+      void BeginFrame(double budget);
+      void BeginStage(FrameStage::e stage);
+      void EndStage(FrameStage::e stage);
+
+      /** seconds of given stage in last finished frame */
+      double GetLastStageTime(FrameStage::e stage) const { return mLastStageTimes[stage]; }
+
+      /** average seconds of given stage over history */
+      double GetAverageStageTime(FrameStage::e stage) const;
+
+      /** seconds of last finished frame */
+      double GetLastFrameTime() const { return mLastFrameTime; }
+
+      /**
+       * Frame time histogram over history. Bucket i counts frames taking
+       * between i and i + 1 times bucket width, last bucket counts all longer frames
+       */
+      const std::vector<unsigned int>& GetHistogram() const { return mHistogram; }
+      double GetHistogramBucketWidth() const { return mBucketWidth; }
+
+      /** number of frames reported as hitches since monitor was enabled */
+      unsigned int GetNumHitches() const { return mNumHitches; }
+
+      void Reset();
+
+   private:
+
+      void EndFrame(double budget);
+      void ReportHitch(double frametime, double budget);
+      unsigned int GetBucket(double frametime) const;
+
+      dtEntity::MessagePump* mMessagePump;
+      bool mEnabled;
+      bool mFrameStarted;
+      unsigned int mNumReportedSubscribers;
+      unsigned int mNumHitches;
+
+      dtEntity::Timer_t mFrameStart;
+      dtEntity::Timer_t mStageStart[FrameStage::NUM_STAGES];
+      double mStageTimes[FrameStage::NUM_STAGES];
+      double mLastStageTimes[FrameStage::NUM_STAGES];
+      double mLastFrameTime;
+
+      // ring buffer of frame times and stage times
+      std::vector<double> mFrameTimes;
+      std::vector<double> mStageHistory[FrameStage::NUM_STAGES];
+      double mStageSums[FrameStage::NUM_STAGES];
+      unsigned int mHistoryIndex;
+      unsigned int mHistoryCount;
+
+      double mBucketWidth;
+      std::vector<unsigned int> mHistogram;
+   };
+}
@@ -46,6 +46,9 @@ namespace dtEntityOSG
     * If you want to do fancy stuff in your setup then maybe you should not call this, instead write your own!
     *
     * Installs a log handler, calls SetupDataPaths(), calls InitDtEntity(), calls SetupViewer(), then calls DoScreenSetup()
+    * Command line argument --frameMonitor <budget in ms> enables the frame budget monitor
+    * of the system interface, --profile <categories> enables profiling of the comma
+    * separated categories messages, systems, scripts, io, lookups or all
     * @param argc number of command line args
     * @param standard c command line args
     * @param viewer An instance of either osgViewer::Viewer or osgViewer::CompositeViewer
@@ -22,6 +22,7 @@
 
 #include <dtEntity/systeminterface.h>
 #include <dtEntityOSG/export.h>
+#include <dtEntityOSG/framebudgetmonitor.h>
 #include <osgViewer/ViewerBase>
 #include <vector>
 
@@ -54,6 +55,22 @@ namespace dtEntityOSG
       virtual float GetDeltaSimTime() const;
       virtual float GetDeltaRealTime() const;
       virtual dtEntity::Timer_t GetRealClockTime();
+
+      /**
+       * Time in seconds one frame may take, 1/60 by default.
+       * Only the time since the start of the update traversal is counted,
+       * set a smaller budget if rendering runs in the same thread.
+       */
+      void SetFrameBudget(double v) { mFrameBudget = v; }
+      double GetFrameBudget() const { return mFrameBudget; }
+
+      virtual double GetFrameTimeLeft() const;
+
+      /**
+       * Measures the stages of EmitTickMessagesAndQueuedMessages and reports
+       * frames taking longer than the frame budget. Disabled by default
+       */
+      FrameBudgetMonitor& GetFrameBudgetMonitor();
       virtual double GetSimulationTime() const;
       void SetSimulationTime(double);
 
@@ -82,6 +99,7 @@ namespace dtEntityOSG
    private:
       osg::observer_ptr<osgViewer::ViewerBase> mViewer;      
       dtEntity::MessagePump* mMessagePump;
+      double mFrameBudget;
       class Impl;
       Impl* mImpl;
    };
@@ -31,10 +31,19 @@
 
 namespace dtEntityWrappers
 {
+	/**
+	 * Releases memory that was not allocated by ByteStorageData,
+	 * for example a memory mapped file
+	 */
+	typedef void (*ByteStorageReleaseFunc)(char * data, size_t length, void * userdata);
+
 	class ByteStorageData {
 	public:
 		ByteStorageData(size_t length) {
 			this->instances = 1;
+			this->length = length;
+			this->release = NULL;
+			this->userdata = NULL;
 			if (length) {
 				this->data = (char *) malloc(length);
 				if (!this->data) { throw std::string("Cannot allocate enough memory"); }
@@ -43,8 +52,21 @@ namespace dtEntityWrappers
 			}
 		}
 
+		/* use external memory without copying, release is called when last instance is gone */
+		ByteStorageData(char * data, size_t length, ByteStorageReleaseFunc release, void * userdata) {
+			this->instances = 1;
+			this->data = data;
+			this->length = length;
+			this->release = release;
+			this->userdata = userdata;
+		}
+
 		~ByteStorageData() {
-			if (this->data) { free(this->data); }
+			if (this->release) {
+				this->release(this->data, this->length, this->userdata);
+			} else if (this->data) {
+				free(this->data);
+			}
 		}
 
 		size_t getInstances() {
@@ -61,7 +83,10 @@ namespace dtEntityWrappers
 
 	private:
 		char * data;
+		size_t length;
 		size_t instances;
+		ByteStorageReleaseFunc release;
+		void * userdata;
 	};
 
 	/**
@@ -72,8 +97,11 @@ namespace dtEntityWrappers
 		ByteStorage(size_t length); /* empty */
 		ByteStorage(char * data, size_t length); /* with contents (copied) */
 		ByteStorage(ByteStorage * master, size_t index1, size_t index2); /* new view */
+		ByteStorage(char * data, size_t length, ByteStorageReleaseFunc release, void * userdata); /* external memory (not copied) */
 		~ByteStorage();
 
+		static ByteStorage * mapFile(const char * name); /* memory mapped file, NULL on error */
+
 		ByteStorageData * getStorage();
 
 		char * getData();
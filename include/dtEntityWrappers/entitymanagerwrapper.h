@@ -38,4 +38,10 @@ namespace dtEntityWrappers
    DTENTITY_WRAPPERS_EXPORT v8::Handle<v8::Object> WrapPriorities();
    DTENTITY_WRAPPERS_EXPORT dtEntity::EntityManager* UnwrapEntityManager(v8::Handle<v8::Value>);
    DTENTITY_WRAPPERS_EXPORT void ConvertJSToMessage(v8::Handle<v8::Value> val, dtEntity::Message* msg);
+
+   /**
+    * Dispose cached templates of script message objects, call when
+    * the script context is torn down
+    */
+   DTENTITY_WRAPPERS_EXPORT void ClearMessageTemplates();
 }
@@ -36,4 +36,16 @@ namespace dtEntityWrappers
    DTENTITY_WRAPPERS_EXPORT dtEntity::EntitySystem* UnwrapEntitySystem(v8::Handle<v8::Value>);
    DTENTITY_WRAPPERS_EXPORT bool IsEntitySystem(v8::Handle<v8::Value>);
    DTENTITY_WRAPPERS_EXPORT void RegisterEntitySystempWrapper(ScriptSystem*, dtEntity::ComponentType, v8::Handle<v8::FunctionTemplate>);
+
+   /**
+    * Copy one property of many components of entity system es from or to a typed array.
+    * Values are packed back to back in order of entity ids, each taking
+    * GetNumPackedValues() entries. Entries of entities without the component are left untouched.
+    * Works for bool, number, vector, quat and matrix properties.
+    * @param entityids JS array or Uint32Array of entity ids
+    * @param values typed array receiving the values (write == false) or holding them (write == true)
+    * @return number of components read or written
+    */
+   DTENTITY_WRAPPERS_EXPORT v8::Handle<v8::Value> TransferPropertyValues(dtEntity::EntitySystem* es,
+      dtEntity::StringId propname, v8::Handle<v8::Value> entityids, v8::Handle<v8::Value> values, bool write);
 }
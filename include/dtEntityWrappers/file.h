@@ -26,4 +26,13 @@
 namespace dtEntityWrappers
 {      
    v8::Handle<v8::Function> CreateFile();
+
+   /**
+    * Call callbacks of finished File.readAsync and File.writeAsync requests.
+    * Called by the script system each tick. Returns number of finished requests
+    */
+   unsigned int ProcessAsyncFileRequests();
+
+   /** stop background file thread, pending requests are dropped */
+   void ShutdownAsyncFileIO();
 }
@@ -68,4 +68,53 @@ namespace dtEntityWrappers
       dtEntity::StringProperty mPath;
       dtEntity::BoolProperty mIncludeOnce;
    };
+
+   ////////////////////////////////////////////////////////////////////////////////
+   /**
+    * Result posted by a script worker, see WorkerPool.
+    * If TransferId is not 0, the buffers sent along with the result can
+    * be taken from the worker pool while this message is handled.
+    */
+   class DTENTITY_WRAPPERS_EXPORT WorkerMessage
+      : public dtEntity::Message
+   {
+   public:
+
+      static const dtEntity::MessageType TYPE;
+      static const dtEntity::StringId ModuleId;
+      static const dtEntity::StringId JobIdId;
+      static const dtEntity::StringId DataId;
+      static const dtEntity::StringId TransferIdId;
+
+      WorkerMessage()
+         : dtEntity::Message(TYPE)
+      {
+         Register(ModuleId, &mModule);
+         Register(JobIdId, &mJobId);
+         Register(DataId, &mData);
+         Register(TransferIdId, &mTransferId);
+      }
+
+      // Create a copy of this message on the heap
+      virtual dtEntity::Message* Clone() const { return CloneContainer<WorkerMessage>(); }
+
+      void SetModule(const std::string& v) { mModule.Set(v); }
+      std::string GetModule() const { return mModule.Get(); }
+
+      void SetJobId(unsigned int v) { mJobId.Set(v); }
+      unsigned int GetJobId() const { return mJobId.Get(); }
+
+      void SetData(const dtEntity::PropertyGroup& v) { mData.Set(v); }
+      dtEntity::PropertyGroup GetData() const { return mData.Get(); }
+
+      void SetTransferId(unsigned int v) { mTransferId.Set(v); }
+      unsigned int GetTransferId() const { return mTransferId.Get(); }
+
+   private:
+
+      dtEntity::StringProperty mModule;
+      dtEntity::UIntProperty mJobId;
+      dtEntity::GroupProperty mData;
+      dtEntity::UIntProperty mTransferId;
+   };
 }
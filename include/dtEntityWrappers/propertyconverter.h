@@ -33,4 +33,17 @@ namespace dtEntityWrappers
    v8::Handle<v8::Value> SetValueFromProperty(dtEntity::Property*& prop, v8::Handle<v8::Value> val);
    dtEntity::Property* ConvertValueToProperty(v8::Handle<v8::Value> val);
    v8::Handle<v8::Value> ConvertPropertyToValue(v8::Handle<v8::Context> context, const dtEntity::Property* prop);
+
+   /**
+    * Number of doubles needed to store a value of given type:
+    * 1 for bool and number types, 2, 3 or 4 for vectors, 4 for quats,
+    * 16 for matrices and 0 for all other types
+    */
+   unsigned int GetNumPackedValues(dtEntity::DataType::e dtype);
+
+   /** write value of bool, number, vector, quat or matrix property to out */
+   void PackProperty(const dtEntity::Property& prop, double* out);
+
+   /** set value of bool, number, vector, quat or matrix property from in */
+   void UnpackProperty(const double* in, dtEntity::Property& prop);
 }
@@ -27,10 +27,15 @@
 #include <dtEntity/component.h>
 #include <dtEntity/defaultentitysystem.h>
 #include <dtEntity/property.h>
+#include <osg/Timer>
 #include <set>
+#include <string>
+#include <vector>
 
 namespace dtEntityWrappers
 {
+   class ScriptProfileReport;
+   class WorkerPool;
      
    ////////////////////////////////////////////////////////////////////////////
    class DTENTITY_WRAPPERS_EXPORT ScriptSystem
@@ -40,6 +45,18 @@ namespace dtEntityWrappers
       static const dtEntity::StringId ScriptsId;
       static const dtEntity::StringId DebugPortId;
       static const dtEntity::StringId DebugEnabledId;
+      static const dtEntity::StringId CodeCacheEnabledId;
+      static const dtEntity::StringId CodeCacheDirId;
+      static const dtEntity::StringId IdleGCEnabledId;
+      static const dtEntity::StringId GCBudgetId;
+      static const dtEntity::StringId HeapTotalSizeId;
+      static const dtEntity::StringId HeapUsedSizeId;
+      static const dtEntity::StringId GCCountId;
+      static const dtEntity::StringId LastGCPauseId;
+      static const dtEntity::StringId MaxGCPauseId;
+      static const dtEntity::StringId NumWorkerThreadsId;
+      static const dtEntity::StringId WorkerModulesId;
+      static const dtEntity::StringId CPUProfilingEnabledId;
       
       typedef dtEntity::EntitySystem BaseClass;
 
@@ -56,10 +73,14 @@ namespace dtEntityWrappers
 
       virtual void OnAddedToEntityManager(dtEntity::EntityManager& em);
       virtual void OnRemoveFromEntityManager(dtEntity::EntityManager& em);
+
+      virtual void OnPropertyChanged(dtEntity::StringId propname, dtEntity::Property& prop);
       
       void OnSceneLoaded(const dtEntity::Message& msg);
       void OnLoadScript(const dtEntity::Message& msg);
       void Tick(const dtEntity::Message& msg);
+      void OnEndOfFrame(const dtEntity::Message& msg);
+      void OnEntityRemovedFromScene(const dtEntity::Message& msg);
 
       
 
@@ -78,6 +99,114 @@ namespace dtEntityWrappers
 
       void ExecuteFileOnce(const std::string& path);
 
+      /**
+       * Register a function to be called on each tick for given entity.
+       * All update functions are invoked from a single call into the script
+       * engine per tick, with arguments (dt, simtime, clocktime, entityid).
+       * An exception thrown by one function is reported and the remaining
+       * functions are still called. Update functions of an entity are removed
+       * when the entity is removed from the scene.
+       */
+      void AddUpdateFunction(dtEntity::EntityId id, v8::Handle<v8::Function> func);
+
+      /**
+       * Remove update function of given entity. If func is empty,
+       * all update functions of the entity are removed.
+       * @return true if a function was removed
+       */
+      bool RemoveUpdateFunction(dtEntity::EntityId id, v8::Handle<v8::Function> func);
+
+      unsigned int GetNumUpdateFunctions() const { return mNumUpdateFunctions; }
+
+      /**
+       * If enabled, pre-parse data of script files is stored to the code cache
+       * directory and used to speed up compilation on the next start.
+       * Cache entries are keyed by file path and content hash.
+       * Disabled by default.
+       */
+      void SetCodeCacheEnabled(bool v) { mCodeCacheEnabled.Set(v); }
+      bool GetCodeCacheEnabled() const { return mCodeCacheEnabled.Get(); }
+
+      /**
+       * Directory for cached script data. If empty, dtEntity/ScriptCache
+       * in the user cache directory is used ($XDG_CACHE_HOME or ~/.cache,
+       * %LOCALAPPDATA% on windows).
+       */
+      void SetCodeCacheDir(const std::string& v) { mCodeCacheDir.Set(v); }
+      std::string GetCodeCacheDir() const;
+
+      // compile statistics, used to compare cold and cached startup
+      unsigned int GetNumScriptsCompiled() const { return mNumScriptsCompiled; }
+      unsigned int GetNumCodeCacheHits() const { return mNumCodeCacheHits; }
+      double GetScriptCompileTime() const { return mScriptCompileTime; }
+
+      /**
+       * If enabled, the time left in each frame is used for incremental
+       * garbage collection work, up to GCBudget seconds per frame.
+       * Time left is taken from the system interface, if it does not
+       * know about a frame budget the full GC budget is used.
+       */
+      void SetIdleGCEnabled(bool v) { mIdleGCEnabled.Set(v); }
+      bool GetIdleGCEnabled() const { return mIdleGCEnabled.Get(); }
+
+      void SetGCBudget(float v) { mGCBudget.Set(v); }
+      float GetGCBudget() const { return mGCBudget.Get(); }
+
+      // heap and garbage collection statistics, updated each frame.
+      // Heap sizes are in bytes, double so that heaps above 4 GB do not wrap
+      double GetHeapTotalSize() const { return mHeapTotalSize.Get(); }
+      double GetHeapUsedSize() const { return mHeapUsedSize.Get(); }
+      unsigned int GetGCCount() const { return mGCCount.Get(); }
+      double GetLastGCPause() const { return mLastGCPause.Get(); }
+      double GetMaxGCPause() const { return mMaxGCPause.Get(); }
+      double GetTotalGCPause() const { return mTotalGCPause; }
+      double GetTotalIdleGCTime() const { return mTotalIdleGCTime; }
+
+      /**
+       * Pool for running scripts on worker threads. Modules listed in
+       * property WorkerModules are allowed to run in workers, the pool
+       * uses NumWorkerThreads threads.
+       */
+      WorkerPool& GetWorkerPool() { return *mWorkerPool; }
+
+      /** time spent in a script function while CPU profiler was running */
+      struct ScriptFunctionProfile
+      {
+         std::string mFunctionName;
+         std::string mScriptName;
+         int mLineNumber;
+         double mSelfTime; // milliseconds
+         double mTotalTime; // milliseconds, including called functions
+         unsigned int mSamples;
+      };
+      typedef std::vector<ScriptFunctionProfile> ScriptProfile;
+
+      /**
+       * Start sampling profiler of script engine. Can also be
+       * toggled with property CPUProfilingEnabled, for example from the editor
+       */
+      void StartCPUProfiling();
+
+      /**
+       * Stop profiler and collect per function times. Results replace
+       * those of the previous profiling run.
+       */
+      void StopCPUProfiling();
+      bool IsCPUProfiling() const { return mCPUProfiling; }
+
+      /** results of last profiling run, sorted by self time */
+      const ScriptProfile& GetScriptProfile() const { return mScriptProfile; }
+
+      /**
+       * Print last profiling run. Is also printed as part of the native
+       * profile report when profiling is enabled
+       */
+      void DumpScriptProfile() const;
+
+      // called from V8 garbage collection callbacks
+      void OnGCStarted();
+      void OnGCEnded();
+
 
       // look in given directory for scripts ending with "*.js",
       // execute them and try to add entity system with name
@@ -110,22 +239,106 @@ namespace dtEntityWrappers
    private:
       void SetupContext();
       void FetchGlobalTickFunction();
+
+      // call all update functions, tickargs are dt, simtime and clocktime
+      void CallUpdateFunctions(v8::Handle<v8::Value>* tickargs, v8::TryCatch& try_catch);
+
+      // build the JS arrays passed to the dispatch function from mUpdateFunctions
+      void RebuildUpdateFunctionArrays();
+      void ClearUpdateFunctions();
+
+      // get pre-parse data from code cache or create and store it.
+      // Cached bytes are read into data, which has to outlive the returned ScriptData
+      v8::ScriptData* GetScriptData(const std::string& path, const std::string& code,
+                                    v8::Handle<v8::String> source, std::vector<char>& data);
+
+      // do incremental garbage collection work for at most idletime seconds
+      void DoIdleGC(double idletime);
       
       dtEntity::MessageFunctor mSceneLoadedFunctor;
       dtEntity::MessageFunctor mTickFunctor;
+      dtEntity::MessageFunctor mEndOfFrameFunctor;
       dtEntity::MessageFunctor mLoadScriptFunctor;
+      dtEntity::MessageFunctor mEntityRemovedFunctor;
       
       dtEntity::BoolProperty mDebugEnabled;
       bool mDebugPortOpened;
       dtEntity::ArrayProperty mScripts;
       dtEntity::UIntProperty mDebugPort;
+      dtEntity::BoolProperty mCodeCacheEnabled;
+      dtEntity::StringProperty mCodeCacheDir;
+      dtEntity::BoolProperty mIdleGCEnabled;
+      dtEntity::FloatProperty mGCBudget;
+      dtEntity::DoubleProperty mHeapTotalSize;
+      dtEntity::DoubleProperty mHeapUsedSize;
+      dtEntity::UIntProperty mGCCount;
+      dtEntity::DoubleProperty mLastGCPause;
+      dtEntity::DoubleProperty mMaxGCPause;
+      dtEntity::UIntProperty mNumWorkerThreads;
+      dtEntity::ArrayProperty mWorkerModules;
+      dtEntity::BoolProperty mCPUProfilingEnabled;
+      WorkerPool* mWorkerPool;
+      bool mCPUProfiling;
+      ScriptProfile mScriptProfile;
+      ScriptProfileReport* mProfileReport;
+      double mTotalGCPause;
+      double mTotalIdleGCTime;
+      osg::Timer_t mGCStartTick;
+      // true if GC in progress was started in profiler
+      bool mGCProfiled;
+
+      unsigned int mNumScriptsCompiled;
+      unsigned int mNumCodeCacheHits;
+      double mScriptCompileTime;
 
       v8::Persistent<v8::Context> mGlobalContext;
       v8::Persistent<v8::Function> mGlobalTickFunction;
+
+      struct UpdateFunction
+      {
+         dtEntity::EntityId mEntityId;
+         v8::Persistent<v8::Function> mFunction;
+      };
+
+      // removed entries have an empty function and are erased
+      // when the arrays are rebuilt
+      std::vector<UpdateFunction> mUpdateFunctions;
+      unsigned int mNumUpdateFunctions;
+      bool mUpdateFunctionsChanged;
+      v8::Persistent<v8::Array> mUpdateFunctionArray;
+      v8::Persistent<v8::Array> mUpdateEntityIdArray;
+      v8::Persistent<v8::Array> mDispatchState;
+      v8::Persistent<v8::Function> mDispatchFunction;
       std::set<std::string> mIncludedFiles;
 
-      typedef std::map<std::pair<dtEntity::ComponentType, dtEntity::EntityId>, v8::Persistent<v8::Object> > ComponentMap;
-      ComponentMap mComponentMap;
+      // component wrappers of a single component type, indexed by entity id
+#if defined(_MSC_VER) && (_MSC_VER >=1500)
+      typedef std::tr1::unordered_map<dtEntity::EntityId, v8::Persistent<v8::Object> > ComponentWrapperMap;
+#elif defined(__GNUG__)
+      typedef __gnu_cxx::hash_map<dtEntity::EntityId, v8::Persistent<v8::Object> > ComponentWrapperMap;
+#else
+      typedef std::map<dtEntity::EntityId, v8::Persistent<v8::Object> > ComponentWrapperMap;
+#endif
+
+      struct ComponentWrappers
+      {
+         dtEntity::ComponentType mComponentType;
+         ComponentWrapperMap mWrappers;
+      };
+
+      /**
+       * Get wrapper map for component type. Returns NULL if
+       * none exists and create is false
+       */
+      ComponentWrappers* GetComponentWrappers(dtEntity::ComponentType ct, bool create) const;
+
+      // one entry per wrapped component type. There are only a few
+      // of these, so they are searched linearly
+      mutable std::vector<ComponentWrappers*> mComponentWrappers;
+
+      // scripts usually access many components of the same type in a row,
+      // so remember the last wrapper map used
+      mutable ComponentWrappers* mLastComponentWrappers;
       v8::Persistent<v8::String> mEntityIdString;
       v8::Persistent<v8::String> mPropertyNamesString;
 
@@ -181,10 +181,31 @@ namespace dtEntityWrappers
       return v8::ThrowException(v8::Exception::SyntaxError(v8::String::New(err.c_str())));
    }
 
+   /**
+    * Look up Float64Array constructor in context and create the prototypes
+    * for wrapped vectors. Has to be called before wrapping vectors,
+    * otherwise they are wrapped as plain JS arrays.
+    */
+   DTENTITY_WRAPPERS_EXPORT void InitializeVectorWrappers(v8::Handle<v8::Context> context);
+
+   /**
+    * If v is a Float64Array, get pointer to its storage and its number of entries.
+    * Vectors, quats and matrices are wrapped as Float64Arrays, scripts can also
+    * pass their own preallocated typed arrays.
+    * @return false if v is no Float64Array
+    */
+   DTENTITY_WRAPPERS_EXPORT bool GetFloat64ArrayData(v8::Handle<v8::Value> v, double*& data, unsigned int& length);
+
+   /**
+    * @return true if v is a typed or plain array with at least minlength entries
+    */
+   DTENTITY_WRAPPERS_EXPORT bool IsNumberArray(v8::Handle<v8::Value> v, unsigned int minlength);
+
    DTENTITY_WRAPPERS_EXPORT v8::Handle<v8::Value> WrapVec2(const dtEntity::Vec2d& v);
    DTENTITY_WRAPPERS_EXPORT v8::Handle<v8::Value> WrapVec3(const dtEntity::Vec3d& v);
    DTENTITY_WRAPPERS_EXPORT v8::Handle<v8::Value> WrapVec4(const dtEntity::Vec4d& v);
    DTENTITY_WRAPPERS_EXPORT v8::Handle<v8::Value> WrapQuat(const dtEntity::Quat& v);
+   // matrices are wrapped as arrays of four rows, m[i][j]. Unwrap also accepts flat arrays of 16 values
    DTENTITY_WRAPPERS_EXPORT v8::Handle<v8::Value> WrapMatrix(const dtEntity::Matrix& v);
    DTENTITY_WRAPPERS_EXPORT v8::Handle<v8::Value> WrapSID(dtEntity::StringId sid);
 
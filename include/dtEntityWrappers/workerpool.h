@@ -0,0 +1,148 @@
+#pragma once
+
+/*
+* dtEntity Game and Simulation Engine
+*
+* This library is free software; you can redistribute it and/or modify it under
+* the terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; either version 2.1 of the License, or (at your option)
+* any later version.
+*
+* This library is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+* details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this library; if not, write to the Free Software Foundation, Inc.,
+* 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*
+* Martin Scheffler
+*/
+
+#include <dtEntityWrappers/export.h>
+#include <dtEntity/messagepump.h>
+#include <dtEntity/property.h>
+#include <OpenThreads/Condition>
+#include <OpenThreads/Mutex>
+#include <v8.h>
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace dtEntity
+{
+   class EntityManager;
+}
+
+namespace dtEntityWrappers
+{
+   class ByteStorage;
+   class WorkerThread;
+
+   ////////////////////////////////////////////////////////////////////////////////
+   /**
+    * Runs script jobs on a pool of threads, each with its own script engine
+    * isolate. Workers have no access to entities or systems, they can only
+    * run modules that were explicitly allowed with AddModule.
+    *
+    * Each module is executed in its own context per worker thread and
+    * has to define a global function onmessage(data, buffers, jobid).
+    * Inside a worker, postMessage(data, buffers) sends a result back.
+    * Results are enqueued to the entity manager as WorkerMessage and
+    * arrive on the main thread with the next queued message dispatch.
+    *
+    * Message data is cloned, buffers are moved to the receiver without
+    * copying their contents. Buffers sent along with a result can be
+    * taken from the pool with TakeTransfer while the WorkerMessage is
+    * handled, after that they are released.
+    */
+   class DTENTITY_WRAPPERS_EXPORT WorkerPool
+   {
+   public:
+
+      typedef std::vector<ByteStorage*> Buffers;
+
+      WorkerPool(dtEntity::EntityManager& em);
+      ~WorkerPool();
+
+      /** number of worker threads, started on first job. Default is 2 */
+      void SetNumThreads(unsigned int v) { mNumThreads = v; }
+      unsigned int GetNumThreads() const { return mNumThreads; }
+
+      /**
+       * Allow module at path to be run in workers.
+       * Script is read immediately, returns false if file was not found
+       */
+      bool AddModule(const std::string& path);
+      bool HasModule(const std::string& path) const;
+
+      /**
+       * Queue job for given module. Pool takes ownership of data
+       * and buffers. Returns job id, 0 if module is not allowed
+       */
+      unsigned int Post(const std::string& module, dtEntity::GroupProperty* data, const Buffers& buffers);
+
+      /** number of jobs waiting or running */
+      unsigned int GetNumPendingJobs() const;
+
+      /**
+       * Get buffers sent with a worker result. Caller takes ownership.
+       * Returns false if transfer id is unknown or was already taken
+       */
+      bool TakeTransfer(unsigned int transferid, Buffers& buffers);
+
+      // called from worker threads
+      void PostResult(const std::string& module, unsigned int jobid, const dtEntity::GroupProperty& data, const Buffers& buffers);
+
+   private:
+
+      friend class WorkerThread;
+
+      struct Job
+      {
+         unsigned int mJobId;
+         std::string mModule;
+         dtEntity::GroupProperty* mData;
+         Buffers mBuffers;
+      };
+
+      void StartThreads();
+      void StopThreads();
+
+      // blocks until a job is available, returns NULL if pool shuts down
+      Job* WaitForJob();
+      void JobDone();
+
+      bool GetModuleSource(const std::string& path, std::string& source) const;
+
+      // release buffers of results that were not taken by any handler
+      void OnWorkerMessage(const dtEntity::Message& msg);
+
+      dtEntity::EntityManager* mEntityManager;
+      dtEntity::MessageFunctor mWorkerMessageFunctor;
+      unsigned int mNumThreads;
+      std::vector<WorkerThread*> mThreads;
+
+      mutable OpenThreads::Mutex mMutex;
+      OpenThreads::Condition mJobAvailable;
+      std::deque<Job*> mJobs;
+      bool mQuit;
+      unsigned int mNextJobId;
+      unsigned int mNumPendingJobs;
+
+      std::map<std::string, std::string> mModules;
+
+      unsigned int mNextTransferId;
+      std::map<unsigned int, Buffers> mTransfers;
+   };
+
+   /**
+    * Create script object giving access to worker pool:
+    * post(module, data, [buffers]), takeBuffers(transferid),
+    * getNumPendingJobs(). Scripts cannot allow modules themselves,
+    * only modules added from C++ can be posted to.
+    */
+   DTENTITY_WRAPPERS_EXPORT v8::Handle<v8::Object> WrapWorkerPool(WorkerPool* v);
+}
@@ -30,6 +30,7 @@
 #include <dtEntity/systeminterface.h>
 #include <dtEntity/systemmessages.h>
 #include <assert.h>
+#include <iomanip>
 #include <sstream>
 #include <iostream>
 
@@ -44,6 +45,7 @@ namespace dtEntity
    const StringId ApplicationSystem::TYPE(dtEntity::SID("Application"));
    const StringId ApplicationSystem::TimeScaleId(dtEntity::SID("TimeScale"));
    const StringId ApplicationSystem::CmdLineArgsId(dtEntity::SID("CmdLineArgs"));
+   const StringId ApplicationSystem::MessageStatisticsEnabledId(dtEntity::SID("MessageStatisticsEnabled"));
  
    ////////////////////////////////////////////////////////////////////////////////
    ApplicationSystem::ApplicationSystem(EntityManager& em)
@@ -52,6 +54,10 @@ namespace dtEntity
            DynamicFloatProperty::SetValueCB(this, &ApplicationSystem::SetTimeScale),
            DynamicFloatProperty::GetValueCB(this, &ApplicationSystem::GetTimeScale)
         )
+      , mMessageStatisticsEnabled(
+           DynamicBoolProperty::SetValueCB(this, &ApplicationSystem::SetMessageStatisticsEnabled),
+           DynamicBoolProperty::GetValueCB(this, &ApplicationSystem::GetMessageStatisticsEnabled)
+        )
    {
 
       // generate a unique ID
@@ -59,6 +65,7 @@ namespace dtEntity
 
       Register(TimeScaleId, &mTimeScale);
       Register(CmdLineArgsId, &mArgvArray);
+      Register(MessageStatisticsEnabledId, &mMessageStatisticsEnabled);
 
       mTimeScale.Set(1);
 
@@ -67,6 +74,10 @@ namespace dtEntity
       AddScriptedMethod("getSimulationClockTime", ScriptMethodFunctor(this, &ApplicationSystem::ScriptGetSimulationClockTime));
       AddScriptedMethod("getRealClockTime", ScriptMethodFunctor(this, &ApplicationSystem::ScriptGetRealClockTime));
       AddScriptedMethod("changeTimeSettings", ScriptMethodFunctor(this, &ApplicationSystem::ScriptChangeTimeSettings));
+      AddScriptedMethod("getMessageStatistics", ScriptMethodFunctor(this, &ApplicationSystem::ScriptGetMessageStatistics));
+      AddScriptedMethod("resetMessageStatistics", ScriptMethodFunctor(this, &ApplicationSystem::ScriptResetMessageStatistics));
+      AddScriptedMethod("getMemoryStatistics", ScriptMethodFunctor(this, &ApplicationSystem::ScriptGetMemoryStatistics));
+      AddScriptedMethod("getMemoryReport", ScriptMethodFunctor(this, &ApplicationSystem::ScriptGetMemoryReport));
 
       mSetComponentPropertiesFunctor = MessageFunctor(this, &ApplicationSystem::OnSetComponentProperties);
       em.RegisterForMessages(SetComponentPropertiesMessage::TYPE, mSetComponentPropertiesFunctor, "ApplicationSystem::OnSetComponentProperties");
@@ -122,6 +133,154 @@ namespace dtEntity
 
    }
 
+   ///////////////////////////////////////////////////////////////////////////////
+   void ApplicationSystem::SetMessageStatisticsEnabled(bool v)
+   {
+      GetEntityManager().GetMessagePump().SetStatisticsEnabled(v);
+   }
+
+   ///////////////////////////////////////////////////////////////////////////////
+   bool ApplicationSystem::GetMessageStatisticsEnabled() const
+   {
+      return GetEntityManager().GetMessagePump().GetStatisticsEnabled();
+   }
+
+   ///////////////////////////////////////////////////////////////////////////////
+   Property* ApplicationSystem::ScriptGetMessageStatistics(const PropertyArgs& args)
+   {
+      MessagePump::StatisticsMap stats;
+      GetEntityManager().GetMessagePump().GetStatistics(stats);
+
+      static const StringId numEmittedId = SID("NumEmitted");
+      static const StringId numEnqueuedId = SID("NumEnqueued");
+      static const StringId numSubscribersId = SID("NumSubscribers");
+      static const StringId totalDispatchTimeId = SID("TotalDispatchTime");
+      static const StringId maxDispatchTimeId = SID("MaxDispatchTime");
+      static const StringId queueDepthId = SID("QueueDepth");
+      static const StringId maxQueueDepthId = SID("MaxQueueDepth");
+
+      GroupProperty* ret = new GroupProperty();
+      for(MessagePump::StatisticsMap::const_iterator i = stats.begin(); i != stats.end(); ++i)
+      {
+         const MessageTypeStatistics& s = i->second;
+         GroupProperty* entry = new GroupProperty();
+         entry->Add(numEmittedId, new UIntProperty(s.mNumEmitted));
+         entry->Add(numEnqueuedId, new UIntProperty(s.mNumEnqueued));
+         entry->Add(numSubscribersId, new UIntProperty(s.mNumSubscribers));
+         entry->Add(totalDispatchTimeId, new DoubleProperty(s.mTotalDispatchTime));
+         entry->Add(maxDispatchTimeId, new DoubleProperty(s.mMaxDispatchTime));
+         entry->Add(queueDepthId, new UIntProperty(s.mQueueDepth));
+         entry->Add(maxQueueDepthId, new UIntProperty(s.mMaxQueueDepth));
+         ret->Add(i->first, entry);
+      }
+      return ret;
+   }
+
+   ///////////////////////////////////////////////////////////////////////////////
+   Property* ApplicationSystem::ScriptResetMessageStatistics(const PropertyArgs& args)
+   {
+      GetEntityManager().GetMessagePump().ResetStatistics();
+      return NULL;
+   }
+
+   ///////////////////////////////////////////////////////////////////////////////
+   Property* ApplicationSystem::ScriptGetMemoryStatistics(const PropertyArgs& args)
+   {
+      EntityManager::MemoryStatisticsMap stats;
+      GetEntityManager().GetMemoryStatistics(stats);
+
+      static const StringId numComponentsId = SID("NumComponents");
+      static const StringId peakNumComponentsId = SID("PeakNumComponents");
+      static const StringId numAllocationsId = SID("NumAllocations");
+      static const StringId bytesAllocatedId = SID("BytesAllocated");
+      static const StringId peakBytesAllocatedId = SID("PeakBytesAllocated");
+
+      GroupProperty* ret = new GroupProperty();
+      for(EntityManager::MemoryStatisticsMap::const_iterator i = stats.begin(); i != stats.end(); ++i)
+      {
+         const ComponentMemoryStatistics& s = i->second;
+         GroupProperty* entry = new GroupProperty();
+         entry->Add(numComponentsId, new UIntProperty(s.mNumComponents));
+         entry->Add(peakNumComponentsId, new UIntProperty(s.mPeakNumComponents));
+         entry->Add(numAllocationsId, new UIntProperty(s.mNumAllocations));
+         entry->Add(bytesAllocatedId, new DoubleProperty(static_cast<double>(s.mBytesAllocated)));
+         entry->Add(peakBytesAllocatedId, new DoubleProperty(static_cast<double>(s.mPeakBytesAllocated)));
+         ret->Add(i->first, entry);
+      }
+      return ret;
+   }
+
+   ///////////////////////////////////////////////////////////////////////////////
+   std::string ApplicationSystem::GetMemoryReport() const
+   {
+      EntityManager::MemoryStatisticsMap stats;
+      GetEntityManager().GetMemoryStatistics(stats);
+
+      std::ostringstream os;
+      os << std::left << std::setw(32) << "Component type"
+         << std::right << std::setw(12) << "Count"
+         << std::setw(12) << "Peak"
+         << std::setw(14) << "Bytes"
+         << std::setw(14) << "Peak bytes" << "\n";
+
+      unsigned int totalComponents = 0;
+      std::size_t totalBytes = 0;
+      for(EntityManager::MemoryStatisticsMap::const_iterator i = stats.begin(); i != stats.end(); ++i)
+      {
+         const ComponentMemoryStatistics& s = i->second;
+         os << std::left << std::setw(32) << GetStringFromSID(i->first)
+            << std::right << std::setw(12) << s.mNumComponents
+            << std::setw(12) << s.mPeakNumComponents
+            << std::setw(14) << s.mBytesAllocated
+            << std::setw(14) << s.mPeakBytesAllocated << "\n";
+         totalComponents += s.mNumComponents;
+         totalBytes += s.mBytesAllocated;
+      }
+      os << std::left << std::setw(32) << "Total"
+         << std::right << std::setw(12) << totalComponents
+         << std::setw(12) << ""
+         << std::setw(14) << totalBytes << "\n";
+      return os.str();
+   }
+
+   ///////////////////////////////////////////////////////////////////////////////
+   std::string ApplicationSystem::GetMessageStatisticsReport() const
+   {
+      std::ostringstream os;
+      if(!GetMessageStatisticsEnabled())
+      {
+         os << "Message statistics are disabled, set MessageStatisticsEnabled "
+            << "of the application system to collect them.\n";
+      }
+
+      MessagePump::StatisticsMap stats;
+      GetEntityManager().GetMessagePump().GetStatistics(stats);
+
+      os << std::left << std::setw(32) << "Message type"
+         << std::right << std::setw(10) << "Emitted"
+         << std::setw(10) << "Enqueued"
+         << std::setw(8) << "Subs"
+         << std::setw(12) << "Total ms"
+         << std::setw(10) << "Max ms"
+         << std::setw(8) << "Queue"
+         << std::setw(10) << "Max queue" << "\n";
+
+      os << std::fixed << std::setprecision(3);
+      for(MessagePump::StatisticsMap::const_iterator i = stats.begin(); i != stats.end(); ++i)
+      {
+         const MessageTypeStatistics& s = i->second;
+         os << std::left << std::setw(32) << GetStringFromSID(i->first)
+            << std::right << std::setw(10) << s.mNumEmitted
+            << std::setw(10) << s.mNumEnqueued
+            << std::setw(8) << s.mNumSubscribers
+            << std::setw(12) << s.mTotalDispatchTime * 1000.0
+            << std::setw(10) << s.mMaxDispatchTime * 1000.0
+            << std::setw(8) << s.mQueueDepth
+            << std::setw(10) << s.mMaxQueueDepth << "\n";
+      }
+      return os.str();
+   }
+
    ///////////////////////////////////////////////////////////////////////////////
    Property* ApplicationSystem::ScriptChangeTimeSettings(const PropertyArgs& args)
    {
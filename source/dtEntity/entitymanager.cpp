@@ -30,6 +30,10 @@
 #include <dtEntity/systemmessages.h>
 #include <float.h>
 
+#if DTENTITY_PROFILING_ENABLED
+#include <dtEntity/profile.h>
+#endif
+
 namespace dtEntity
 {
 
@@ -208,6 +212,9 @@ namespace dtEntity
    ////////////////////////////////////////////////////////////////////////////////
    bool EntityManager::GetEntity(EntityId id, Entity*& entity)
    {
+#if DTENTITY_PROFILING_ENABLED
+      PROFILE_LOOKUP(ProfileLookup::GET_ENTITY, StringId());
+#endif
       OpenThreads::ScopedReadLock lock(mEntityMutex);
       EntityMap::const_iterator it = mEntities.find(id);
       if(it == mEntities.end()) return false;
@@ -358,9 +365,26 @@ namespace dtEntity
       }
    }
 
+   ////////////////////////////////////////////////////////////////////////////////
+   void EntityManager::GetMemoryStatistics(MemoryStatisticsMap& toFill) const
+   {
+      EntitySystemStore::const_iterator i = mEntitySystemStore.begin();
+      for(; i != mEntitySystemStore.end(); ++i)
+      {
+         ComponentMemoryStatistics stats;
+         if(i->second->GetMemoryStatistics(stats))
+         {
+            toFill[i->first] = stats;
+         }
+      }
+   }
+
    ////////////////////////////////////////////////////////////////////////////////
    bool EntityManager::GetComponent(EntityId eid, ComponentType t, Component*& component, bool searchDerived)
    {
+#if DTENTITY_PROFILING_ENABLED
+      PROFILE_LOOKUP(searchDerived ? ProfileLookup::GET_COMPONENT_DERIVED : ProfileLookup::GET_COMPONENT, t);
+#endif
       EntitySystem* es;
       
       if(GetEntitySystem(t, es) && es->GetComponent(eid, component))
@@ -384,6 +408,9 @@ namespace dtEntity
       TypeHierarchyMap::const_iterator it = keyRange.first;
       while(it != keyRange.second)
       {
+#if DTENTITY_PROFILING_ENABLED
+         PROFILE_LOOKUP(ProfileLookup::DERIVED_SEARCH_STEP, it->second);
+#endif
          dtEntity::EntitySystem* es;
          bool success = this->GetEntitySystem(it->second, es);
          if(!success)
@@ -441,6 +468,9 @@ namespace dtEntity
    ////////////////////////////////////////////////////////////////////////////////
    bool EntityManager::HasComponent(EntityId eid, ComponentType t, bool searchDerived) const
    {
+#if DTENTITY_PROFILING_ENABLED
+      PROFILE_LOOKUP(ProfileLookup::HAS_COMPONENT, t);
+#endif
       EntitySystem* es;
       if(GetEntitySystem(t, es) && es->HasComponent(eid))
       {
@@ -0,0 +1,173 @@
+/*
+* dtEntity Game and Simulation Engine
+*
+* This library is free software; you can redistribute it and/or modify it under
+* the terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; either version 2.1 of the License, or (at your option)
+* any later version.
+*
+* This library is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+* details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this library; if not, write to the Free Software Foundation, Inc.,
+* 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*
+* Martin Scheffler
+*/
+
+#include <dtEntity/headlesssysteminterface.h>
+
+#include <dtEntity/messagepump.h>
+#include <dtEntity/systemmessages.h>
+#include <osg/Timer>
+#include <osgDB/FileUtils>
+
+namespace dtEntity
+{
+   ////////////////////////////////////////////////////////////////////////////////
+   HeadlessSystemInterface::HeadlessSystemInterface(MessagePump& mp)
+      : mMessagePump(&mp)
+      , mFixedTimeStep(1.0f / 60.0f)
+      , mTimeScale(1)
+      , mDeltaSimTime(0)
+      , mDeltaRealTime(0)
+      , mSimTime(0)
+      , mClockOffset(0)
+      , mNumTicks(0)
+   {
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   HeadlessSystemInterface::~HeadlessSystemInterface()
+   {
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void HeadlessSystemInterface::EmitTickMessagesAndQueuedMessages()
+   {
+      mDeltaRealTime = mFixedTimeStep;
+      mDeltaSimTime = mFixedTimeStep * mTimeScale;
+      mSimTime += mDeltaSimTime;
+      ++mNumTicks;
+
+      {
+         PostFrameMessage msg;
+         msg.SetDeltaSimTime(mDeltaSimTime);
+         msg.SetDeltaRealTime(mDeltaRealTime);
+         msg.SetSimTimeScale(mTimeScale);
+         msg.SetSimulationTime(mSimTime);
+         mMessagePump->EmitMessage(msg);
+      }
+
+      {
+         TickMessage msg;
+         msg.SetDeltaSimTime(mDeltaSimTime);
+         msg.SetDeltaRealTime(mDeltaRealTime);
+         msg.SetSimTimeScale(mTimeScale);
+         msg.SetSimulationTime(mSimTime);
+         mMessagePump->EmitMessage(msg);
+      }
+
+      mMessagePump->EmitQueuedMessages(mSimTime);
+
+      {
+         EndOfFrameMessage msg;
+         msg.SetDeltaSimTime(mDeltaSimTime);
+         msg.SetDeltaRealTime(mDeltaRealTime);
+         msg.SetSimTimeScale(mTimeScale);
+         msg.SetSimulationTime(mSimTime);
+         mMessagePump->EmitMessage(msg);
+      }
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   float HeadlessSystemInterface::GetDeltaSimTime() const
+   {
+      return mDeltaSimTime;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   float HeadlessSystemInterface::GetDeltaRealTime() const
+   {
+      return mDeltaRealTime;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   float HeadlessSystemInterface::GetTimeScale() const
+   {
+      return mTimeScale;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void HeadlessSystemInterface::SetTimeScale(float v)
+   {
+      mTimeScale = v;
+      EmitTimeChanged();
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   double HeadlessSystemInterface::GetSimulationTime() const
+   {
+      return mSimTime;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void HeadlessSystemInterface::SetSimulationTime(double v)
+   {
+      // keep clock time unchanged
+      mClockOffset = GetSimulationClockTime() - static_cast<Timer_t>(v * 1000000.0);
+      mSimTime = v;
+      EmitTimeChanged();
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   Timer_t HeadlessSystemInterface::GetSimulationClockTime() const
+   {
+      return mClockOffset + static_cast<Timer_t>(mSimTime * 1000000.0);
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void HeadlessSystemInterface::SetSimulationClockTime(Timer_t t)
+   {
+      mClockOffset = t - static_cast<Timer_t>(mSimTime * 1000000.0);
+      EmitTimeChanged();
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   Timer_t HeadlessSystemInterface::GetRealClockTime()
+   {
+      return osg::Timer::instance()->tick();
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   bool HeadlessSystemInterface::GetIntersections(const Vec3d& start, const Vec3d& end,
+      std::vector<Intersection>& isects, unsigned int nodemask) const
+   {
+      return false;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   std::string HeadlessSystemInterface::FindDataFile(const std::string& filename)
+   {
+      return osgDB::findDataFile(filename);
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   bool HeadlessSystemInterface::FileExists(const std::string& filename)
+   {
+      return osgDB::fileExists(filename);
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void HeadlessSystemInterface::EmitTimeChanged()
+   {
+      TimeChangedMessage msg;
+      msg.SetSimulationTime(GetSimulationTime());
+      msg.SetSimulationClockTime(GetSimulationClockTime());
+      msg.SetTimeScale(GetTimeScale());
+      mMessagePump->EmitMessage(msg);
+   }
+}
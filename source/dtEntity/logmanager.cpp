@@ -20,21 +20,125 @@
 
 #include <dtEntity/logmanager.h>
 
+#include <OpenThreads/ScopedLock>
+#include <OpenThreads/Thread>
+#include <sstream>
 
 namespace dtEntity
 {
+   ////////////////////////////////////////////////////////////////////////////////
+   // higher values are more severe
+   static int GetSeverity(LogLevel::e level)
+   {
+      switch(level)
+      {
+      case LogLevel::LVL_DEBUG:   return 0;
+      case LogLevel::LVL_INFO:    return 1;
+      case LogLevel::LVL_WARNING: return 2;
+      case LogLevel::LVL_ERROR:   return 3;
+      default:                    return 4;
+      }
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   // counts a log call as reader of the listener lists while in scope
+   class ReaderGuard
+   {
+   public:
+      ReaderGuard(OpenThreads::Atomic& numReaders)
+         : mNumReaders(&numReaders)
+      {
+         ++(*mNumReaders);
+      }
+
+      ~ReaderGuard()
+      {
+         --(*mNumReaders);
+      }
+
+   private:
+      OpenThreads::Atomic* mNumReaders;
+   };
+
+   ////////////////////////////////////////////////////////////////////////////////
+   LogManager::LogManager()
+      : mLogLevel(LogLevel::LVL_DEBUG)
+      , mEnabledLevels(0)
+      , mListeners(new Listeners())
+      , mNumReaders(0)
+   {
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   LogManager::~LogManager()
+   {
+      delete static_cast<Listeners*>(mListeners.get());
+      for(std::vector<Listeners*>::iterator i = mOldListeners.begin(); i != mOldListeners.end(); ++i)
+      {
+         delete *i;
+      }
+   }
+
    ////////////////////////////////////////////////////////////////////////////////
    void LogManager::LogMessage(LogLevel::e level, const std::string& filename, const std::string& methodname, int linenumber,
                    const std::string& msg) const
    {
-      Listeners listeners;
+      // reader is counted before the list is loaded, so a list replaced after
+      // this point is not deleted while it is iterated
+      ReaderGuard guard(mNumReaders);
+      const Listeners* listeners = static_cast<const Listeners*>(mListeners.get());
+      for(Listeners::const_iterator i = listeners->begin(); i != listeners->end(); ++i)
       {
-         OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
-         listeners = mListeners;
+         (*i)->LogMessage(level, filename, methodname, linenumber, msg);
       }
-      for(Listeners::iterator i = listeners.begin(); i != listeners.end(); ++i)
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void LogManager::SetLogLevel(LogLevel::e level)
+   {
+      OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+      mLogLevel = level;
+      UpdateEnabledLevels();
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void LogManager::UpdateEnabledLevels()
+   {
+      unsigned int enabled = 0;
+      if(!static_cast<Listeners*>(mListeners.get())->empty())
       {
-         (*i)->LogMessage(level, filename, methodname, linenumber, msg);
+         LogLevel::e levels[5] = { LogLevel::LVL_ALWAYS, LogLevel::LVL_ERROR,
+            LogLevel::LVL_DEBUG, LogLevel::LVL_WARNING, LogLevel::LVL_INFO };
+         for(unsigned int i = 0; i < 5; ++i)
+         {
+            if(levels[i] == LogLevel::LVL_ALWAYS || GetSeverity(levels[i]) >= GetSeverity(mLogLevel))
+            {
+               enabled |= 1u << levels[i];
+            }
+         }
+      }
+      mEnabledLevels = enabled;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void LogManager::SetListeners(Listeners* listeners)
+   {
+      Listeners* old = static_cast<Listeners*>(mListeners.get());
+      mListeners.assign(listeners, old);
+      mOldListeners.push_back(old);
+      UpdateEnabledLevels();
+
+      // A log call starting from now on loads the new list. If no call is in
+      // progress, none can still hold an old list and they can be deleted.
+      // This releases removed listeners, stopping threads of async listeners
+      if(mNumReaders == 0)
+      {
+         std::vector<Listeners*> quiescent;
+         quiescent.swap(mOldListeners);
+         for(std::vector<Listeners*>::iterator i = quiescent.begin(); i != quiescent.end(); ++i)
+         {
+            delete *i;
+         }
       }
    }
 
@@ -42,7 +146,9 @@ namespace dtEntity
    void LogManager::AddListener(LogListener* l)
    {
       OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
-      mListeners.push_back(l);
+      Listeners* listeners = new Listeners(*static_cast<Listeners*>(mListeners.get()));
+      listeners->push_back(l);
+      SetListeners(listeners);
    }
 
    ////////////////////////////////////////////////////////////////////////////////
@@ -50,11 +156,14 @@ namespace dtEntity
    {
       OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
 
-      for(Listeners::iterator i = mListeners.begin(); i != mListeners.end(); ++i)
+      const Listeners* current = static_cast<Listeners*>(mListeners.get());
+      for(Listeners::const_iterator i = current->begin(); i != current->end(); ++i)
       {
          if(*i == l)
          {
-            mListeners.erase(i);
+            Listeners* listeners = new Listeners(*current);
+            listeners->erase(listeners->begin() + (i - current->begin()));
+            SetListeners(listeners);
             return;
          }
       }
@@ -63,14 +172,141 @@ namespace dtEntity
    ////////////////////////////////////////////////////////////////////////////////
    LogManager::Listeners::size_type LogManager::GetNumListeners() const
    {
-      OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
-      return mListeners.size();
+      return static_cast<const Listeners*>(mListeners.get())->size();
    }
 
    ////////////////////////////////////////////////////////////////////////////////
    LogListener* LogManager::GetListener(LogManager::Listeners::size_type index) const
+   {
+      return (*static_cast<const Listeners*>(mListeners.get()))[index].get();
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   ////////////////////////////////////////////////////////////////////////////////
+   class AsyncLogListener::WriterThread : public OpenThreads::Thread
+   {
+   public:
+      WriterThread(AsyncLogListener& listener)
+         : mListener(&listener)
+      {
+      }
+
+      virtual void run()
+      {
+         mListener->Run();
+      }
+
+   private:
+      AsyncLogListener* mListener;
+   };
+
+   ////////////////////////////////////////////////////////////////////////////////
+   AsyncLogListener::AsyncLogListener(LogListener* target, unsigned int capacity)
+      : mTarget(target)
+      , mRecords(capacity > 0 ? capacity : 1)
+      , mFirst(0)
+      , mCount(0)
+      , mWriting(false)
+      , mQuit(false)
+      , mNumDropped(0)
+      , mNumDroppedReported(0)
+   {
+      mThread = new WriterThread(*this);
+      mThread->start();
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   AsyncLogListener::~AsyncLogListener()
+   {
+      {
+         OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+         mQuit = true;
+         mCondition.broadcast();
+      }
+      mThread->join();
+      delete mThread;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void AsyncLogListener::LogMessage(LogLevel::e level, const std::string& filename, const std::string& methodname, int linenumber,
+                   const std::string& msg)
    {
       OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
-      return mListeners[index];
+      if(mCount == mRecords.size())
+      {
+         ++mNumDropped;
+         return;
+      }
+      Record& r = mRecords[(mFirst + mCount) % mRecords.size()];
+      r.mLevel = level;
+      r.mFilename.assign(filename);
+      r.mMethodname.assign(methodname);
+      r.mLinenumber = linenumber;
+      r.mMsg.assign(msg);
+      ++mCount;
+      // Flush may be waiting on the same condition, so wake all
+      mCondition.broadcast();
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void AsyncLogListener::Flush()
+   {
+      OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+      while(mCount > 0 || mWriting)
+      {
+         mCondition.wait(&mMutex);
+      }
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   unsigned int AsyncLogListener::GetNumDropped() const
+   {
+      OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+      return mNumDropped;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void AsyncLogListener::Run()
+   {
+      // message is swapped into this record, so the ring buffer slot
+      // can be reused while the target writes it
+      Record current;
+      while(true)
+      {
+         unsigned int dropped = 0;
+         {
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+            mWriting = false;
+            // wake threads waiting in Flush
+            mCondition.broadcast();
+            while(mCount == 0 && !mQuit)
+            {
+               mCondition.wait(&mMutex);
+            }
+            if(mCount == 0)
+            {
+               return;
+            }
+            Record& r = mRecords[mFirst];
+            current.mLevel = r.mLevel;
+            current.mFilename.swap(r.mFilename);
+            current.mMethodname.swap(r.mMethodname);
+            current.mLinenumber = r.mLinenumber;
+            current.mMsg.swap(r.mMsg);
+            mFirst = (mFirst + 1) % mRecords.size();
+            --mCount;
+            mWriting = true;
+            dropped = mNumDropped - mNumDroppedReported;
+            mNumDroppedReported = mNumDropped;
+         }
+
+         if(dropped > 0)
+         {
+            std::ostringstream os;
+            os << dropped << " log messages were dropped, log buffer was full";
+            mTarget->LogMessage(LogLevel::LVL_WARNING, __FILE__, __FUNCTION__, __LINE__, os.str());
+         }
+         mTarget->LogMessage(current.mLevel, current.mFilename, current.mMethodname, current.mLinenumber, current.mMsg);
+      }
    }
 }
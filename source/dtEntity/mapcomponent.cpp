@@ -35,6 +35,10 @@
 #include <OpenThreads/ScopedLock>
 #include <fstream>
 
+#if DTENTITY_PROFILING_ENABLED
+#include <dtEntity/profile.h>
+#endif
+
 #if PROTOBUF_FOUND
 #include <dtEntity/protobufmapencoder.h>
 #endif
@@ -284,6 +288,9 @@ namespace dtEntity
    ////////////////////////////////////////////////////////////////////////////
    bool MapSystem::LoadScene(const std::string& path)
    {
+#if DTENTITY_PROFILING_ENABLED
+      PROFILE_CATEGORY_SCOPE(ProfileCategory::IO, "MapSystem::LoadScene");
+#endif
       // get data path containing this map
       std::string scenedatapath = "";
       osgDB::FilePathList paths = osgDB::getDataFilePathList();
@@ -374,6 +381,9 @@ namespace dtEntity
    ////////////////////////////////////////////////////////////////////////////
    bool MapSystem::LoadMap(const std::string& path)
    {
+#if DTENTITY_PROFILING_ENABLED
+      PROFILE_CATEGORY_SCOPE(ProfileCategory::IO, "MapSystem::LoadMap");
+#endif
       if(IsMapLoaded(path))
       {
          LOG_ERROR("Map already loaded: " + path);
@@ -22,6 +22,7 @@
 
 #include <dtEntity/dtentity_config.h>
 #include <dtEntity/log.h>
+#include <osg/Timer>
 
 #if DTENTITY_PROFILING_ENABLED
 #include <dtEntity/profile.h>
@@ -30,7 +31,21 @@
 namespace dtEntity
 {
 
+   MessageTypeStatistics::MessageTypeStatistics()
+      : mNumEmitted(0)
+      , mNumEnqueued(0)
+      , mNumSubscribers(0)
+      , mTotalDispatchTime(0)
+      , mMaxDispatchTime(0)
+      , mQueueDepth(0)
+      , mMaxQueueDepth(0)
+   {
+   }
+
+   ///////////////////////////////////////////////////////////////////////////////////////////////////////
    MessagePump::MessagePump() 
+      : mStatisticsEnabled(false)
+      , mSubscriberTimingEnabled(false)
    {     
    }
 
@@ -116,6 +131,9 @@ namespace dtEntity
          LOG_ERROR("Trying to send a message with an empty type string!");
          return;
       }
+#if DTENTITY_PROFILING_ENABLED
+      CProfileCategorySample messageSample(ProfileCategory::MESSAGES, messageType);
+#endif
       std::pair<MessageFunctorRegistry::iterator, MessageFunctorRegistry::iterator> keyRange;
       keyRange = mMessageFunctors.equal_range(messageType);
       
@@ -149,28 +167,85 @@ namespace dtEntity
          ++it;
       }
 
+      bool statisticsEnabled = mStatisticsEnabled;
+      osg::Timer_t start = statisticsEnabled ? osg::Timer::instance()->tick() : 0;
+
       FunctorsToCall::iterator j;
       for(j = functorsToCall.begin(); j != functorsToCall.end(); ++j)
       {
 #if DTENTITY_PROFILING_ENABLED
-         CProfileManager::Start_Profile(j->second);
-#endif
-         (j->first)(msg);
-#if DTENTITY_PROFILING_ENABLED
-         CProfileManager::Stop_Profile();
+         CProfileCategorySample subscriberSample(ProfileCategory::SYSTEMS, j->second);
 #endif
+         if(mSubscriberTimingEnabled)
+         {
+            osg::Timer_t substart = osg::Timer::instance()->tick();
+            (j->first)(msg);
+            SubscriberTiming& timing = mSubscriberTimings[j->second];
+            ++timing.mNumCalls;
+            timing.mTime += osg::Timer::instance()->delta_s(substart, osg::Timer::instance()->tick());
+         }
+         else
+         {
+            (j->first)(msg);
+         }
+      }
+
+      if(statisticsEnabled)
+      {
+         double dt = osg::Timer::instance()->delta_s(start, osg::Timer::instance()->tick());
+         OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mStatisticsMutex);
+         MessageTypeStatistics& stats = mStatistics[messageType];
+         ++stats.mNumEmitted;
+         stats.mTotalDispatchTime += dt;
+         if(dt > stats.mMaxDispatchTime)
+         {
+            stats.mMaxDispatchTime = dt;
+         }
+      }
+   }
+
+   ///////////////////////////////////////////////////////////////////////////////
+   void MessagePump::CountEnqueued(MessageType msgtype)
+   {
+      OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mStatisticsMutex);
+      MessageTypeStatistics& stats = mStatistics[msgtype];
+      ++stats.mNumEnqueued;
+      ++stats.mQueueDepth;
+      if(stats.mQueueDepth > stats.mMaxQueueDepth)
+      {
+         stats.mMaxQueueDepth = stats.mQueueDepth;
+      }
+   }
+
+   ///////////////////////////////////////////////////////////////////////////////
+   void MessagePump::CountDequeued(MessageType msgtype)
+   {
+      OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mStatisticsMutex);
+      StatisticsMap::iterator i = mStatistics.find(msgtype);
+      // message may have been enqueued before statistics were enabled
+      if(i != mStatistics.end() && i->second.mQueueDepth > 0)
+      {
+         --i->second.mQueueDepth;
       }
    }
 
    ///////////////////////////////////////////////////////////////////////////////
    void MessagePump::EnqueueMessage(const Message& msg)
    {
+      if(mStatisticsEnabled)
+      {
+         CountEnqueued(msg.GetType());
+      }
       mMessageQueue.Push(msg.Clone());
    }
 
    ///////////////////////////////////////////////////////////////////////////////
    void MessagePump::EnqueueMessage(const Message& msg, double when)
    {
+      if(mStatisticsEnabled)
+      {
+         CountEnqueued(msg.GetType());
+      }
       if(when <= 0.001)
       {
          mMessageQueue.Push(msg.Clone());
@@ -191,6 +266,10 @@ namespace dtEntity
       while(!mMessageQueue.Empty())
       {
          const Message* entry = mMessageQueue.Pop();
+         if(mStatisticsEnabled)
+         {
+            CountDequeued(entry->GetType());
+         }
          EmitMessage(*entry);
          delete entry;
       }
@@ -210,6 +289,10 @@ namespace dtEntity
             
             if(entry.mTimeToPost <= now)
             {
+               if(mStatisticsEnabled)
+               {
+                  CountDequeued(entry.mMessage->GetType());
+               }
                EmitMessage(*entry.mMessage);
                delete entry.mMessage;
                i = mFutureMessages.erase(i);               
@@ -239,6 +322,12 @@ namespace dtEntity
          delete i->mMessage;
       }
       mFutureMessages.clear();
+
+      OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mStatisticsMutex);
+      for(StatisticsMap::iterator i = mStatistics.begin(); i != mStatistics.end(); ++i)
+      {
+         i->second.mQueueDepth = 0;
+      }
    }
 
    ///////////////////////////////////////////////////////////////////////////////
@@ -246,5 +335,73 @@ namespace dtEntity
    {
       mMessageFunctors.clear();
    }
+
+   ///////////////////////////////////////////////////////////////////////////////
+   unsigned int MessagePump::GetNumSubscribers(MessageType msgtype) const
+   {
+      unsigned int count = 0;
+      std::pair<MessageFunctorRegistry::const_iterator, MessageFunctorRegistry::const_iterator> keyRange;
+      keyRange = mMessageFunctors.equal_range(msgtype);
+      for(MessageFunctorRegistry::const_iterator it = keyRange.first; it != keyRange.second; ++it)
+      {
+         if((it->second.mOptions & FilterOptions::UNREGISTERED) == 0)
+         {
+            ++count;
+         }
+      }
+      return count;
+   }
+
+   ///////////////////////////////////////////////////////////////////////////////
+   bool MessagePump::GetStatistics(MessageType msgtype, MessageTypeStatistics& stats) const
+   {
+      {
+         OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mStatisticsMutex);
+         StatisticsMap::const_iterator i = mStatistics.find(msgtype);
+         if(i == mStatistics.end())
+         {
+            return false;
+         }
+         stats = i->second;
+      }
+      stats.mNumSubscribers = GetNumSubscribers(msgtype);
+      return true;
+   }
+
+   ///////////////////////////////////////////////////////////////////////////////
+   void MessagePump::GetStatistics(StatisticsMap& stats) const
+   {
+      {
+         OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mStatisticsMutex);
+         stats = mStatistics;
+      }
+      for(StatisticsMap::iterator i = stats.begin(); i != stats.end(); ++i)
+      {
+         i->second.mNumSubscribers = GetNumSubscribers(i->first);
+      }
+   }
+
+   ///////////////////////////////////////////////////////////////////////////////
+   void MessagePump::ResetStatistics()
+   {
+      OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mStatisticsMutex);
+      // keep queue depths, messages are still in the queue
+      for(StatisticsMap::iterator i = mStatistics.begin(); i != mStatistics.end(); ++i)
+      {
+         MessageTypeStatistics stats;
+         stats.mQueueDepth = i->second.mQueueDepth;
+         stats.mMaxQueueDepth = i->second.mQueueDepth;
+         i->second = stats;
+      }
+   }
+
+   ///////////////////////////////////////////////////////////////////////////////
+   void MessagePump::ResetSubscriberTimings()
+   {
+      for(SubscriberTimingMap::iterator i = mSubscriberTimings.begin(); i != mSubscriberTimings.end(); ++i)
+      {
+         i->second = SubscriberTiming();
+      }
+   }
 }
 
@@ -10,35 +10,212 @@
 
 #include <dtEntity/profile.h>
 #include <stdio.h>
+#include <algorithm>
+#include <fstream>
+#include <OpenThreads/Atomic>
+#include <OpenThreads/Mutex>
+#include <OpenThreads/ScopedLock>
 #include <osg/Timer>
+#include <map>
 
-#ifdef _WIN32
-#include <windows.h>
+#if !defined(_WIN32)
+#include <dlfcn.h>
 #endif
+
+#if defined(_MSC_VER)
+#define PROFILE_THREAD_LOCAL __declspec(thread)
+#else
+#define PROFILE_THREAD_LOCAL __thread
+#endif
+
 #define DBL_EPSILON    2.2204460492503131e-016
 inline void Profile_Get_Ticks(dtEntity::Timer_t * ticks)
 {
-	osg::Timer timer;
-	 *ticks = timer.tick();
+	*ticks = osg::Timer::instance()->tick();
 }
 
 inline float Profile_Get_Tick_Rate(void)
 {
-#ifdef _WIN32
-	static float _CPUFrequency = -1.0f;
-	
-	if (_CPUFrequency == -1.0f) {
-            osg::Timer_t curr_rate = 0;
-		::QueryPerformanceFrequency ((LARGE_INTEGER *)&curr_rate);
-		_CPUFrequency = (float)curr_rate;
-	} 
-	
-	return _CPUFrequency;
-#else
-	return 1000000.f;
-#endif
+	static float _TickRate = (float)(1.0 / osg::Timer::instance()->getSecondsPerTick());
+	return _TickRate;
 }
 
+/***************************************************************************************************
+**
+** CProfileThread
+**
+** Profile tree of a single thread. Only the owning thread modifies the tree,
+** reports read it without locking.
+**
+***************************************************************************************************/
+struct CProfileTraceEvent
+{
+	dtEntity::StringId	Name;
+	dtEntity::Timer_t		StartTime;
+	dtEntity::Timer_t		EndTime;
+};
+
+struct CProfileOpenScope
+{
+	dtEntity::Timer_t		StartTime;
+	int						Depth;
+};
+
+struct CProfileLookupKey
+{
+	int						Kind;
+	dtEntity::StringId	ComponentType;
+	dtEntity::StringId	Caller;
+	const void *			CallSite;
+
+	bool operator<( const CProfileLookupKey& other ) const
+	{
+		if (Kind != other.Kind) return Kind < other.Kind;
+		if (ComponentType != other.ComponentType) return ComponentType < other.ComponentType;
+		if (Caller != other.Caller) return Caller < other.Caller;
+		return CallSite < other.CallSite;
+	}
+};
+
+typedef std::map<CProfileLookupKey, unsigned int> CProfileLookupMap;
+
+/*
+** Fixed size hash table of lookup counts of one thread. Only the owning thread
+** writes, reports read without locking and may see slightly outdated counts.
+** The key of a slot is written once before the slot is published and is never
+** changed afterwards, resetting only clears the counts.
+*/
+class CProfileLookupTable
+{
+public:
+	enum { NUM_SLOTS = 512, MAX_PROBES = 16 };
+
+	CProfileLookupTable()
+	{
+		for (unsigned int i = 0; i < NUM_SLOTS; i++) {
+			Slots[i].Count = 0;
+		}
+	}
+
+	void Add( const CProfileLookupKey& key )
+	{
+		unsigned int hash = (unsigned int)key.Kind * 2654435761u
+			^ dtEntity::SIDToUInt(key.ComponentType) * 40503u
+			^ dtEntity::SIDToUInt(key.Caller)
+			^ (unsigned int)(size_t)key.CallSite;
+		for (unsigned int probe = 0; probe < MAX_PROBES; probe++)
+		{
+			Slot& slot = Slots[(hash + probe) % NUM_SLOTS];
+			if (slot.Used == 0) {
+				slot.Key = key;
+				slot.Count = 1;
+				// publish after key and count are written
+				++slot.Used;
+				return;
+			}
+			if (slot.Key.Kind == key.Kind && slot.Key.ComponentType == key.ComponentType &&
+				slot.Key.Caller == key.Caller && slot.Key.CallSite == key.CallSite) {
+				slot.Count = slot.Count + 1;
+				return;
+			}
+		}
+		// table is full around this key, lookup is only in the totals of its kind
+	}
+
+	void Reset( void )
+	{
+		for (unsigned int i = 0; i < NUM_SLOTS; i++) {
+			Slots[i].Count = 0;
+		}
+	}
+
+	void Sum( CProfileLookupMap& sum ) const
+	{
+		for (unsigned int i = 0; i < NUM_SLOTS; i++) {
+			unsigned int count = Slots[i].Count;
+			if (Slots[i].Used != 0 && count != 0) {
+				sum[Slots[i].Key] += count;
+			}
+		}
+	}
+
+private:
+	struct Slot
+	{
+		CProfileLookupKey				Key;
+		volatile unsigned int		Count;
+		OpenThreads::Atomic			Used;
+	};
+
+	Slot						Slots[NUM_SLOTS];
+};
+
+class CProfileThread
+{
+public:
+	CProfileThread( int index ) :
+		Root( dtEntity::SID("Root"), NULL ),
+		CurrentNode( &Root ),
+		FrameCounter( 0 ),
+		ResetGeneration( 0 ),
+		Index( index ),
+		Depth( 0 ),
+		CaptureGeneration( 0 ),
+		NextEvent( 0 ),
+		NumEvents( 0 ),
+		LookupsUntilSample( 1 )
+	{
+		for (unsigned int i = 0; i < ProfileLookup::NUM_KINDS; i++) {
+			LookupTotals[i] = 0;
+		}
+		char name[32];
+		sprintf(name, "Thread %d", index);
+		Name = name;
+	}
+
+	CProfileNode	Root;
+	CProfileNode *	CurrentNode;
+	int				FrameCounter;
+	unsigned int	ResetGeneration;
+	int				Index;
+	std::string		Name;
+
+	// capture data. Scopes started while capturing are pushed to OpenScopes
+	// with their depth, so scopes that were started before the capture are
+	// not matched with the wrong start time.
+	int				Depth;
+	unsigned int	CaptureGeneration;
+	std::vector<CProfileOpenScope>		OpenScopes;
+	std::vector<CProfileTraceEvent>	Events;
+	unsigned int	NextEvent;
+	unsigned int	NumEvents;
+
+	// lookup counts, only written by this thread and read by reports without locking
+	volatile unsigned int	LookupTotals[ProfileLookup::NUM_KINDS];
+	CProfileLookupTable		Lookups;
+	CProfileLookupTable		LookupSamples;
+	unsigned int				LookupsUntilSample;
+};
+
+// all threads that have recorded samples, never removed so reports
+// can still show threads that have finished
+static OpenThreads::Mutex					s_threadsMutex;
+static std::vector<CProfileThread*>	s_threads;
+static volatile unsigned int				s_resetGeneration = 0;
+static volatile bool							s_capturing = false;
+static volatile unsigned int				s_captureGeneration = 0;
+static unsigned int							s_captureSize = 0;
+static dtEntity::Timer_t					s_captureStart = 0;
+static PROFILE_THREAD_LOCAL CProfileThread *	s_currentThread = NULL;
+static volatile unsigned int				s_lookupSampleInterval = 64;
+// set while a lookup is counted or a tree is created, string ids looked up
+// by the profiler itself are not counted
+static PROFILE_THREAD_LOCAL bool				s_inProfiler = false;
+
+static const char * s_lookupKindNames[ProfileLookup::NUM_KINDS] = {
+	"GetComponent", "GetComponent derived", "Derived search step", "HasComponent", "GetEntity", "SID"
+};
+
 /***************************************************************************************************
 **
 ** CProfileNode
@@ -58,11 +235,15 @@ CProfileNode::CProfileNode( dtEntity::StringId name, CProfileNode * parent ) :
 	Name( name ),
 	TotalCalls( 0 ),
 	TotalTime( 0 ),
+	FrameTime( 0 ),
 	StartTime( 0 ),
 	RecursionCounter( 0 ),
+	FrameHistoryCount( 0 ),
+	FrameHistoryIndex( 0 ),
 	Parent( parent ),
 	Child( NULL ),
-	Sibling( NULL )
+	Sibling( NULL ),
+	LastSubNode( NULL )
 {
 	Reset();
 }
@@ -85,19 +266,28 @@ CProfileNode::~CProfileNode( void )
  *=============================================================================================*/
 CProfileNode * CProfileNode::Get_Sub_Node(dtEntity::StringId name )
 {
+	// Most scopes are entered in the same order each frame, so check the
+	// node found last time before walking the list of children
+	if ( LastSubNode && LastSubNode->Name == name ) {
+		return LastSubNode;
+	}
+
 	// Try to find this sub node
 	CProfileNode * child = Child;
 	while ( child ) {
 		if ( child->Name == name ) {
+			LastSubNode = child;
 			return child;
 		}
 		child = child->Sibling;
 	}
 
-	// We didn't find it, so add it
+	// We didn't find it, so add it. Node is complete before it is linked
+	// into the tree, so reports from other threads never see a partial node
 	CProfileNode * node = new CProfileNode( name, this );
 	node->Sibling = Child;
 	Child = node;
+	LastSubNode = node;
 	return node;
 }
 
@@ -106,6 +296,9 @@ void	CProfileNode::Reset( void )
 {
 	TotalCalls = 0;
 	TotalTime = 0.0f;
+	FrameTime = 0.0f;
+	FrameHistoryCount = 0;
+	FrameHistoryIndex = 0;
 
 	if ( Child ) {
 		Child->Reset();
@@ -131,24 +324,93 @@ bool	CProfileNode::Return( void )
                 osg::Timer_t time;
 		Profile_Get_Ticks(&time);
 		time-=StartTime;
-		TotalTime += (float)time / Profile_Get_Tick_Rate();
+		float elapsed = (float)time / Profile_Get_Tick_Rate();
+		TotalTime += elapsed;
+		FrameTime += elapsed;
 	}
 	return ( RecursionCounter == 0 );
 }
 
 
+void	CProfileNode::End_Frame( void )
+{
+	FrameHistory[FrameHistoryIndex] = FrameTime;
+	FrameHistoryIndex = (FrameHistoryIndex + 1) % PROFILE_FRAME_HISTORY;
+	if ( FrameHistoryCount < PROFILE_FRAME_HISTORY ) {
+		FrameHistoryCount++;
+	}
+	FrameTime = 0.0f;
+
+	if ( Child ) {
+		Child->End_Frame();
+	}
+	if ( Sibling ) {
+		Sibling->End_Frame();
+	}
+}
+
+
+float	CProfileNode::Get_Min_Frame_Time( void )
+{
+	if ( FrameHistoryCount == 0 ) {
+		return 0.0f;
+	}
+	float result = FrameHistory[0];
+	for ( int i = 1; i < FrameHistoryCount; i++ ) {
+		result = std::min(result, FrameHistory[i]);
+	}
+	return result;
+}
+
+
+float	CProfileNode::Get_Avg_Frame_Time( void )
+{
+	if ( FrameHistoryCount == 0 ) {
+		return 0.0f;
+	}
+	float result = 0.0f;
+	for ( int i = 0; i < FrameHistoryCount; i++ ) {
+		result += FrameHistory[i];
+	}
+	return result / FrameHistoryCount;
+}
+
+
+float	CProfileNode::Get_Max_Frame_Time( void )
+{
+	float result = 0.0f;
+	for ( int i = 0; i < FrameHistoryCount; i++ ) {
+		result = std::max(result, FrameHistory[i]);
+	}
+	return result;
+}
+
+
 /***************************************************************************************************
 **
 ** CProfileIterator
 **
 ***************************************************************************************************/
-CProfileIterator::CProfileIterator( CProfileNode * start )
+CProfileIterator::CProfileIterator( CProfileThread * thread )
 {
-	CurrentParent = start;
+	Thread = thread;
+	CurrentParent = &thread->Root;
 	CurrentChild = CurrentParent->Get_Child();
 }
 
 
+const std::string&	CProfileIterator::Get_Thread_Name( void )
+{
+	return Thread->Name;
+}
+
+
+int	CProfileIterator::Get_Frame_Count_Since_Reset( void )
+{
+	return Thread->FrameCounter;
+}
+
+
 void	CProfileIterator::First(void)
 {
 	CurrentChild = CurrentParent->Get_Child();
@@ -198,11 +460,11 @@ void	CProfileManager::dumpRecursive(CProfileIterator* profileIterator, int spaci
 
 	float accumulated_time=0,parent_time = profileIterator->Is_Root() ? CProfileManager::Get_Time_Since_Reset() : profileIterator->Get_Current_Parent_Total_Time();
 	int i;
-	int frames_since_reset = CProfileManager::Get_Frame_Count_Since_Reset();
+	int frames_since_reset = profileIterator->Get_Frame_Count_Since_Reset();
 	for (i=0;i<spacing;i++)	printf(".");
         printf("----------------------------------\n");
 	for (i=0;i<spacing;i++)	printf(".");
-	printf("Profiling: %s (total running time: %.3f ms) ---\n",	dtEntity::GetStringFromSID(profileIterator->Get_Current_Parent_Name()).c_str(), parent_time );
+	printf("Profiling: %s (total running time: %.3f s) ---\n",	dtEntity::GetStringFromSID(profileIterator->Get_Current_Parent_Name()).c_str(), parent_time );
    float totalTime = 0;
 
 	
@@ -217,7 +479,19 @@ void	CProfileManager::dumpRecursive(CProfileIterator* profileIterator, int spaci
 		{
 			int i;	for (i=0;i<spacing;i++)	printf(".");
 		}
-		printf("%d -- %s (%.2f %%) :: %.3f s / frame (%d calls)\n",i, dtEntity::GetStringFromSID(profileIterator->Get_Current_Name()).c_str(), fraction,(current_total_time / (double)frames_since_reset),profileIterator->Get_Current_Total_Calls());
+		if (frames_since_reset > 0) {
+			printf("%d -- %s (%.2f %%) :: %.3f ms / frame (min %.3f, avg %.3f, max %.3f over last frames) (%d calls)\n", i,
+				dtEntity::GetStringFromSID(profileIterator->Get_Current_Name()).c_str(), fraction,
+				current_total_time * 1000 / frames_since_reset,
+				profileIterator->Get_Current_Min_Frame_Time() * 1000,
+				profileIterator->Get_Current_Avg_Frame_Time() * 1000,
+				profileIterator->Get_Current_Max_Frame_Time() * 1000,
+				profileIterator->Get_Current_Total_Calls());
+		} else {
+			printf("%d -- %s (%.2f %%) :: %.3f ms (%d calls)\n", i,
+				dtEntity::GetStringFromSID(profileIterator->Get_Current_Name()).c_str(), fraction,
+				current_total_time * 1000, profileIterator->Get_Current_Total_Calls());
+		}
 		totalTime += current_total_time;
 		//recurse into children
 	}
@@ -241,12 +515,40 @@ void	CProfileManager::dumpRecursive(CProfileIterator* profileIterator, int spaci
 
 void	CProfileManager::dumpAll()
 {
-	CProfileIterator* profileIterator = 0;
-	profileIterator = CProfileManager::Get_Iterator();
+	int numThreads = Get_Number_Of_Threads();
+	for (int i = 0; i < numThreads; i++)
+	{
+		CProfileIterator* profileIterator = CProfileManager::Get_Iterator(i);
+
+		printf("========== %s ==========\n", profileIterator->Get_Thread_Name().c_str());
+		dumpRecursive(profileIterator,0);
 
-	dumpRecursive(profileIterator,0);
+		CProfileManager::Release_Iterator(profileIterator);
+	}
 
-	CProfileManager::Release_Iterator(profileIterator);
+	dumpLookups();
+
+	for (std::vector<CProfileReportSection*>::iterator i = ReportSections.begin(); i != ReportSections.end(); ++i)
+	{
+		(*i)->Dump();
+	}
+}
+
+
+void	CProfileManager::Add_Report_Section( CProfileReportSection * section )
+{
+	if (std::find(ReportSections.begin(), ReportSections.end(), section) == ReportSections.end()) {
+		ReportSections.push_back(section);
+	}
+}
+
+
+void	CProfileManager::Remove_Report_Section( CProfileReportSection * section )
+{
+	std::vector<CProfileReportSection*>::iterator i = std::find(ReportSections.begin(), ReportSections.end(), section);
+	if (i != ReportSections.end()) {
+		ReportSections.erase(i);
+	}
 }
 
 
@@ -257,10 +559,111 @@ void	CProfileManager::dumpAll()
 **
 ***************************************************************************************************/
 
-CProfileNode	CProfileManager::Root( dtEntity::SID("Root"), NULL );
-CProfileNode *	CProfileManager::CurrentNode = &CProfileManager::Root;
-int				CProfileManager::FrameCounter = 0;
+std::vector<CProfileReportSection*> CProfileManager::ReportSections;
 osg::Timer_t			CProfileManager::ResetTime = 0;
+volatile unsigned int	CProfileManager::EnabledCategories = ProfileCategory::NONE;
+
+
+void CProfileManager::Set_Enabled_Categories( unsigned int categories )
+{
+	EnabledCategories = categories & (ProfileCategory::ALL | ProfileCategory::LOOKUPS);
+}
+
+
+/***********************************************************************************************
+ * CProfileManager::Parse_Categories -- Convert category names to ProfileCategory bits        *
+ *=============================================================================================*/
+bool CProfileManager::Parse_Categories( const std::string& str, unsigned int& categories )
+{
+	categories = ProfileCategory::NONE;
+	bool success = true;
+	std::string::size_type start = 0;
+	while (start <= str.size())
+	{
+		std::string::size_type end = str.find(',', start);
+		if (end == std::string::npos) {
+			end = str.size();
+		}
+		std::string name = str.substr(start, end - start);
+		if (name == "messages")		categories |= ProfileCategory::MESSAGES;
+		else if (name == "systems")	categories |= ProfileCategory::SYSTEMS;
+		else if (name == "scripts")	categories |= ProfileCategory::SCRIPTS;
+		else if (name == "io")			categories |= ProfileCategory::IO;
+		else if (name == "lookups")	categories |= ProfileCategory::LOOKUPS;
+		else if (name == "all")		categories |= ProfileCategory::ALL;
+		else if (!name.empty())		success = false;
+		start = end + 1;
+	}
+	return success;
+}
+
+
+bool CProfileManager::Setup_From_Command_Line( int argc, char** argv )
+{
+	for (int i = 1; i < argc - 1; i++)
+	{
+		if (std::string(argv[i]) == "--profile") {
+			unsigned int categories;
+			if (!Parse_Categories(argv[i + 1], categories)) {
+				printf("Unknown profile category in %s, use messages, systems, scripts, io, lookups or all\n", argv[i + 1]);
+			}
+			Set_Enabled_Categories(categories);
+			return true;
+		}
+	}
+	return false;
+}
+
+
+// Allocate ring buffer of a thread for the next capture, called with
+// s_threadsMutex held while the owning thread does not write events
+static void Prepare_Capture( CProfileThread * thread )
+{
+	thread->Events.clear();
+	thread->Events.resize(s_captureSize);
+	thread->NextEvent = 0;
+	thread->NumEvents = 0;
+	thread->CaptureGeneration = s_captureGeneration;
+}
+
+
+/***********************************************************************************************
+ * CProfileManager::Get_Current_Thread -- Get profile tree of calling thread                  *
+ *                                                                                             *
+ * Creates and registers the tree on first use. Also resets the tree if Reset was called      *
+ * since the last call and the thread is not inside a profile scope.                          *
+ *=============================================================================================*/
+CProfileThread *	CProfileManager::Get_Current_Thread( void )
+{
+	CProfileThread * thread = s_currentThread;
+	if (thread == NULL) {
+		OpenThreads::ScopedLock<OpenThreads::Mutex> lock(s_threadsMutex);
+		if (s_threads.empty() && ResetTime == 0) {
+			Profile_Get_Ticks(&ResetTime);
+		}
+		bool inProfiler = s_inProfiler;
+		s_inProfiler = true;
+		thread = new CProfileThread( (int)s_threads.size() );
+		s_inProfiler = inProfiler;
+		thread->ResetGeneration = s_resetGeneration;
+		if (s_capturing) {
+			Prepare_Capture(thread);
+		}
+		s_threads.push_back(thread);
+		s_currentThread = thread;
+	}
+	else if (thread->ResetGeneration != s_resetGeneration && thread->CurrentNode == &thread->Root) {
+		thread->ResetGeneration = s_resetGeneration;
+		thread->Root.Reset();
+		thread->FrameCounter = 0;
+		for (unsigned int i = 0; i < ProfileLookup::NUM_KINDS; i++) {
+			thread->LookupTotals[i] = 0;
+		}
+		thread->Lookups.Reset();
+		thread->LookupSamples.Reset();
+	}
+	return thread;
+}
 
 
 /***********************************************************************************************
@@ -273,16 +676,24 @@ osg::Timer_t			CProfileManager::ResetTime = 0;
  * name - name of this profiling record                                                        *
  *                                                                                             *
  * WARNINGS:                                                                                   *
- * The string used is assumed to be a static string; pointer compares are used throughout      *
- * the profiling code for efficiency.                                                          *
+ * The tree of the calling thread is used, no locks are taken.                                 *
  *=============================================================================================*/
 void	CProfileManager::Start_Profile(dtEntity::StringId name )
 {
-	if (name != CurrentNode->Get_Name()) {
-		CurrentNode = CurrentNode->Get_Sub_Node( name );
+	CProfileThread * thread = Get_Current_Thread();
+	if (name != thread->CurrentNode->Get_Name()) {
+		thread->CurrentNode = thread->CurrentNode->Get_Sub_Node( name );
 	} 
 	
-	CurrentNode->Call();
+	thread->CurrentNode->Call();
+
+	thread->Depth++;
+	if (s_capturing && thread->CaptureGeneration == s_captureGeneration) {
+		CProfileOpenScope scope;
+		scope.Depth = thread->Depth;
+		Profile_Get_Ticks(&scope.StartTime);
+		thread->OpenScopes.push_back(scope);
+	}
 }
 
 
@@ -291,10 +702,30 @@ void	CProfileManager::Start_Profile(dtEntity::StringId name )
  *=============================================================================================*/
 void	CProfileManager::Stop_Profile( void )
 {
+	CProfileThread * thread = s_currentThread;
+	if (thread == NULL || thread->CurrentNode == &thread->Root) {
+		// unbalanced call
+		return;
+	}
+	if (!thread->OpenScopes.empty() && thread->OpenScopes.back().Depth == thread->Depth) {
+		if (s_capturing && thread->CaptureGeneration == s_captureGeneration && !thread->Events.empty()) {
+			CProfileTraceEvent& ev = thread->Events[thread->NextEvent];
+			ev.Name = thread->CurrentNode->Get_Name();
+			ev.StartTime = thread->OpenScopes.back().StartTime;
+			Profile_Get_Ticks(&ev.EndTime);
+			thread->NextEvent = (thread->NextEvent + 1) % thread->Events.size();
+			if (thread->NumEvents < thread->Events.size()) {
+				thread->NumEvents++;
+			}
+		}
+		thread->OpenScopes.pop_back();
+	}
+	thread->Depth--;
+
 	// Return will indicate whether we should back up to our parent (we may
 	// be profiling a recursive function)
-	if (CurrentNode->Return()) {
-		CurrentNode = CurrentNode->Get_Parent();
+	if (thread->CurrentNode->Return()) {
+		thread->CurrentNode = thread->CurrentNode->Get_Parent();
 	}
 }
 
@@ -303,21 +734,37 @@ void	CProfileManager::Stop_Profile( void )
  * CProfileManager::Reset -- Reset the contents of the profiling system                       *
  *                                                                                             *
  *    This resets everything except for the tree structure.  All of the timing data is reset.  *
+ *    Trees of other threads are reset by their owning thread.                                 *
  *=============================================================================================*/
 void	CProfileManager::Reset( void )
 { 
-	Root.Reset(); 
-	FrameCounter = 0;
+	s_resetGeneration = s_resetGeneration + 1;
+	Get_Current_Thread();
 	Profile_Get_Ticks(&ResetTime);
 }
 
 
 /***********************************************************************************************
  * CProfileManager::Increment_Frame_Counter -- Increment the frame counter                    *
+ *                                                                                             *
+ *    Also moves the times of the ended frame of the calling thread to the frame history.     *
  *=============================================================================================*/
 void CProfileManager::Increment_Frame_Counter( void )
 {
-	FrameCounter++;
+	CProfileThread * thread = Get_Current_Thread();
+	if (thread->FrameCounter > 0) {
+		thread->Root.End_Frame();
+	}
+	thread->FrameCounter++;
+}
+
+
+/***********************************************************************************************
+ * CProfileManager::Get_Frame_Count_Since_Reset -- Frames counted by the calling thread       *
+ *=============================================================================================*/
+int CProfileManager::Get_Frame_Count_Since_Reset( void )
+{
+	return Get_Current_Thread()->FrameCounter;
 }
 
 
@@ -333,4 +780,318 @@ float CProfileManager::Get_Time_Since_Reset( void )
 }
 
 
+/***********************************************************************************************
+ * CProfileManager::Set_Thread_Name -- Name of calling thread in reports                      *
+ *=============================================================================================*/
+void CProfileManager::Set_Thread_Name( const std::string& name )
+{
+	CProfileThread * thread = Get_Current_Thread();
+	OpenThreads::ScopedLock<OpenThreads::Mutex> lock(s_threadsMutex);
+	thread->Name = name;
+}
+
+
+int CProfileManager::Get_Number_Of_Threads( void )
+{
+	OpenThreads::ScopedLock<OpenThreads::Mutex> lock(s_threadsMutex);
+	return (int)s_threads.size();
+}
+
+
+CProfileIterator * CProfileManager::Get_Iterator( void )
+{
+	return new CProfileIterator( Get_Current_Thread() );
+}
+
+
+CProfileIterator * CProfileManager::Get_Iterator( int thread )
+{
+	OpenThreads::ScopedLock<OpenThreads::Mutex> lock(s_threadsMutex);
+	return new CProfileIterator( s_threads[thread] );
+}
+
+
+/***********************************************************************************************
+ * CProfileManager::Count_Lookup -- Count a lookup in the current scope of calling thread     *
+ *                                                                                             *
+ *    Every s_lookupSampleInterval-th lookup of a thread is also counted with its call site.  *
+ *    Counts are kept per thread and written without locks or atomic operations.              *
+ *=============================================================================================*/
+void CProfileManager::Count_Lookup( ProfileLookup::e kind, dtEntity::StringId componentType, const void * callSite )
+{
+	if (s_inProfiler) {
+		return;
+	}
+	s_inProfiler = true;
+	CProfileThread * thread = Get_Current_Thread();
+
+	CProfileLookupKey key;
+	key.Kind = kind;
+	key.ComponentType = componentType;
+	key.Caller = thread->CurrentNode->Get_Name();
+	key.CallSite = NULL;
+	thread->LookupTotals[kind] = thread->LookupTotals[kind] + 1;
+	thread->Lookups.Add(key);
+	if (--thread->LookupsUntilSample == 0) {
+		thread->LookupsUntilSample = s_lookupSampleInterval;
+		key.CallSite = callSite;
+		thread->LookupSamples.Add(key);
+	}
+	s_inProfiler = false;
+}
+
+
+void CProfileManager::Set_Lookup_Sample_Interval( unsigned int interval )
+{
+	s_lookupSampleInterval = std::max(1u, interval);
+}
+
+
+static bool Lookup_Count_Greater( const CProfileLookupCount& a, const CProfileLookupCount& b )
+{
+	return a.Count > b.Count;
+}
+
+
+static bool Lookup_Sample_Greater( const CProfileLookupSample& a, const CProfileLookupSample& b )
+{
+	return a.Count > b.Count;
+}
+
+
+/***********************************************************************************************
+ * Sum_Lookups -- Sum lookup counts or samples of all threads                                  *
+ *=============================================================================================*/
+static void Sum_Lookups( CProfileLookupTable CProfileThread::* member, CProfileLookupMap& sum )
+{
+	OpenThreads::ScopedLock<OpenThreads::Mutex> lock(s_threadsMutex);
+	for (std::vector<CProfileThread*>::iterator i = s_threads.begin(); i != s_threads.end(); ++i)
+	{
+		((*i)->*member).Sum(sum);
+	}
+}
+
+
+void CProfileManager::Get_Lookup_Totals( unsigned int totals[ProfileLookup::NUM_KINDS] )
+{
+	for (unsigned int j = 0; j < ProfileLookup::NUM_KINDS; j++) {
+		totals[j] = 0;
+	}
+	OpenThreads::ScopedLock<OpenThreads::Mutex> lock(s_threadsMutex);
+	for (std::vector<CProfileThread*>::iterator i = s_threads.begin(); i != s_threads.end(); ++i)
+	{
+		for (unsigned int j = 0; j < ProfileLookup::NUM_KINDS; j++) {
+			totals[j] += (*i)->LookupTotals[j];
+		}
+	}
+}
+
+
+void CProfileManager::Get_Lookup_Counts( std::vector<CProfileLookupCount>& toFill )
+{
+	CProfileLookupMap sum;
+	Sum_Lookups(&CProfileThread::Lookups, sum);
+	for (CProfileLookupMap::const_iterator i = sum.begin(); i != sum.end(); ++i)
+	{
+		CProfileLookupCount count;
+		count.Kind = (ProfileLookup::e)i->first.Kind;
+		count.ComponentType = i->first.ComponentType;
+		count.Caller = i->first.Caller;
+		count.Count = i->second;
+		toFill.push_back(count);
+	}
+	std::stable_sort(toFill.begin(), toFill.end(), Lookup_Count_Greater);
+}
+
+
+void CProfileManager::Get_Lookup_Samples( std::vector<CProfileLookupSample>& toFill )
+{
+	CProfileLookupMap sum;
+	Sum_Lookups(&CProfileThread::LookupSamples, sum);
+	for (CProfileLookupMap::const_iterator i = sum.begin(); i != sum.end(); ++i)
+	{
+		CProfileLookupSample sample;
+		sample.Kind = (ProfileLookup::e)i->first.Kind;
+		sample.ComponentType = i->first.ComponentType;
+		sample.Caller = i->first.Caller;
+		sample.CallSite = i->first.CallSite;
+		sample.Count = i->second;
+		toFill.push_back(sample);
+	}
+	std::stable_sort(toFill.begin(), toFill.end(), Lookup_Sample_Greater);
+}
+
+
+/***********************************************************************************************
+ * Describe_Call_Site -- Symbol and offset of a return address if it can be resolved          *
+ *=============================================================================================*/
+static std::string Describe_Call_Site( const void * callSite )
+{
+	char buf[512];
+#if !defined(_WIN32)
+	Dl_info info;
+	if (callSite != NULL && dladdr(callSite, &info) != 0) {
+		if (info.dli_sname != NULL) {
+			sprintf(buf, "%.400s+0x%lx", info.dli_sname,
+				(unsigned long)((const char*)callSite - (const char*)info.dli_saddr));
+			return buf;
+		}
+		if (info.dli_fname != NULL) {
+			sprintf(buf, "%.400s+0x%lx", info.dli_fname,
+				(unsigned long)((const char*)callSite - (const char*)info.dli_fbase));
+			return buf;
+		}
+	}
+#endif
+	sprintf(buf, "%p", callSite);
+	return buf;
+}
+
+
+// GetEntity and SID lookups have no component type
+static std::string Lookup_Type_Name( dtEntity::StringId type )
+{
+	return type == dtEntity::StringId() ? "-" : dtEntity::GetStringFromSID(type);
+}
+
+
+void	CProfileManager::dumpLookups()
+{
+	std::vector<CProfileLookupCount> counts;
+	Get_Lookup_Counts(counts);
+	if (counts.empty()) {
+		return;
+	}
+
+	unsigned int totals[ProfileLookup::NUM_KINDS];
+	Get_Lookup_Totals(totals);
+	printf("========== Lookups ==========\n");
+	for (unsigned int i = 0; i < ProfileLookup::NUM_KINDS; i++)
+	{
+		printf("%-22s %10u\n", s_lookupKindNames[i], totals[i]);
+	}
+	printf("%-22s %-32s %-40s %10s\n", "Kind", "Component type", "Caller", "Count");
+	for (std::vector<CProfileLookupCount>::const_iterator i = counts.begin(); i != counts.end(); ++i)
+	{
+		printf("%-22s %-32s %-40s %10u\n", s_lookupKindNames[i->Kind],
+			Lookup_Type_Name(i->ComponentType).c_str(),
+			dtEntity::GetStringFromSID(i->Caller).c_str(), i->Count);
+	}
 
+	std::vector<CProfileLookupSample> samples;
+	Get_Lookup_Samples(samples);
+	printf("========== Sampled lookup call sites (1 in %u) ==========\n", s_lookupSampleInterval);
+	for (std::vector<CProfileLookupSample>::const_iterator i = samples.begin(); i != samples.end(); ++i)
+	{
+		printf("%10u  %-22s %-32s %s\n", i->Count, s_lookupKindNames[i->Kind],
+			Lookup_Type_Name(i->ComponentType).c_str(), Describe_Call_Site(i->CallSite).c_str());
+	}
+}
+
+
+/***********************************************************************************************
+ * CProfileManager::Start_Capture -- Start recording profile scopes for trace export          *
+ *                                                                                             *
+ *    Ring buffers of all known threads are allocated here under the threads lock, threads    *
+ *    created during the capture allocate theirs on registration. Profiled threads never      *
+ *    resize their buffer, so Write_Capture can read it once capturing has stopped.           *
+ *    Does nothing if a capture is already running.                                           *
+ *=============================================================================================*/
+void CProfileManager::Start_Capture( unsigned int maxEvents )
+{
+	OpenThreads::ScopedLock<OpenThreads::Mutex> lock(s_threadsMutex);
+	if (s_capturing) {
+		return;
+	}
+	s_captureSize = std::max(1u, maxEvents);
+	Profile_Get_Ticks(&s_captureStart);
+	s_captureGeneration = s_captureGeneration + 1;
+	for (std::vector<CProfileThread*>::iterator i = s_threads.begin(); i != s_threads.end(); ++i)
+	{
+		Prepare_Capture(*i);
+	}
+	s_capturing = true;
+}
+
+
+void CProfileManager::Stop_Capture( void )
+{
+	s_capturing = false;
+}
+
+
+bool CProfileManager::Is_Capturing( void )
+{
+	return s_capturing;
+}
+
+
+static std::string Json_Escape( const std::string& str )
+{
+	std::string result;
+	for (std::string::const_iterator i = str.begin(); i != str.end(); ++i)
+	{
+		if (*i == '"' || *i == '\\') {
+			result += '\\';
+			result += *i;
+		} else if ((unsigned char)*i < 0x20) {
+			result += ' ';
+		} else {
+			result += *i;
+		}
+	}
+	return result;
+}
+
+
+/***********************************************************************************************
+ * CProfileManager::Write_Capture -- Write recorded scopes as Chrome Trace Event JSON         *
+ *                                                                                             *
+ *    Scopes are written as complete events with microsecond timestamps relative to the       *
+ *    start of the capture, one track per thread. Returns false while capturing, profiled     *
+ *    threads would write to the buffers that are read here.                                  *
+ *=============================================================================================*/
+bool CProfileManager::Write_Capture( const std::string& path )
+{
+	if (s_capturing) {
+		return false;
+	}
+	std::ofstream out(path.c_str());
+	if (!out.is_open()) {
+		return false;
+	}
+
+	double secondsPerTick = osg::Timer::instance()->getSecondsPerTick();
+	char buf[64];
+
+	OpenThreads::ScopedLock<OpenThreads::Mutex> lock(s_threadsMutex);
+	out << "{\"traceEvents\":[\n";
+	bool first = true;
+	for (std::vector<CProfileThread*>::iterator i = s_threads.begin(); i != s_threads.end(); ++i)
+	{
+		CProfileThread * thread = *i;
+		if (thread->CaptureGeneration != s_captureGeneration) {
+			continue;
+		}
+
+		if (!first) out << ",\n";
+		first = false;
+		out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread->Index
+			<< ",\"args\":{\"name\":\"" << Json_Escape(thread->Name) << "\"}}";
+
+		unsigned int size = (unsigned int)thread->Events.size();
+		unsigned int start = (thread->NextEvent + size - thread->NumEvents) % size;
+		for (unsigned int j = 0; j < thread->NumEvents; j++)
+		{
+			const CProfileTraceEvent& ev = thread->Events[(start + j) % size];
+			double ts = (double)(ev.StartTime - s_captureStart) * secondsPerTick * 1000000.0;
+			double dur = (double)(ev.EndTime - ev.StartTime) * secondsPerTick * 1000000.0;
+			sprintf(buf, ",\"ts\":%.3f,\"dur\":%.3f", ts, dur);
+
+			out << ",\n{\"name\":\"" << Json_Escape(dtEntity::GetStringFromSID(ev.Name))
+				<< "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << thread->Index << buf << "}";
+		}
+	}
+	out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+	return !out.fail();
+}
@@ -1093,25 +1093,12 @@ namespace dtEntity
    }
 
    ////////////////////////////////////////////////////////////////////////////////
-   Message* ProtoBufMapEncoder::DecodeMessage(std::istream& stream)
+   static void SetMessagePropertiesFrom(Message& msg, const dtProtoBuf::Message& messageobj)
    {
-      dtProtoBuf::Message messageobj;
-      if(!messageobj.ParseFromIstream(&stream))
-      {
-         return NULL;
-      }
-
-      Message* msg;
-      bool success = MessageFactory::GetInstance().CreateMessage(SID(messageobj.message_type()), msg);
-      if(!success)
-      {
-         LOG_ERROR("Message type not found!");
-         return NULL;
-      }
       for(int i = 0; i < messageobj.property_size(); ++i)
       {
          const dtProtoBuf::Property& prop = messageobj.property(i);
-         Property* toset = msg->Get(SID(prop.property_name()));
+         Property* toset = msg.Get(SID(prop.property_name()));
          if(toset == NULL)
          {
             LOG_WARNING("Error decoding message : Property " << GetStringFromSID(SID(prop.property_name()))
@@ -1127,6 +1114,79 @@ namespace dtEntity
             }
          }
       }
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   Message* ProtoBufMapEncoder::DecodeMessage(std::istream& stream)
+   {
+      dtProtoBuf::Message messageobj;
+      if(!messageobj.ParseFromIstream(&stream))
+      {
+         return NULL;
+      }
+
+      Message* msg;
+      bool success = MessageFactory::GetInstance().CreateMessage(SID(messageobj.message_type()), msg);
+      if(!success)
+      {
+         LOG_ERROR("Message type not found!");
+         return NULL;
+      }
+      SetMessagePropertiesFrom(*msg, messageobj);
+      return msg;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   ////////////////////////////////////////////////////////////////////////////////
+   ProtoBufMessageDecoder::ProtoBufMessageDecoder()
+      : mParsed(new dtProtoBuf::Message())
+   {
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   ProtoBufMessageDecoder::~ProtoBufMessageDecoder()
+   {
+      for(MessagePool::iterator i = mMessagePool.begin(); i != mMessagePool.end(); ++i)
+      {
+         delete i->second.mMessage;
+         delete i->second.mDefaults;
+      }
+      delete mParsed;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   Message* ProtoBufMessageDecoder::Decode(const void* data, unsigned int size)
+   {
+      // ParseFromArray reads the buffer in place
+      if(!mParsed->ParseFromArray(data, size))
+      {
+         return NULL;
+      }
+
+      MessageType mtype = SID(mParsed->message_type());
+      Message* msg;
+      MessagePool::iterator i = mMessagePool.find(mtype);
+      if(i != mMessagePool.end())
+      {
+         // sender may omit properties, so start from default values
+         // instead of the values of the previous message
+         msg = i->second.mMessage;
+         msg->InitFrom(*i->second.mDefaults);
+      }
+      else
+      {
+         bool success = MessageFactory::GetInstance().CreateMessage(mtype, msg);
+         if(!success)
+         {
+            LOG_ERROR("Message type not found!");
+            return NULL;
+         }
+         PooledMessage& pooled = mMessagePool[mtype];
+         pooled.mMessage = msg;
+         pooled.mDefaults = msg->Clone();
+      }
+
+      SetMessagePropertiesFrom(*msg, *mParsed);
       return msg;
    }
 }
@@ -23,6 +23,9 @@
 #include <dtEntity/hash.h>
 #include <dtEntity/dtentity_config.h>
 #include <dtEntity/singleton.h>
+#if DTENTITY_PROFILING_ENABLED
+#include <dtEntity/profile.h>
+#endif
 #include <map>
 #include <string>
 #include <iostream>
@@ -108,6 +111,9 @@ namespace dtEntity
    ////////////////////////////////////////////////////////////////////////////////
    StringId SID(const std::string& str)
    {
+#if DTENTITY_PROFILING_ENABLED
+      PROFILE_LOOKUP(ProfileLookup::SID, StringId());
+#endif
       unsigned int hash = StringIdManager::Hash(str);
       StringIdManager::GetInstance().AddToReverseLookup(str, hash);
 #if DTENTITY_USE_STRINGS_AS_STRINGIDS
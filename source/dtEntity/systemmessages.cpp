@@ -39,6 +39,7 @@ namespace dtEntity
       em.RegisterMessageType<EntitySystemAddedMessage>(EntitySystemAddedMessage::TYPE);
       em.RegisterMessageType<EntitySystemRemovedMessage>(EntitySystemRemovedMessage::TYPE);
       em.RegisterMessageType<EntityVelocityNotNullMessage>(EntityVelocityNotNullMessage::TYPE);
+      em.RegisterMessageType<FrameHitchMessage>(FrameHitchMessage::TYPE);
       em.RegisterMessageType<MapBeginLoadMessage>(MapBeginLoadMessage::TYPE);
       em.RegisterMessageType<MapBeginUnloadMessage>(MapBeginUnloadMessage::TYPE);
       em.RegisterMessageType<MapLoadedMessage>(MapLoadedMessage::TYPE);
@@ -220,6 +221,32 @@ namespace dtEntity
       Register(IsNullId, &mIsNull);
    }
 
+   ////////////////////////////////////////////////////////////////////////////////
+   const MessageType FrameHitchMessage::TYPE(dtEntity::SID("FrameHitchMessage"));
+   const StringId FrameHitchMessage::FrameTimeId(dtEntity::SID("FrameTime"));
+   const StringId FrameHitchMessage::FrameBudgetId(dtEntity::SID("FrameBudget"));
+   const StringId FrameHitchMessage::PostFrameTimeId(dtEntity::SID("PostFrameTime"));
+   const StringId FrameHitchMessage::TickTimeId(dtEntity::SID("TickTime"));
+   const StringId FrameHitchMessage::QueuedMessagesTimeId(dtEntity::SID("QueuedMessagesTime"));
+   const StringId FrameHitchMessage::EndOfFrameTimeId(dtEntity::SID("EndOfFrameTime"));
+   const StringId FrameHitchMessage::RenderTimeId(dtEntity::SID("RenderTime"));
+   const StringId FrameHitchMessage::SlowestSubscribersId(dtEntity::SID("SlowestSubscribers"));
+   const StringId FrameHitchMessage::NameId(dtEntity::SID("Name"));
+   const StringId FrameHitchMessage::TimeId(dtEntity::SID("Time"));
+
+   FrameHitchMessage::FrameHitchMessage()
+      : Message(TYPE)
+   {
+      Register(FrameTimeId, &mFrameTime);
+      Register(FrameBudgetId, &mFrameBudget);
+      Register(PostFrameTimeId, &mPostFrameTime);
+      Register(TickTimeId, &mTickTime);
+      Register(QueuedMessagesTimeId, &mQueuedMessagesTime);
+      Register(EndOfFrameTimeId, &mEndOfFrameTime);
+      Register(RenderTimeId, &mRenderTime);
+      Register(SlowestSubscribersId, &mSlowestSubscribers);
+   }
+
    ////////////////////////////////////////////////////////////////////////////////
    const MessageType TickMessage::TYPE(dtEntity::SID("TickMessage"));
    const StringId TickMessage::DeltaSimTimeId(dtEntity::SID("DeltaSimTime"));
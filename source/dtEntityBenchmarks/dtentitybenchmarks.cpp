@@ -0,0 +1,841 @@
+/*
+* dtEntity Game and Simulation Engine
+*
+* This library is free software; you can redistribute it and/or modify it under
+* the terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; either version 2.1 of the License, or (at your option)
+* any later version.
+*
+* This library is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+* details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this library; if not, write to the Free Software Foundation, Inc.,
+* 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*
+* Martin Scheffler
+*/
+
+// Micro benchmarks for the core operations of dtEntity.
+// Prints one JSON object per benchmark and line to stdout:
+// {"name":"EntityCreateKill","iterations":100000,"ns_per_op":512.3,"allocs_per_op":4.00}
+//
+// Options:
+//   --iterations N   number of timed operations per benchmark (default 100000)
+//   --subscribers N  number of message subscribers (default 16)
+//   --entities N     number of entities in maps and component stores (default 1000)
+//   --filter NAME    only run benchmarks whose name contains NAME
+
+#include <dtEntity/dtentity_config.h>
+#include <dtEntity/defaultentitysystem.h>
+#include <dtEntity/entity.h>
+#include <dtEntity/entitymanager.h>
+#include <dtEntity/init.h>
+#include <dtEntity/logmanager.h>
+#include <dtEntity/mapcomponent.h>
+#include <dtEntity/messagefactory.h>
+#include <dtEntity/componentpluginmanager.h>
+#include <dtEntity/spawner.h>
+#include <dtEntity/stringid.h>
+#include <dtEntity/systemmessages.h>
+#include <dtEntityOSG/positionattitudetransformcomponent.h>
+#include <osg/ArgumentParser>
+#include <osg/Timer>
+#include <osgDB/FileUtils>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+// Allocation counting. Replacing the global operators counts all allocations
+// that go through operator new, on platforms where the libraries share the
+// operators of the executable this includes allocations inside dtEntity.
+// Benchmarks run on the main thread only, so a plain counter is enough.
+static unsigned long s_numAllocations = 0;
+
+// dynamic exception specifications are deprecated since C++11
+#if __cplusplus >= 201103L
+#define BENCHMARK_THROW_BAD_ALLOC
+#define BENCHMARK_NOTHROW noexcept
+#else
+#define BENCHMARK_THROW_BAD_ALLOC throw(std::bad_alloc)
+#define BENCHMARK_NOTHROW throw()
+#endif
+
+void* operator new(std::size_t size) BENCHMARK_THROW_BAD_ALLOC
+{
+   ++s_numAllocations;
+   void* p = std::malloc(size == 0 ? 1 : size);
+   if(p == NULL)
+   {
+      throw std::bad_alloc();
+   }
+   return p;
+}
+
+void* operator new[](std::size_t size) BENCHMARK_THROW_BAD_ALLOC
+{
+   return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) BENCHMARK_NOTHROW
+{
+   ++s_numAllocations;
+   return std::malloc(size == 0 ? 1 : size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t& nt) BENCHMARK_NOTHROW
+{
+   return operator new(size, nt);
+}
+
+void operator delete(void* p) BENCHMARK_NOTHROW
+{
+   std::free(p);
+}
+
+void operator delete[](void* p) BENCHMARK_NOTHROW
+{
+   std::free(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) BENCHMARK_NOTHROW
+{
+   std::free(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) BENCHMARK_NOTHROW
+{
+   std::free(p);
+}
+
+namespace
+{
+   // results are written here so the compiler cannot remove benchmarked calls
+   volatile double s_sink = 0;
+
+   ////////////////////////////////////////////////////////////////////////////////
+   struct BenchmarkOptions
+   {
+      BenchmarkOptions()
+         : mIterations(100000)
+         , mSubscribers(16)
+         , mEntities(1000)
+      {
+      }
+      unsigned int mIterations;
+      unsigned int mSubscribers;
+      unsigned int mEntities;
+      std::string mFilter;
+   };
+
+   ////////////////////////////////////////////////////////////////////////////////
+   /**
+    * A benchmark times Run. Setup and TearDown are not included in the
+    * measurement. Setup returns false if the benchmark cannot be run
+    * in this environment
+    */
+   class Benchmark
+   {
+   public:
+      Benchmark(const std::string& name) : mName(name) {}
+      virtual ~Benchmark() {}
+
+      const std::string& GetName() const { return mName; }
+
+      virtual bool Setup(const BenchmarkOptions& options) { return true; }
+      virtual void Run(unsigned int iterations) = 0;
+      virtual void TearDown() {}
+
+   private:
+      std::string mName;
+   };
+
+   ////////////////////////////////////////////////////////////////////////////////
+   // minimal component with a few properties
+   class BenchmarkComponent : public dtEntity::Component
+   {
+   public:
+      static const dtEntity::ComponentType TYPE;
+      static const dtEntity::StringId ValueId;
+      static const dtEntity::StringId PositionId;
+      static const dtEntity::StringId NameId;
+
+      BenchmarkComponent()
+      {
+         Register(ValueId, &mValue);
+         Register(PositionId, &mPosition);
+         Register(NameId, &mName);
+      }
+
+      virtual dtEntity::ComponentType GetType() const { return TYPE; }
+
+   private:
+      dtEntity::DoubleProperty mValue;
+      dtEntity::Vec3Property mPosition;
+      dtEntity::StringProperty mName;
+   };
+
+   const dtEntity::ComponentType BenchmarkComponent::TYPE(dtEntity::SID("Benchmark"));
+   const dtEntity::StringId BenchmarkComponent::ValueId(dtEntity::SID("Value"));
+   const dtEntity::StringId BenchmarkComponent::PositionId(dtEntity::SID("Position"));
+   const dtEntity::StringId BenchmarkComponent::NameId(dtEntity::SID("Name"));
+
+   ////////////////////////////////////////////////////////////////////////////////
+   class BenchmarkSystem : public dtEntity::DefaultEntitySystem<BenchmarkComponent>
+   {
+   public:
+      static const dtEntity::ComponentType TYPE;
+      BenchmarkSystem(dtEntity::EntityManager& em)
+         : dtEntity::DefaultEntitySystem<BenchmarkComponent>(em)
+      {
+      }
+   };
+
+   const dtEntity::ComponentType BenchmarkSystem::TYPE(dtEntity::SID("Benchmark"));
+
+   ////////////////////////////////////////////////////////////////////////////////
+   class EntityCreateKill : public Benchmark
+   {
+   public:
+      EntityCreateKill() : Benchmark("EntityCreateKill"), mEntityManager(NULL) {}
+
+      virtual bool Setup(const BenchmarkOptions& options)
+      {
+         mEntityManager = new dtEntity::EntityManager();
+         return true;
+      }
+
+      virtual void Run(unsigned int iterations)
+      {
+         for(unsigned int i = 0; i < iterations; ++i)
+         {
+            dtEntity::Entity* entity;
+            mEntityManager->CreateEntity(entity);
+            mEntityManager->KillEntity(entity->GetId());
+         }
+      }
+
+      virtual void TearDown()
+      {
+         delete mEntityManager;
+      }
+
+   private:
+      dtEntity::EntityManager* mEntityManager;
+   };
+
+   ////////////////////////////////////////////////////////////////////////////////
+   // base for benchmarks working on a number of entities in a BenchmarkSystem
+   class ComponentBenchmark : public Benchmark
+   {
+   public:
+      ComponentBenchmark(const std::string& name, bool createComponents)
+         : Benchmark(name)
+         , mEntityManager(NULL)
+         , mSystem(NULL)
+         , mCreateComponents(createComponents)
+      {
+      }
+
+      virtual bool Setup(const BenchmarkOptions& options)
+      {
+         mEntityManager = new dtEntity::EntityManager();
+         mSystem = new BenchmarkSystem(*mEntityManager);
+         mEntityManager->AddEntitySystem(*mSystem);
+         for(unsigned int i = 0; i < options.mEntities; ++i)
+         {
+            dtEntity::Entity* entity;
+            mEntityManager->CreateEntity(entity);
+            mEntityIds.push_back(entity->GetId());
+            if(mCreateComponents)
+            {
+               dtEntity::Component* component;
+               mSystem->CreateComponent(entity->GetId(), component);
+            }
+         }
+         return !mEntityIds.empty();
+      }
+
+      virtual void TearDown()
+      {
+         delete mEntityManager;
+         mEntityIds.clear();
+      }
+
+   protected:
+      dtEntity::EntityManager* mEntityManager;
+      BenchmarkSystem* mSystem;
+      std::vector<dtEntity::EntityId> mEntityIds;
+      bool mCreateComponents;
+   };
+
+   ////////////////////////////////////////////////////////////////////////////////
+   class ComponentCreateDelete : public ComponentBenchmark
+   {
+   public:
+      ComponentCreateDelete() : ComponentBenchmark("ComponentCreateDelete", false) {}
+
+      virtual void Run(unsigned int iterations)
+      {
+         unsigned int numEntities = static_cast<unsigned int>(mEntityIds.size());
+         for(unsigned int i = 0; i < iterations; ++i)
+         {
+            dtEntity::EntityId id = mEntityIds[i % numEntities];
+            dtEntity::Component* component;
+            mSystem->CreateComponent(id, component);
+            mSystem->DeleteComponent(id);
+         }
+      }
+   };
+
+   ////////////////////////////////////////////////////////////////////////////////
+   class ComponentGet : public ComponentBenchmark
+   {
+   public:
+      ComponentGet() : ComponentBenchmark("ComponentGet", true) {}
+
+      virtual void Run(unsigned int iterations)
+      {
+         unsigned int numEntities = static_cast<unsigned int>(mEntityIds.size());
+         unsigned int found = 0;
+         for(unsigned int i = 0; i < iterations; ++i)
+         {
+            if(mSystem->GetComponent(mEntityIds[i % numEntities]) != NULL)
+            {
+               ++found;
+            }
+         }
+         s_sink = found;
+      }
+   };
+
+   ////////////////////////////////////////////////////////////////////////////////
+   class ComponentGetViaEntityManager : public ComponentBenchmark
+   {
+   public:
+      ComponentGetViaEntityManager() : ComponentBenchmark("ComponentGetViaEntityManager", true) {}
+
+      virtual void Run(unsigned int iterations)
+      {
+         unsigned int numEntities = static_cast<unsigned int>(mEntityIds.size());
+         unsigned int found = 0;
+         for(unsigned int i = 0; i < iterations; ++i)
+         {
+            BenchmarkComponent* component;
+            if(mEntityManager->GetComponent(mEntityIds[i % numEntities], component))
+            {
+               ++found;
+            }
+         }
+         s_sink = found;
+      }
+   };
+
+   ////////////////////////////////////////////////////////////////////////////////
+   struct MessageCounter
+   {
+      MessageCounter() : mCount(0) {}
+      void OnMessage(const dtEntity::Message&) { ++mCount; }
+      unsigned int mCount;
+   };
+
+   ////////////////////////////////////////////////////////////////////////////////
+   class MessageBenchmark : public Benchmark
+   {
+   public:
+      MessageBenchmark(const std::string& name)
+         : Benchmark(name)
+         , mEntityManager(NULL)
+      {
+      }
+
+      virtual bool Setup(const BenchmarkOptions& options)
+      {
+         mEntityManager = new dtEntity::EntityManager();
+         mCounters.resize(options.mSubscribers);
+         for(unsigned int i = 0; i < options.mSubscribers; ++i)
+         {
+            mFunctors.push_back(dtEntity::MessageFunctor(&mCounters[i], &MessageCounter::OnMessage));
+            mEntityManager->RegisterForMessages(dtEntity::TickMessage::TYPE, mFunctors.back());
+         }
+         return true;
+      }
+
+      virtual void TearDown()
+      {
+         for(unsigned int i = 0; i < mFunctors.size(); ++i)
+         {
+            mEntityManager->UnregisterForMessages(dtEntity::TickMessage::TYPE, mFunctors[i]);
+         }
+         mFunctors.clear();
+         mCounters.clear();
+         delete mEntityManager;
+      }
+
+   protected:
+      dtEntity::EntityManager* mEntityManager;
+      std::vector<MessageCounter> mCounters;
+      std::vector<dtEntity::MessageFunctor> mFunctors;
+   };
+
+   ////////////////////////////////////////////////////////////////////////////////
+   class MessageEmit : public MessageBenchmark
+   {
+   public:
+      MessageEmit() : MessageBenchmark("MessageEmit") {}
+
+      virtual void Run(unsigned int iterations)
+      {
+         dtEntity::TickMessage msg;
+         for(unsigned int i = 0; i < iterations; ++i)
+         {
+            mEntityManager->EmitMessage(msg);
+         }
+      }
+   };
+
+   ////////////////////////////////////////////////////////////////////////////////
+   // enqueue and dispatch with next EmitQueuedMessages, one message per operation
+   class MessageEnqueue : public MessageBenchmark
+   {
+   public:
+      MessageEnqueue() : MessageBenchmark("MessageEnqueue") {}
+
+      virtual void Run(unsigned int iterations)
+      {
+         dtEntity::TickMessage msg;
+         const unsigned int batchSize = 64;
+         for(unsigned int i = 0; i < iterations; ++i)
+         {
+            mEntityManager->EnqueueMessage(msg);
+            if((i + 1) % batchSize == 0)
+            {
+               mEntityManager->EmitQueuedMessages(0);
+            }
+         }
+         mEntityManager->EmitQueuedMessages(0);
+      }
+   };
+
+   ////////////////////////////////////////////////////////////////////////////////
+   class StringIdSID : public Benchmark
+   {
+   public:
+      StringIdSID() : Benchmark("SID") {}
+
+      virtual bool Setup(const BenchmarkOptions& options)
+      {
+         for(unsigned int i = 0; i < 64; ++i)
+         {
+            std::ostringstream os;
+            os << "BenchmarkStringId" << i;
+            mStrings.push_back(os.str());
+         }
+         return true;
+      }
+
+      virtual void Run(unsigned int iterations)
+      {
+         dtEntity::StringId id;
+         for(unsigned int i = 0; i < iterations; ++i)
+         {
+            id = dtEntity::SID(mStrings[i % mStrings.size()]);
+         }
+         s_sink = dtEntity::GetStringFromSID(id).size();
+      }
+
+      virtual void TearDown()
+      {
+         mStrings.clear();
+      }
+
+   private:
+      std::vector<std::string> mStrings;
+   };
+
+   ////////////////////////////////////////////////////////////////////////////////
+   class StringIdGetString : public Benchmark
+   {
+   public:
+      StringIdGetString() : Benchmark("GetStringFromSID") {}
+
+      virtual bool Setup(const BenchmarkOptions& options)
+      {
+         for(unsigned int i = 0; i < 64; ++i)
+         {
+            std::ostringstream os;
+            os << "BenchmarkStringId" << i;
+            mIds.push_back(dtEntity::SID(os.str()));
+         }
+         return true;
+      }
+
+      virtual void Run(unsigned int iterations)
+      {
+         std::size_t len = 0;
+         for(unsigned int i = 0; i < iterations; ++i)
+         {
+            len += dtEntity::GetStringFromSID(mIds[i % mIds.size()]).size();
+         }
+         s_sink = static_cast<double>(len);
+      }
+
+      virtual void TearDown()
+      {
+         mIds.clear();
+      }
+
+   private:
+      std::vector<dtEntity::StringId> mIds;
+   };
+
+   ////////////////////////////////////////////////////////////////////////////////
+   class PropertySetGet : public Benchmark
+   {
+   public:
+      PropertySetGet() : Benchmark("PropertyContainerSetGet") {}
+
+      virtual void Run(unsigned int iterations)
+      {
+         double sum = 0;
+         for(unsigned int i = 0; i < iterations; ++i)
+         {
+            mComponent.SetDouble(BenchmarkComponent::ValueId, i);
+            sum += mComponent.GetDouble(BenchmarkComponent::ValueId);
+         }
+         s_sink = sum;
+      }
+
+   private:
+      BenchmarkComponent mComponent;
+   };
+
+   ////////////////////////////////////////////////////////////////////////////////
+   class PropertyVec3SetGet : public Benchmark
+   {
+   public:
+      PropertyVec3SetGet() : Benchmark("PropertyContainerVec3SetGet") {}
+
+      virtual void Run(unsigned int iterations)
+      {
+         double sum = 0;
+         for(unsigned int i = 0; i < iterations; ++i)
+         {
+            mComponent.SetVec3(BenchmarkComponent::PositionId, dtEntity::Vec3f(i, 0, 0));
+            sum += mComponent.GetVec3(BenchmarkComponent::PositionId)[0];
+         }
+         s_sink = sum;
+      }
+
+   private:
+      BenchmarkComponent mComponent;
+   };
+
+   ////////////////////////////////////////////////////////////////////////////////
+   // spawn one entity per operation, includes creating and killing the entity
+   class SpawnerSpawn : public Benchmark
+   {
+   public:
+      SpawnerSpawn()
+         : Benchmark("SpawnerSpawn")
+         , mEntityManager(NULL)
+      {
+      }
+
+      virtual bool Setup(const BenchmarkOptions& options)
+      {
+         mEntityManager = new dtEntity::EntityManager();
+         mEntityManager->AddEntitySystem(*new dtEntity::MapSystem(*mEntityManager));
+         mEntityManager->AddEntitySystem(*new dtEntityOSG::PositionAttitudeTransformSystem(*mEntityManager));
+         mEntityManager->AddEntitySystem(*new BenchmarkSystem(*mEntityManager));
+
+         mSpawner = new dtEntity::Spawner("BenchmarkSpawner", "");
+
+         dtEntity::GroupProperty transprops;
+         transprops.Add(dtEntityOSG::PositionAttitudeTransformComponent::PositionId,
+            new dtEntity::Vec3Property(dtEntity::Vec3f(1, 2, 3)));
+         mSpawner->AddComponent(dtEntityOSG::PositionAttitudeTransformComponent::TYPE, transprops);
+
+         dtEntity::GroupProperty benchprops;
+         benchprops.Add(BenchmarkComponent::ValueId, new dtEntity::DoubleProperty(42));
+         benchprops.Add(BenchmarkComponent::NameId, new dtEntity::StringProperty("Spawned"));
+         mSpawner->AddComponent(BenchmarkComponent::TYPE, benchprops);
+         return true;
+      }
+
+      virtual void Run(unsigned int iterations)
+      {
+         for(unsigned int i = 0; i < iterations; ++i)
+         {
+            dtEntity::Entity* entity;
+            mEntityManager->CreateEntity(entity);
+            mSpawner->Spawn(*entity);
+            mEntityManager->KillEntity(entity->GetId());
+         }
+      }
+
+      virtual void TearDown()
+      {
+         mSpawner = NULL;
+         delete mEntityManager;
+      }
+
+   private:
+      dtEntity::EntityManager* mEntityManager;
+      osg::ref_ptr<dtEntity::Spawner> mSpawner;
+   };
+
+   ////////////////////////////////////////////////////////////////////////////////
+   /**
+    * Saves or loads a map with a number of entities using the encoder
+    * responsible for given extension. Map is written to a temporary
+    * directory that is added to the data paths while the benchmark runs
+    */
+   class MapBenchmark : public Benchmark
+   {
+   public:
+      MapBenchmark(const std::string& name, const std::string& extension, bool load)
+         : Benchmark(name)
+         , mExtension(extension)
+         , mLoad(load)
+         , mEntityManager(NULL)
+         , mMapSystem(NULL)
+      {
+      }
+
+      virtual bool Setup(const BenchmarkOptions& options)
+      {
+         mDataPath = GetTempDirectory() + "/dtEntityBenchmarks";
+         if(!osgDB::makeDirectory(mDataPath))
+         {
+            std::cerr << GetName() << ": could not create directory " << mDataPath << ", skipping" << std::endl;
+            return false;
+         }
+
+         mEntityManager = new dtEntity::EntityManager();
+         dtEntity::SetupDataPaths(0, NULL, false);
+         osgDB::getDataFilePathList().push_back(mDataPath);
+         dtEntity::AddDefaultEntitySystemsAndFactories(0, NULL, *mEntityManager);
+         // transform components are saved to the map and read back when loading
+         if(!mEntityManager->HasEntitySystem(dtEntityOSG::PositionAttitudeTransformComponent::TYPE))
+         {
+            mEntityManager->AddEntitySystem(*new dtEntityOSG::PositionAttitudeTransformSystem(*mEntityManager));
+         }
+         mEntityManager->GetEntitySystem(dtEntity::MapComponent::TYPE, mMapSystem);
+
+         std::string sourcemap = "benchmark_source." + mExtension;
+         mMapName = "benchmark_generated." + mExtension;
+         mMapPath = mDataPath + "/" + mMapName;
+
+         mMapSystem->AddEmptyMap(mDataPath, sourcemap);
+         for(unsigned int i = 0; i < options.mEntities; ++i)
+         {
+            dtEntity::Entity* entity;
+            mEntityManager->CreateEntity(entity);
+
+            dtEntityOSG::PositionAttitudeTransformComponent* transcomp;
+            dtEntity::MapComponent* mapcomp;
+            if(!entity->CreateComponent(transcomp) || !entity->CreateComponent(mapcomp))
+            {
+               std::cerr << GetName() << ": could not create components, skipping" << std::endl;
+               TearDown();
+               return false;
+            }
+            transcomp->SetPosition(dtEntity::Vec3f(i, i, i));
+
+            std::ostringstream uniqueid;
+            uniqueid << "BenchmarkEntity" << i;
+            mapcomp->SetMapName(sourcemap);
+            mapcomp->SetUniqueId(uniqueid.str());
+            mapcomp->SetEntityName(uniqueid.str());
+            mapcomp->Finished();
+            mMapSystem->AddToScene(entity->GetId());
+         }
+
+         if(!mMapSystem->SaveMapAs(sourcemap, mMapPath))
+         {
+            std::cerr << GetName() << ": could not save map " << mMapPath << ", skipping" << std::endl;
+            TearDown();
+            return false;
+         }
+
+         if(mLoad)
+         {
+            mMapSystem->UnloadMap(sourcemap);
+         }
+         else
+         {
+            mMapName = sourcemap;
+         }
+         return true;
+      }
+
+      virtual void Run(unsigned int iterations)
+      {
+         for(unsigned int i = 0; i < iterations; ++i)
+         {
+            if(mLoad)
+            {
+               mMapSystem->LoadMap(mMapName);
+               mMapSystem->UnloadMap(mMapName);
+            }
+            else
+            {
+               mMapSystem->SaveMapAs(mMapName, mMapPath);
+            }
+         }
+      }
+
+      virtual void TearDown()
+      {
+         delete mEntityManager;
+         mEntityManager = NULL;
+         dtEntity::ComponentPluginManager::DestroyInstance();
+         std::remove(mMapPath.c_str());
+         // only removes the directory if it is empty
+         std::remove(mDataPath.c_str());
+
+         osgDB::FilePathList& paths = osgDB::getDataFilePathList();
+         paths.erase(std::remove(paths.begin(), paths.end(), mDataPath), paths.end());
+      }
+
+   private:
+
+      static std::string GetTempDirectory()
+      {
+         const char* vars[] = { "TMPDIR", "TEMP", "TMP" };
+         for(unsigned int i = 0; i < 3; ++i)
+         {
+            const char* dir = getenv(vars[i]);
+            if(dir != NULL && dir[0] != '\0')
+            {
+               return dir;
+            }
+         }
+         return "/tmp";
+      }
+
+      std::string mExtension;
+      bool mLoad;
+      std::string mDataPath;
+      std::string mMapName;
+      std::string mMapPath;
+      dtEntity::EntityManager* mEntityManager;
+      dtEntity::MapSystem* mMapSystem;
+   };
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void RunBenchmark(Benchmark& benchmark, const BenchmarkOptions& options, unsigned int iterations)
+   {
+      if(!options.mFilter.empty() && benchmark.GetName().find(options.mFilter) == std::string::npos)
+      {
+         return;
+      }
+
+      if(!benchmark.Setup(options))
+      {
+         return;
+      }
+
+      // warm up caches and allocator pools
+      benchmark.Run(iterations / 10 + 1);
+
+      unsigned long allocsBefore = s_numAllocations;
+      osg::Timer_t start = osg::Timer::instance()->tick();
+      benchmark.Run(iterations);
+      osg::Timer_t end = osg::Timer::instance()->tick();
+      unsigned long allocs = s_numAllocations - allocsBefore;
+
+      benchmark.TearDown();
+
+      double nsPerOp = osg::Timer::instance()->delta_s(start, end) * 1000000000.0 / iterations;
+      double allocsPerOp = static_cast<double>(allocs) / iterations;
+
+      char line[512];
+      snprintf(line, sizeof(line),
+         "{\"name\":\"%s\",\"iterations\":%u,\"ns_per_op\":%.1f,\"allocs_per_op\":%.2f}",
+         benchmark.GetName().c_str(), iterations, nsPerOp, allocsPerOp);
+      std::cout << line << std::endl;
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int main(int argc, char** argv)
+{
+   osg::ArgumentParser arguments(&argc, argv);
+
+   BenchmarkOptions options;
+   arguments.read("--iterations", options.mIterations);
+   arguments.read("--subscribers", options.mSubscribers);
+   arguments.read("--entities", options.mEntities);
+   arguments.read("--filter", options.mFilter);
+
+   if(options.mIterations == 0)
+   {
+      options.mIterations = 1;
+   }
+
+   // only errors, log output would distort the timings
+   dtEntity::LogManager::GetInstance().AddListener(new dtEntity::ConsoleLogHandler());
+   dtEntity::LogManager::GetInstance().SetLogLevel(dtEntity::LogLevel::LVL_ERROR);
+   dtEntity::RegisterSystemMessages(dtEntity::MessageFactory::GetInstance());
+
+   EntityCreateKill entityCreateKill;
+   RunBenchmark(entityCreateKill, options, options.mIterations);
+
+   ComponentCreateDelete componentCreateDelete;
+   RunBenchmark(componentCreateDelete, options, options.mIterations);
+
+   ComponentGet componentGet;
+   RunBenchmark(componentGet, options, options.mIterations);
+
+   ComponentGetViaEntityManager componentGetViaEntityManager;
+   RunBenchmark(componentGetViaEntityManager, options, options.mIterations);
+
+   MessageEmit messageEmit;
+   RunBenchmark(messageEmit, options, options.mIterations);
+
+   MessageEnqueue messageEnqueue;
+   RunBenchmark(messageEnqueue, options, options.mIterations);
+
+   StringIdSID sid;
+   RunBenchmark(sid, options, options.mIterations);
+
+   StringIdGetString getStringFromSID;
+   RunBenchmark(getStringFromSID, options, options.mIterations);
+
+   PropertySetGet propertySetGet;
+   RunBenchmark(propertySetGet, options, options.mIterations);
+
+   PropertyVec3SetGet propertyVec3SetGet;
+   RunBenchmark(propertyVec3SetGet, options, options.mIterations);
+
+   SpawnerSpawn spawnerSpawn;
+   RunBenchmark(spawnerSpawn, options, options.mIterations);
+
+   // map operations are expensive, scale iterations down
+   unsigned int mapIterations = options.mIterations / 10000 + 1;
+
+   MapBenchmark xmlSave("MapSaveRapidXML", "dtemap", false);
+   RunBenchmark(xmlSave, options, mapIterations);
+
+   MapBenchmark xmlLoad("MapLoadUnloadRapidXML", "dtemap", true);
+   RunBenchmark(xmlLoad, options, mapIterations);
+
+#if PROTOBUF_FOUND
+   MapBenchmark protobufSave("MapSaveProtoBuf", "bmap", false);
+   RunBenchmark(protobufSave, options, mapIterations);
+
+   MapBenchmark protobufLoad("MapLoadUnloadProtoBuf", "bmap", true);
+   RunBenchmark(protobufLoad, options, mapIterations);
+#endif
+
+   return 0;
+}
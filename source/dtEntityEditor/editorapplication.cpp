@@ -21,6 +21,7 @@
 #include <dtEntityEditor/editorapplication.h>
 
 #include <assert.h>
+#include <dtEntity/applicationcomponent.h>
 #include <dtEntity/componentpluginmanager.h>
 #include <dtEntity/core.h>
 #include <dtEntity/entity.h>
@@ -226,6 +227,10 @@ namespace dtEntityEditor
 
          connect(this, SIGNAL(ErrorOccurred(const QString&)),
                  mMainWindow, SLOT(OnDisplayError(const QString&)));
+         connect(this, SIGNAL(MemoryReportCreated(const QString&)),
+                 mMainWindow, SLOT(OnMemoryReport(const QString&)));
+         connect(this, SIGNAL(MessageStatisticsReportCreated(const QString&)),
+                 mMainWindow, SLOT(OnMessageStatisticsReport(const QString&)));
 
          for(std::vector<std::string>::size_type i = 0; i < mPluginPaths.size(); ++i)
          {
@@ -417,6 +422,26 @@ namespace dtEntityEditor
       }
    }
 
+   ////////////////////////////////////////////////////////////////////////////////
+   void EditorApplication::CreateMemoryReport()
+   {
+      dtEntity::ApplicationSystem* appsys;
+      if(GetEntityManager().GetES(appsys))
+      {
+         emit(MemoryReportCreated(QString::fromStdString(appsys->GetMemoryReport())));
+      }
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void EditorApplication::CreateMessageStatisticsReport()
+   {
+      dtEntity::ApplicationSystem* appsys;
+      if(GetEntityManager().GetES(appsys))
+      {
+         emit(MessageStatisticsReportCreated(QString::fromStdString(appsys->GetMessageStatisticsReport())));
+      }
+   }
+
 
    ////////////////////////////////////////////////////////////////////////////////
    void EditorApplication::InitializeScripting()
@@ -122,6 +122,8 @@ namespace dtEntityEditor
       connect(this, SIGNAL(LoadScene(const QString&)), app, SLOT(LoadScene(const QString&)));
       connect(this, SIGNAL(NewScene()), app, SLOT(NewScene()));
       connect(this, SIGNAL(SaveScene(QString)), app, SLOT(SaveScene(QString)));
+      connect(this, SIGNAL(RequestMemoryReport()), app, SLOT(CreateMemoryReport()));
+      connect(this, SIGNAL(RequestMessageStatisticsReport()), app, SLOT(CreateMessageStatisticsReport()));
 
    }
 
@@ -201,6 +203,14 @@ namespace dtEntityEditor
       mAddPluginAct = new QAction(tr("Add Plugin/Library..."), this);
       connect(mAddPluginAct, SIGNAL(triggered()), this, SLOT(OnAddPlugin()));
 
+      mMemoryReportAct = new QAction(tr("Memory Report..."), this);
+      mMemoryReportAct->setStatusTip(tr("Show component counts and memory per entity system"));
+      connect(mMemoryReportAct, SIGNAL(triggered()), this, SLOT(OnShowMemoryReport()));
+
+      mMessageStatisticsAct = new QAction(tr("Message Statistics..."), this);
+      mMessageStatisticsAct->setStatusTip(tr("Show dispatch counts and times per message type"));
+      connect(mMessageStatisticsAct, SIGNAL(triggered()), this, SLOT(OnShowMessageStatisticsReport()));
+
       mExitAct = new QAction(tr("E&xit"), this);
 
 #if (QT_VERSION >= QT_VERSION_CHECK(4, 6, 0))
@@ -231,6 +241,8 @@ namespace dtEntityEditor
       //mEditMenu = menuBar()->addMenu(tr("&Edit"));
 
       mViewMenu = menuBar()->addMenu(tr("&View"));
+      mViewMenu->addAction(mMemoryReportAct);
+      mViewMenu->addAction(mMessageStatisticsAct);
 
    }
 
@@ -549,6 +561,32 @@ namespace dtEntityEditor
       QMessageBox::warning(this, "RDEViewer", msg);
    }
 
+   ////////////////////////////////////////////////////////////////////////////////
+   void EditorMainWindow::OnShowMemoryReport()
+   {
+      // report is created in simulation thread and sent back with OnMemoryReport
+      emit RequestMemoryReport();
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void EditorMainWindow::OnMemoryReport(const QString& report)
+   {
+      QMessageBox::information(this, tr("Memory Report"), QString("<pre>%1</pre>").arg(report));
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void EditorMainWindow::OnShowMessageStatisticsReport()
+   {
+      // report is created in simulation thread and sent back with OnMessageStatisticsReport
+      emit RequestMessageStatisticsReport();
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void EditorMainWindow::OnMessageStatisticsReport(const QString& report)
+   {
+      QMessageBox::information(this, tr("Message Statistics"), QString("<pre>%1</pre>").arg(report));
+   }
+
    ////////////////////////////////////////////////////////////////////////////////
    void EditorMainWindow::OnChooseDataPaths()
    {
@@ -0,0 +1,325 @@
+/* -*-c++-*-
+* dtEntity Game and Simulation Engine
+*
+* This library is free software; you can redistribute it and/or modify it under
+* the terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; either version 2.1 of the License, or (at your option)
+* any later version.
+*
+* This library is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+* details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this library; if not, write to the Free Software Foundation, Inc.,
+* 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*
+* Martin Scheffler
+*/
+
+// Runs a scene without a viewer or a window, for example on build servers.
+// The simulation is stepped with a fixed time step as fast as possible,
+// afterwards ticks per second, time spent in message subscribers
+// and component memory are printed.
+//
+// dtEntityHeadless --scene Scenes/test.dtescene --spawner Enemy --count 1000 --ticks 10000
+//                  [--timestep 0.01] [--map Maps/extra.dtemap] [--plugin name] [--profile systems,io]
+//
+// --profile is handled by CProfileManager::Setup_From_Command_Line and is only
+// available if dtEntity was built with profiling enabled.
+
+#include <dtEntity/applicationcomponent.h>
+#include <dtEntity/componentplugin.h>
+#include <dtEntity/componentpluginmanager.h>
+#include <dtEntity/core.h>
+#include <dtEntity/dtentity_config.h>
+#include <dtEntity/entity.h>
+#include <dtEntity/entitymanager.h>
+#include <dtEntity/headlesssysteminterface.h>
+#include <dtEntity/init.h>
+#include <dtEntity/log.h>
+#include <dtEntity/mapcomponent.h>
+#include <dtEntity/messagepump.h>
+#include <dtEntity/systemmessages.h>
+#include <dtEntityOSG/groupcomponent.h>
+#include <dtEntityOSG/layerattachpointcomponent.h>
+#include <dtEntityOSG/layercomponent.h>
+#include <dtEntityOSG/matrixtransformcomponent.h>
+#include <dtEntityOSG/nodecomponent.h>
+#include <dtEntityOSG/positionattitudetransformcomponent.h>
+#include <dtEntityOSG/staticmeshcomponent.h>
+#include <dtEntityOSG/transformcomponent.h>
+#include <osg/Timer>
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#if DTENTITY_PROFILING_ENABLED
+#include <dtEntity/profile.h>
+#endif
+
+namespace
+{
+   struct HeadlessOptions
+   {
+      HeadlessOptions()
+         : mCount(0)
+         , mTicks(1000)
+         , mTimeStep(1.0f / 60.0f)
+         , mConsoleLog(false)
+      {
+      }
+
+      std::string mScene;
+      std::vector<std::string> mMaps;
+      std::vector<std::string> mPlugins;
+      std::string mSpawner;
+      unsigned int mCount;
+      unsigned int mTicks;
+      float mTimeStep;
+      bool mConsoleLog;
+   };
+
+   ////////////////////////////////////////////////////////////////////////////////
+   template <typename T>
+   void ReadArg(int argc, char** argv, int& curArg, T& value)
+   {
+      ++curArg;
+      if(curArg < argc)
+      {
+         std::istringstream iss(argv[curArg]);
+         iss >> value;
+      }
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void ReadArg(int argc, char** argv, int& curArg, std::string& value)
+   {
+      ++curArg;
+      if(curArg < argc)
+      {
+         value = argv[curArg];
+      }
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void ParseArgs(int argc, char** argv, HeadlessOptions& options)
+   {
+      for(int curArg = 1; curArg < argc; ++curArg)
+      {
+         std::string curArgv = argv[curArg];
+         if(curArgv == "--scene")
+         {
+            ReadArg(argc, argv, curArg, options.mScene);
+         }
+         else if(curArgv == "--map")
+         {
+            std::string map;
+            ReadArg(argc, argv, curArg, map);
+            options.mMaps.push_back(map);
+         }
+         else if(curArgv == "--plugin")
+         {
+            std::string plugin;
+            ReadArg(argc, argv, curArg, plugin);
+            options.mPlugins.push_back(plugin);
+         }
+         else if(curArgv == "--spawner")
+         {
+            ReadArg(argc, argv, curArg, options.mSpawner);
+         }
+         else if(curArgv == "--count")
+         {
+            ReadArg(argc, argv, curArg, options.mCount);
+         }
+         else if(curArgv == "--ticks")
+         {
+            ReadArg(argc, argv, curArg, options.mTicks);
+         }
+         else if(curArgv == "--timestep")
+         {
+            ReadArg(argc, argv, curArg, options.mTimeStep);
+         }
+         else if(curArgv == "--log")
+         {
+            options.mConsoleLog = true;
+         }
+      }
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   // Systems that only build scene graph nodes work without a viewer. Camera and
+   // shadow systems expect an OSGSystemInterface and are not registered.
+   void RegisterHeadlessFactories(dtEntity::ComponentPluginManager& pm)
+   {
+      pm.AddFactory(new dtEntity::ComponentPluginFactoryImpl<dtEntityOSG::GroupSystem>("Group"));
+      pm.AddFactory(new dtEntity::ComponentPluginFactoryImpl<dtEntityOSG::NodeSystem>("Node"));
+      pm.AddFactory(new dtEntity::ComponentPluginFactoryImpl<dtEntityOSG::TransformSystem>("Transform"));
+      pm.AddFactory(new dtEntity::ComponentPluginFactoryImpl<dtEntityOSG::PositionAttitudeTransformSystem>("PositionAttitudeTransform"));
+      pm.AddFactory(new dtEntity::ComponentPluginFactoryImpl<dtEntityOSG::MatrixTransformSystem>("MatrixTransform"));
+      pm.AddFactory(new dtEntity::ComponentPluginFactoryImpl<dtEntityOSG::LayerAttachPointSystem>("LayerAttachPoint"));
+      pm.AddFactory(new dtEntity::ComponentPluginFactoryImpl<dtEntityOSG::LayerSystem>("Layer"));
+      pm.AddFactory(new dtEntity::ComponentPluginFactoryImpl<dtEntityOSG::StaticMeshSystem>("StaticMesh"));
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   typedef std::pair<dtEntity::StringId, dtEntity::SubscriberTiming> NamedTiming;
+
+   bool SlowerThan(const NamedTiming& a, const NamedTiming& b)
+   {
+      return a.second.mTime > b.second.mTime;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void PrintSubscriberTimings(const dtEntity::MessagePump& pump, unsigned int ticks)
+   {
+      const dtEntity::MessagePump::SubscriberTimingMap& timings = pump.GetSubscriberTimings();
+      std::vector<NamedTiming> sorted(timings.begin(), timings.end());
+      std::sort(sorted.begin(), sorted.end(), SlowerThan);
+
+      std::cout << std::left << std::setw(48) << "Subscriber"
+                << std::right << std::setw(12) << "Calls"
+                << std::setw(14) << "Total ms"
+                << std::setw(14) << "us per tick" << "\n";
+
+      for(std::vector<NamedTiming>::const_iterator i = sorted.begin(); i != sorted.end(); ++i)
+      {
+         if(i->second.mNumCalls == 0)
+         {
+            continue;
+         }
+         std::cout << std::left << std::setw(48) << dtEntity::GetStringFromSID(i->first)
+                   << std::right << std::setw(12) << i->second.mNumCalls
+                   << std::setw(14) << std::fixed << std::setprecision(3) << i->second.mTime * 1000
+                   << std::setw(14) << i->second.mTime * 1000000 / std::max(ticks, 1u) << "\n";
+      }
+      std::cout.unsetf(std::ios::floatfield);
+   }
+}
+
+int main(int argc, char** argv)
+{
+   HeadlessOptions options;
+   ParseArgs(argc, argv, options);
+
+   if(options.mConsoleLog)
+   {
+      dtEntity::LogManager::GetInstance().AddListener(new dtEntity::ConsoleLogHandler());
+   }
+
+#if DTENTITY_PROFILING_ENABLED
+   bool profiling = CProfileManager::Setup_From_Command_Line(argc, argv);
+#endif
+
+   dtEntity::EntityManager entityManager;
+
+   dtEntity::HeadlessSystemInterface* iface = new dtEntity::HeadlessSystemInterface(entityManager.GetMessagePump());
+   iface->SetFixedTimeStep(options.mTimeStep);
+   dtEntity::SetSystemInterface(iface);
+
+   dtEntity::SetupDataPaths(argc, argv, false);
+   dtEntity::AddDefaultEntitySystemsAndFactories(argc, argv, entityManager);
+
+   dtEntity::ComponentPluginManager& pm = dtEntity::ComponentPluginManager::GetInstance();
+   RegisterHeadlessFactories(pm);
+   for(std::vector<std::string>::const_iterator i = options.mPlugins.begin(); i != options.mPlugins.end(); ++i)
+   {
+      pm.AddPlugin("plugins/", *i, true);
+      if(pm.GetLoadedPlugins().find(*i) == pm.GetLoadedPlugins().end())
+      {
+         LOG_ERROR("Could not load plugin " + *i);
+         return 1;
+      }
+   }
+
+   dtEntity::MapSystem* mapSystem;
+   entityManager.GetES(mapSystem);
+
+   if(!options.mScene.empty() && !mapSystem->LoadScene(options.mScene))
+   {
+      LOG_ERROR("Could not load scene " + options.mScene);
+      return 1;
+   }
+
+   for(std::vector<std::string>::const_iterator i = options.mMaps.begin(); i != options.mMaps.end(); ++i)
+   {
+      if(!mapSystem->LoadMap(*i))
+      {
+         LOG_ERROR("Could not load map " + *i);
+         return 1;
+      }
+   }
+
+   dtEntity::StartSystemMessage startmsg;
+   entityManager.EnqueueMessage(startmsg);
+
+   osg::Timer* timer = osg::Timer::instance();
+
+   if(options.mCount != 0)
+   {
+      dtEntity::Spawner* spawner;
+      if(!mapSystem->GetSpawner(options.mSpawner, spawner))
+      {
+         LOG_ERROR("Spawner not found: " + options.mSpawner);
+         return 1;
+      }
+
+      osg::Timer_t spawnStart = timer->tick();
+      for(unsigned int i = 0; i < options.mCount; ++i)
+      {
+         dtEntity::Entity* entity;
+         entityManager.CreateEntity(entity);
+         spawner->Spawn(*entity);
+         mapSystem->AddToScene(entity->GetId());
+      }
+      std::cout << "Spawned " << options.mCount << " entities from " << options.mSpawner
+                << " in " << timer->delta_m(spawnStart, timer->tick()) << " ms\n";
+   }
+
+   dtEntity::MessagePump& pump = entityManager.GetMessagePump();
+   pump.ResetSubscriberTimings();
+   pump.SetSubscriberTimingEnabled(true);
+
+   osg::Timer_t runStart = timer->tick();
+   for(unsigned int i = 0; i < options.mTicks; ++i)
+   {
+#if DTENTITY_PROFILING_ENABLED
+      if(profiling)
+      {
+         CProfileManager::Increment_Frame_Counter();
+      }
+#endif
+      iface->EmitTickMessagesAndQueuedMessages();
+   }
+   double runTime = timer->delta_s(runStart, timer->tick());
+
+   pump.SetSubscriberTimingEnabled(false);
+
+   std::cout << "Ticks: " << options.mTicks
+             << ", time step: " << options.mTimeStep << " s"
+             << ", simulation time: " << iface->GetSimulationTime() << " s"
+             << ", wall time: " << runTime << " s"
+             << ", ticks per second: " << (runTime > 0 ? options.mTicks / runTime : 0) << "\n\n";
+
+   PrintSubscriberTimings(pump, options.mTicks);
+   std::cout << "\n";
+
+   dtEntity::ApplicationSystem* appsys;
+   if(entityManager.GetES(appsys))
+   {
+      std::cout << appsys->GetMemoryReport();
+   }
+
+#if DTENTITY_PROFILING_ENABLED
+   if(profiling)
+   {
+      std::cout << "\n";
+      CProfileManager::dumpAll();
+   }
+#endif
+
+   return 0;
+}
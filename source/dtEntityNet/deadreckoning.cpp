@@ -20,6 +20,10 @@
 
 #include <dtEntityNet/deadreckoning.h>
 
+#include <algorithm>
+#include <assert.h>
+#include <math.h>
+
 #define ANGLE_MIN_DELTA 0.001
 
 namespace dtEntityNet
@@ -31,6 +35,13 @@ namespace dtEntityNet
       {
          if(v == "STATIC") return STATIC;
          if(v == "FPW") return FPW;
+         if(v == "RPW") return RPW;
+         if(v == "RVW") return RVW;
+         if(v == "FVW") return FVW;
+         if(v == "FPB") return FPB;
+         if(v == "RPB") return RPB;
+         if(v == "RVB") return RVB;
+         if(v == "FVB") return FVB;
          return DISABLED;
       }
 
@@ -40,52 +51,223 @@ namespace dtEntityNet
          {
          case STATIC: return "STATIC";
          case FPW: return "FPW";
+         case RPW: return "RPW";
+         case RVW: return "RVW";
+         case FVW: return "FVW";
+         case FPB: return "FPB";
+         case RPB: return "RPB";
+         case RVB: return "RVB";
+         case FVB: return "FVB";
          default: return "DISABLED";
          }
       }
+
+      bool IsRotating(e v)
+      {
+         return v == RPW || v == RVW || v == RPB || v == RVB;
+      }
+
+      bool UsesAcceleration(e v)
+      {
+         return v == RVW || v == FVW || v == RVB || v == FVB;
+      }
+
+      bool IsBodyCoordinates(e v)
+      {
+         return v == FPB || v == RPB || v == RVB || v == FVB;
+      }
+   }
+
+   namespace ConvergenceMethod
+   {
+      e fromString(const std::string& v)
+      {
+         if(v == "PVB") return PVB;
+         if(v == "BEZIER") return BEZIER;
+         return NONE;
+      }
+
+      std::string toString(e v)
+      {
+         switch(v)
+         {
+         case PVB: return "PVB";
+         case BEZIER: return "BEZIER";
+         default: return "NONE";
+         }
+      }
    }
 
    ////////////////////////////////////////////////////////////////////////////////
-   // calculations lifted from KDIS - http://http://sourceforge.net/projects/kdis/
-   inline const float checkAngleHR( const float a)
+   /**
+    * Position offset of a body that rotates with world angular velocity w while
+    * moving with velocity vel and acceleration acc (both given in world coords at t=0).
+    * Velocity at time s is Rot(w s) * (vel + acc * s), so
+    * offset = R1 * vel + R2 * acc with
+    * R1 = integral over s from 0 to t of Rot(w s)
+    * R2 = integral over s from 0 to t of s * Rot(w s)
+    * These are the R1 and R2 matrices of the DIS standard (IEEE 1278.1 annex E),
+    * expanded into terms of identity, cross product with w and projection onto w.
+    */
+   inline osg::Vec3d RotatingBodyOffset(const osg::Vec3d& w, double t,
+                                        const osg::Vec3d& vel, const osg::Vec3d& acc)
    {
-       if (a < -osg::PI) return (a + osg::PI * 2);
-       else if (a > osg::PI) return (a - osg::PI * 2);
-       return a;
+      const double wl = w.length();
+      if(wl < ANGLE_MIN_DELTA)
+      {
+         return vel * t + acc * (0.5 * t * t);
+      }
+      const double wt = wl * t;
+      const double s = sin(wt);
+      const double c = cos(wt);
+      const double wl2 = wl * wl;
+      const double wl3 = wl2 * wl;
+      const double wl4 = wl2 * wl2;
+
+      const double r1i = s / wl;
+      const double r1c = (1 - c) / wl2;
+      const double r1p = (wt - s) / wl3;
+
+      const double r2i = (wt * s + c - 1) / wl2;
+      const double r2c = (s - wt * c) / wl3;
+      const double r2p = (0.5 * wt * wt - wt * s - c + 1) / wl4;
+
+      return vel * r1i + (w ^ vel) * r1c + w * ((w * vel) * r1p) +
+             acc * r2i + (w ^ acc) * r2c + w * ((w * acc) * r2p);
    }
 
+   ////////////////////////////////////////////////////////////////////////////////
+   inline osg::Quat RotationFromAngularVelocity(const osg::Vec3d& w, double t)
+   {
+      const double wl = w.length();
+      if(wl * t == 0)
+      {
+         return osg::Quat(0, 0, 0, 1);
+      }
+      return osg::Quat(wl * t, w / wl);
+   }
 
    ////////////////////////////////////////////////////////////////////////////////
-   void CalculateDRFPW(const osg::Vec3d& lastpos,
-                       const osg::Vec3f& lastrot,
+   void CalculateDeadReckoning(DeadReckoningAlgorithm::e alg,
+                       const osg::Vec3d& lastpos,
+                       const osg::Quat& lastrot,
                        const osg::Vec3f& lastvel,
+                       const osg::Vec3f& lastacc,
                        const osg::Vec3f& lastangularvel,
                        float timeSinceLastData,
                        osg::Vec3d& newpos,
-                       osg::Vec3f& newrot)
+                       osg::Quat& newrot)
    {
-      newpos = lastpos + lastvel * timeSinceLastData;
-      newrot = lastrot + lastangularvel * timeSinceLastData;
+      if(alg == DeadReckoningAlgorithm::DISABLED || alg == DeadReckoningAlgorithm::STATIC)
+      {
+         newpos = lastpos;
+         newrot = lastrot;
+         return;
+      }
 
-      // make sure the Pitch is between -90 and +90 degrees
-      // also handle the discontinuity when Pitch is very close to +-90
+      const double t = timeSinceLastData;
+      osg::Vec3d vel = lastvel;
+      osg::Vec3d acc;
+      if(DeadReckoningAlgorithm::UsesAcceleration(alg))
+      {
+         acc = lastacc;
+      }
 
-      if(fabs(newrot[1] - osg::PI_2) < ANGLE_MIN_DELTA)
+      if(DeadReckoningAlgorithm::IsBodyCoordinates(alg))
       {
-         newrot[0] = osg::PI - newrot[0]; //reflecting the heading angle, to avoid discontinuity
+         vel = lastrot * vel;
+         acc = lastrot * acc;
+      }
 
-         if(newrot[1] < 0)
-         {
-            newrot[1] = -osg::PI_2 - newrot[1];
-         }
-         else if(newrot[1] > 0)
+      if(DeadReckoningAlgorithm::IsRotating(alg))
+      {
+         const osg::Vec3d w = lastangularvel;
+         newrot = lastrot * RotationFromAngularVelocity(w, t);
+
+         if(DeadReckoningAlgorithm::IsBodyCoordinates(alg))
          {
-            newrot[1] = osg::PI_2 - newrot[1];
+            // velocity rotates with the body
+            newpos = lastpos + RotatingBodyOffset(w, t, vel, acc);
+            return;
          }
       }
-      newrot[0] = checkAngleHR(newrot[0]);
-      newrot[2] = checkAngleHR(newrot[2]);
+      else
+      {
+         newrot = lastrot;
+      }
+      newpos = lastpos + vel * t + acc * (0.5 * t * t);
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   osg::Vec3d ProjectiveVelocityBlend(const osg::Vec3d& startpos,
+                       const osg::Vec3d& startvel,
+                       const osg::Vec3d& newvel,
+                       const osg::Vec3d& newacc,
+                       const osg::Vec3d& extrapolated,
+                       double t,
+                       double blendtime)
+   {
+      if(t >= blendtime || blendtime <= 0)
+      {
+         return extrapolated;
+      }
+      const double a = t / blendtime;
+
+      // blend from displayed velocity to received velocity
+      const osg::Vec3d blendvel = startvel + (newvel - startvel) * a;
+
+      // project displayed position with blended velocity
+      const osg::Vec3d projected = startpos + blendvel * t + newacc * (0.5 * t * t);
 
+      return projected + (extrapolated - projected) * a;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   osg::Vec3d BezierBlend(const osg::Vec3d& startpos,
+                       const osg::Vec3d& startvel,
+                       const osg::Vec3d& endpos,
+                       const osg::Vec3d& endvel,
+                       double t,
+                       double blendtime)
+   {
+      if(t >= blendtime || blendtime <= 0)
+      {
+         return endpos + endvel * (t - blendtime);
+      }
+      const double a = t / blendtime;
+      const double b = 1 - a;
+
+      // control points are placed so that curve starts with displayed velocity
+      // and ends with dead reckoned velocity
+      const osg::Vec3d p1 = startpos + startvel * (blendtime / 3.0);
+      const osg::Vec3d p2 = endpos - endvel * (blendtime / 3.0);
+
+      return startpos * (b * b * b) + p1 * (3 * a * b * b) + p2 * (3 * a * a * b) + endpos * (a * a * a);
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   osg::Vec3f AngularVelocityFromQuat(const osg::Quat& q)
+   {
+      double angle;
+      osg::Vec3d axis;
+      q.getRotate(angle, axis);
+      if(angle == 0 || axis.length2() == 0)
+      {
+         return osg::Vec3f();
+      }
+      // use shortest rotation
+      if(angle > osg::PI)
+      {
+         angle -= 2 * osg::PI;
+      }
+      axis.normalize();
+      return axis * angle;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   osg::Quat AngularVelocityToQuat(const osg::Vec3f& v)
+   {
+      return RotationFromAngularVelocity(v, 1);
    }
 
    ////////////////////////////////////////////////////////////////////////////////
@@ -156,4 +338,229 @@ namespace dtEntityNet
 
       return ret;
    }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   ////////////////////////////////////////////////////////////////////////////////
+   DeadReckoningBatch::DeadReckoningBatch()
+      : mRotatingDirty(false)
+   {
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   unsigned int DeadReckoningBatch::Add()
+   {
+      unsigned int idx = Size();
+      mAlgorithm.push_back(DeadReckoningAlgorithm::DISABLED);
+      mTime.push_back(0);
+      for(unsigned int k = 0; k < 3; ++k)
+      {
+         mPos[k].push_back(0);
+         mVel[k].push_back(0);
+         mAcc[k].push_back(0);
+         mAngVel[k].push_back(0);
+         mOutPos[k].push_back(0);
+      }
+      for(unsigned int k = 0; k < 4; ++k)
+      {
+         double v = (k == 3) ? 1 : 0;
+         mRot[k].push_back(v);
+         mOutRot[k].push_back(v);
+      }
+      return idx;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   bool DeadReckoningBatch::Remove(unsigned int idx)
+   {
+      assert(idx < Size());
+      unsigned int last = Size() - 1;
+      bool moved = (idx != last);
+      if(moved)
+      {
+         mAlgorithm[idx] = mAlgorithm[last];
+         mTime[idx] = mTime[last];
+         for(unsigned int k = 0; k < 3; ++k)
+         {
+            mPos[k][idx] = mPos[k][last];
+            mVel[k][idx] = mVel[k][last];
+            mAcc[k][idx] = mAcc[k][last];
+            mAngVel[k][idx] = mAngVel[k][last];
+            mOutPos[k][idx] = mOutPos[k][last];
+         }
+         for(unsigned int k = 0; k < 4; ++k)
+         {
+            mRot[k][idx] = mRot[k][last];
+            mOutRot[k][idx] = mOutRot[k][last];
+         }
+      }
+
+      mAlgorithm.pop_back();
+      mTime.pop_back();
+      for(unsigned int k = 0; k < 3; ++k)
+      {
+         mPos[k].pop_back();
+         mVel[k].pop_back();
+         mAcc[k].pop_back();
+         mAngVel[k].pop_back();
+         mOutPos[k].pop_back();
+      }
+      for(unsigned int k = 0; k < 4; ++k)
+      {
+         mRot[k].pop_back();
+         mOutRot[k].pop_back();
+      }
+      mRotatingDirty = true;
+      return moved;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void DeadReckoningBatch::Clear()
+   {
+      mAlgorithm.clear();
+      mTime.clear();
+      for(unsigned int k = 0; k < 3; ++k)
+      {
+         mPos[k].clear();
+         mVel[k].clear();
+         mAcc[k].clear();
+         mAngVel[k].clear();
+         mOutPos[k].clear();
+      }
+      for(unsigned int k = 0; k < 4; ++k)
+      {
+         mRot[k].clear();
+         mOutRot[k].clear();
+      }
+      mRotating.clear();
+      mRotatingDirty = false;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void DeadReckoningBatch::Set(unsigned int idx,
+            DeadReckoningAlgorithm::e alg,
+            double simtime,
+            const osg::Vec3d& pos,
+            const osg::Quat& rot,
+            const osg::Vec3f& vel,
+            const osg::Vec3f& acc,
+            const osg::Vec3f& angularvel)
+   {
+      assert(idx < Size());
+
+      if(DeadReckoningAlgorithm::IsRotating(GetAlgorithm(idx)) != DeadReckoningAlgorithm::IsRotating(alg))
+      {
+         mRotatingDirty = true;
+      }
+
+      osg::Vec3d v, a, w;
+      if(alg != DeadReckoningAlgorithm::DISABLED && alg != DeadReckoningAlgorithm::STATIC)
+      {
+         v = vel;
+         if(DeadReckoningAlgorithm::UsesAcceleration(alg))
+         {
+            a = acc;
+         }
+         if(DeadReckoningAlgorithm::IsBodyCoordinates(alg))
+         {
+            v = rot * v;
+            a = rot * a;
+         }
+         if(DeadReckoningAlgorithm::IsRotating(alg))
+         {
+            w = angularvel;
+         }
+      }
+
+      mAlgorithm[idx] = alg;
+      mTime[idx] = simtime;
+      for(unsigned int k = 0; k < 3; ++k)
+      {
+         mPos[k][idx] = pos[k];
+         mVel[k][idx] = v[k];
+         mAcc[k][idx] = a[k];
+         mAngVel[k][idx] = w[k];
+      }
+      for(unsigned int k = 0; k < 4; ++k)
+      {
+         mRot[k][idx] = rot[k];
+      }
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void DeadReckoningBatch::UpdateRotatingList()
+   {
+      mRotating.clear();
+      unsigned int n = Size();
+      for(unsigned int i = 0; i < n; ++i)
+      {
+         if(DeadReckoningAlgorithm::IsRotating(GetAlgorithm(i)))
+         {
+            mRotating.push_back(i);
+         }
+      }
+      mRotatingDirty = false;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void DeadReckoningBatch::Extrapolate(double simtime)
+   {
+      const unsigned int n = Size();
+      if(n == 0)
+      {
+         return;
+      }
+
+      // linear part for all slots: p + v * t + 0.5 * a * t^2
+      // Static and disabled slots have zero velocity and acceleration.
+      const double* time = &mTime[0];
+      for(unsigned int k = 0; k < 3; ++k)
+      {
+         const double* pos = &mPos[k][0];
+         const double* vel = &mVel[k][0];
+         const double* acc = &mAcc[k][0];
+         double* out = &mOutPos[k][0];
+
+         for(unsigned int i = 0; i < n; ++i)
+         {
+            const double t = simtime - time[i];
+            out[i] = pos[i] + t * (vel[i] + 0.5 * t * acc[i]);
+         }
+      }
+
+      for(unsigned int k = 0; k < 4; ++k)
+      {
+         std::copy(mRot[k].begin(), mRot[k].end(), mOutRot[k].begin());
+      }
+
+      if(mRotatingDirty)
+      {
+         UpdateRotatingList();
+      }
+
+      // rotating slots: update orientation, for body coordinate algorithms
+      // the linear velocity turns with the body
+      for(std::vector<unsigned int>::const_iterator i = mRotating.begin(); i != mRotating.end(); ++i)
+      {
+         const unsigned int idx = *i;
+         const double t = simtime - time[idx];
+         const osg::Vec3d w(mAngVel[0][idx], mAngVel[1][idx], mAngVel[2][idx]);
+         const osg::Quat rot(mRot[0][idx], mRot[1][idx], mRot[2][idx], mRot[3][idx]);
+         const osg::Quat newrot = rot * RotationFromAngularVelocity(w, t);
+         for(unsigned int k = 0; k < 4; ++k)
+         {
+            mOutRot[k][idx] = newrot[k];
+         }
+
+         if(DeadReckoningAlgorithm::IsBodyCoordinates(GetAlgorithm(idx)))
+         {
+            const osg::Vec3d vel(mVel[0][idx], mVel[1][idx], mVel[2][idx]);
+            const osg::Vec3d acc(mAcc[0][idx], mAcc[1][idx], mAcc[2][idx]);
+            const osg::Vec3d offset = RotatingBodyOffset(w, t, vel, acc);
+            for(unsigned int k = 0; k < 3; ++k)
+            {
+               mOutPos[k][idx] = mPos[k][idx] + offset[k];
+            }
+         }
+      }
+   }
 }
@@ -34,6 +34,9 @@
 
 namespace dtEntityNet
 {
+   // batch index of components that did not yet receive a transform
+   static const unsigned int NO_BATCH_SLOT = (unsigned int)-1;
+
    ////////////////////////////////////////////////////////////////////////////
    ////////////////////////////////////////////////////////////////////////////
    const dtEntity::StringId DeadReckoningReceiverComponent::TYPE(dtEntity::SID("DeadReckoningReceiver"));
@@ -45,6 +48,8 @@ namespace dtEntityNet
       , mDynamicsComponent(NULL)
       , mTimeLastReceive(0)
       , mDeadRecAlg(DeadReckoningAlgorithm::DISABLED)
+      , mBatchIndex(NO_BATCH_SLOT)
+      , mIsBlending(false)
    {
       Register(UniqueIdId, &mUniqueId);
    }
@@ -52,6 +57,8 @@ namespace dtEntityNet
    ////////////////////////////////////////////////////////////////////////////
    const dtEntity::StringId DeadReckoningReceiverSystem::TYPE(dtEntity::SID("DeadReckoningReceiver"));
    const dtEntity::StringId DeadReckoningReceiverSystem::SpawnFromEntityTypeId(dtEntity::SID("SpawnFromEntityType"));
+   const dtEntity::StringId DeadReckoningReceiverSystem::ConvergenceMethodId(dtEntity::SID("ConvergenceMethod"));
+   const dtEntity::StringId DeadReckoningReceiverSystem::ConvergenceTimeId(dtEntity::SID("ConvergenceTime"));
 
    ////////////////////////////////////////////////////////////////////////////
    ////////////////////////////////////////////////////////////////////////////
@@ -59,6 +66,12 @@ namespace dtEntityNet
    DeadReckoningReceiverSystem::DeadReckoningReceiverSystem(dtEntity::EntityManager& em)
       : BaseClass(em)
       , mMapSystem(NULL)
+      , mConvergenceMethod(
+           dtEntity::DynamicStringProperty::SetValueCB(this, &DeadReckoningReceiverSystem::SetConvergenceMethodString),
+           dtEntity::DynamicStringProperty::GetValueCB(this, &DeadReckoningReceiverSystem::GetConvergenceMethodString)
+        )
+      , mConvergence(ConvergenceMethod::PVB)
+      , mSimulationTime(0)
    {
       mTickFunctor = dtEntity::MessageFunctor(this, &DeadReckoningReceiverSystem::Tick);
 
@@ -67,6 +80,10 @@ namespace dtEntityNet
       Register(SpawnFromEntityTypeId, &mSpawnFromEntityType);
       mSpawnFromEntityType.Set(true);
 
+      Register(ConvergenceMethodId, &mConvergenceMethod);
+      Register(ConvergenceTimeId, &mConvergenceTime);
+      mConvergenceTime.Set(0.5f);
+
    }
 
    ////////////////////////////////////////////////////////////////////////////
@@ -88,84 +105,110 @@ namespace dtEntityNet
       GetEntityManager().UnregisterForMessages(dtEntity::TickMessage::TYPE, mTickFunctor);
    }
 
+   ////////////////////////////////////////////////////////////////////////////
+   void DeadReckoningReceiverSystem::SetConvergenceMethodString(const std::string& v)
+   {
+      mConvergence = ConvergenceMethod::fromString(v);
+   }
+
+   ////////////////////////////////////////////////////////////////////////////
+   std::string DeadReckoningReceiverSystem::GetConvergenceMethodString() const
+   {
+      return ConvergenceMethod::toString(mConvergence);
+   }
+
+   ////////////////////////////////////////////////////////////////////////////
+   bool DeadReckoningReceiverSystem::DeleteComponent(dtEntity::EntityId eid)
+   {
+      DeadReckoningReceiverComponent* comp = GetComponent(eid);
+      if(comp != NULL && comp->mBatchIndex != NO_BATCH_SLOT)
+      {
+         ReleaseBatchSlot(comp);
+      }
+      return BaseClass::DeleteComponent(eid);
+   }
+
+   ////////////////////////////////////////////////////////////////////////////
+   void DeadReckoningReceiverSystem::ReleaseBatchSlot(DeadReckoningReceiverComponent* comp)
+   {
+      unsigned int idx = comp->mBatchIndex;
+      if(mBatch.Remove(idx))
+      {
+         // last slot was moved into released slot
+         mSlotOwners[idx] = mSlotOwners.back();
+         mSlotOwners[idx]->mBatchIndex = idx;
+      }
+      mSlotOwners.pop_back();
+      comp->mBatchIndex = NO_BATCH_SLOT;
+   }
+
    ////////////////////////////////////////////////////////////////////////////
    void DeadReckoningReceiverSystem::Tick(const dtEntity::Message& m)
    {
       const dtEntity::TickMessage& msg = static_cast<const dtEntity::TickMessage&>(m);
+      const double simtime = msg.GetSimulationTime();
+      const float dt = msg.GetDeltaSimTime();
+      const double blendtime = GetConvergenceTime();
 
-      for(ComponentStore::iterator i = mComponents.begin();i != mComponents.end(); ++i)
-      {
-         dtEntity::EntityId id = i->first;
-         DeadReckoningReceiverComponent* comp = i->second;
+      mSimulationTime = simtime;
 
-         // if did not yet receive a valid position
-         if(comp->mTimeLastReceive == 0)
-         {
-            continue;
-         }
+      // extrapolate all remote entities in one go
+      mBatch.Extrapolate(simtime);
+
+      unsigned int numslots = mBatch.Size();
+      for(unsigned int i = 0; i < numslots; ++i)
+      {
+         DeadReckoningAlgorithm::e alg = mBatch.GetAlgorithm(i);
 
-         if(comp->mDeadRecAlg == DeadReckoningAlgorithm::DISABLED)
+         // static entities are positioned when transform is received
+         if(alg == DeadReckoningAlgorithm::DISABLED || alg == DeadReckoningAlgorithm::STATIC)
          {
             continue;
          }
-         if(comp->mTransformComponent == NULL)
-         {
-            bool success = GetEntityManager().GetComponent(id, comp->mTransformComponent, true);
-            if(!success)
-            {
-               LOG_ERROR("NetworSender Component expects a Transform Component!");
-               return;
-            }
-         }
 
-         if(comp->mDynamicsComponent == NULL)
-         {
-            bool success = GetEntityManager().GetComponent(id, comp->mDynamicsComponent, true);
-            if(!success)
-            {
-               LOG_ERROR("DeadReckoningReceiver Component expects a Dynamics Component!");
-               return;
-            }
-         }
+         DeadReckoningReceiverComponent* comp = mSlotOwners[i];
+         assert(comp->mTransformComponent != NULL);
 
-         comp->mDynamicsComponent->SetVelocity(comp->mVelocity);
-         comp->mDynamicsComponent->SetAngularVelocity(EulerToQuat(comp->mAngularVelocity));
+         osg::Vec3d newpos = mBatch.GetPosition(i);
+         osg::Quat newrot = mBatch.GetOrientation(i);
 
-         switch(comp->mDeadRecAlg)
+         if(comp->mIsBlending)
          {
-            case DeadReckoningAlgorithm::STATIC:
+            double t = simtime - comp->mTimeLastReceive;
+            if(t >= blendtime)
             {
-               comp->mTransformComponent->SetTranslation(comp->mPosition);
-               comp->mTransformComponent->SetRotation(EulerToQuat(comp->mOrientation));
-               break;
+               comp->mIsBlending = false;
             }
-            case DeadReckoningAlgorithm::FPW:
+            else
             {
-
-               osg::Vec3d newpos;
-               osg::Vec3 newori;
-               CalculateDRFPW(comp->mPosition,
-                           comp->mOrientation,
-                           comp->mVelocity,
-                           comp->mAngularVelocity,
-                           msg.GetSimulationTime() - comp->mTimeLastReceive,
-                           newpos,
-                           newori);
-
-               // apply smoothing
-               if(true)
+               switch(mConvergence)
                {
-                  newpos = (newpos + comp->mTransformComponent->GetTranslation()) * 0.5f;
+               case ConvergenceMethod::PVB:
+                  newpos = ProjectiveVelocityBlend(comp->mBlendStartPosition,
+                                                   comp->mBlendStartVelocity,
+                                                   mBatch.GetVelocity(i),
+                                                   mBatch.GetAcceleration(i),
+                                                   newpos, t, blendtime);
+                  break;
+               case ConvergenceMethod::BEZIER:
+                  newpos = BezierBlend(comp->mBlendStartPosition,
+                                       comp->mBlendStartVelocity,
+                                       comp->mBlendEndPosition,
+                                       comp->mBlendEndVelocity,
+                                       t, blendtime);
+                  break;
+               default: break;
                }
-               comp->mTransformComponent->SetTranslation(newpos);
-
-               osg::Quat smoothr;
-               smoothr.slerp(0.5, EulerToQuat(newori), comp->mTransformComponent->GetRotation());
-               comp->mTransformComponent->SetRotation(smoothr);
-               break;
+               newrot.slerp(t / blendtime, comp->mBlendStartOrientation, newrot);
             }
-            default: assert(false && "Unimplemented dead reckoning algorithm used");
          }
+
+         if(dt > 0)
+         {
+            comp->mDisplayedVelocity = (newpos - comp->mTransformComponent->GetTranslation()) / dt;
+         }
+         comp->mTransformComponent->SetTranslation(newpos);
+         comp->mTransformComponent->SetRotation(newrot);
       }
    }
 
@@ -242,6 +285,13 @@ namespace dtEntityNet
       assert(dynamic_cast<const UpdateTransformMessage*>(&m) != NULL);
       const UpdateTransformMessage& msg = static_cast<const UpdateTransformMessage&>(m);
 
+      if(msg.GetProtocolVersion() != UpdateTransformMessage::PROTOCOL_VERSION)
+      {
+         LOG_WARNING("Dropping transform update with protocol version "
+            << msg.GetProtocolVersion() << ", expected " << UpdateTransformMessage::PROTOCOL_VERSION);
+         return;
+      }
+
       assert(mMapSystem != NULL);
       dtEntity::EntityId id = mMapSystem->GetEntityIdByUniqueId(msg.GetUniqueId());
       if(id == 0)
@@ -256,31 +306,100 @@ namespace dtEntityNet
          return;
       }
 
-      // first time a transform was received, make visible!
-      if(comp->mTimeLastReceive == 0)
+      if(comp->mTransformComponent == NULL)
       {
-         if(comp->mTransformComponent == NULL)
+         bool success = GetEntityManager().GetComponent(id, comp->mTransformComponent, true);
+         if(!success)
          {
-            bool success = GetEntityManager().GetComponent(id, comp->mTransformComponent, true);
-            if(!success)
-            {
-               LOG_ERROR("NetworSender Component expects a Transform Component!");
-               return;
-            }
+            LOG_ERROR("DeadReckoningReceiver Component expects a Transform Component!");
+            return;
          }
+      }
+
+      if(comp->mDynamicsComponent == NULL)
+      {
+         bool success = GetEntityManager().GetComponent(id, comp->mDynamicsComponent, true);
+         if(!success)
+         {
+            LOG_ERROR("DeadReckoningReceiver Component expects a Dynamics Component!");
+            return;
+         }
+      }
+
+      // network systems deliver updates after this system's tick, so this is current
+      const double simtime = mSimulationTime;
+      const DeadReckoningAlgorithm::e alg = msg.GetDeadReckoning();
+      const float blendtime = GetConvergenceTime();
 
+      // converge from currently displayed state if entity is already visible
+      comp->mIsBlending = comp->mTimeLastReceive != 0 &&
+                          mConvergence != ConvergenceMethod::NONE &&
+                          blendtime > 0 &&
+                          alg != DeadReckoningAlgorithm::DISABLED &&
+                          alg != DeadReckoningAlgorithm::STATIC;
+
+      if(comp->mIsBlending)
+      {
+         comp->mBlendStartPosition = comp->mTransformComponent->GetTranslation();
+         comp->mBlendStartOrientation = comp->mTransformComponent->GetRotation();
+         comp->mBlendStartVelocity = comp->mDisplayedVelocity;
+
+         if(mConvergence == ConvergenceMethod::BEZIER)
+         {
+            // end point and end velocity of curve are dead reckoned state
+            // at end of convergence time
+            const float eps = blendtime * 0.01f;
+            osg::Vec3d endpos, beforeend;
+            osg::Quat endrot;
+            CalculateDeadReckoning(alg, msg.GetPosition(), msg.GetOrientation(), msg.GetVelocity(),
+                                   msg.GetAcceleration(), msg.GetAngularVelocity(), blendtime,
+                                   endpos, endrot);
+            CalculateDeadReckoning(alg, msg.GetPosition(), msg.GetOrientation(), msg.GetVelocity(),
+                                   msg.GetAcceleration(), msg.GetAngularVelocity(), blendtime - eps,
+                                   beforeend, endrot);
+            comp->mBlendEndPosition = endpos;
+            comp->mBlendEndVelocity = (endpos - beforeend) / eps;
+         }
+      }
+      else
+      {
+         comp->mDisplayedVelocity = osg::Vec3d();
+      }
+
+      // first time a transform was received, make visible!
+      if(comp->mTimeLastReceive == 0)
+      {
          comp->mTransformComponent->SetTranslation(msg.GetPosition());
-         comp->mTransformComponent->SetRotation(EulerToQuat(msg.GetOrientation()));
+         comp->mTransformComponent->SetRotation(msg.GetOrientation());
          mMapSystem->AddToScene(id);
       }
 
-
-      comp->mTimeLastReceive = dtEntity::GetSystemInterface()->GetSimulationTime();
+      comp->mTimeLastReceive = simtime;
       comp->mPosition = msg.GetPosition();
       comp->mOrientation = msg.GetOrientation();
       comp->mVelocity = msg.GetVelocity();
+      comp->mAcceleration = msg.GetAcceleration();
       comp->mAngularVelocity = msg.GetAngularVelocity();
-      comp->mDeadRecAlg = msg.GetDeadReckoning();
+      comp->mDeadRecAlg = alg;
+
+      comp->mDynamicsComponent->SetVelocity(comp->mVelocity);
+      comp->mDynamicsComponent->SetAngularVelocity(AngularVelocityToQuat(comp->mAngularVelocity));
+
+      if(comp->mDeadRecAlg == DeadReckoningAlgorithm::STATIC)
+      {
+         comp->mTransformComponent->SetTranslation(comp->mPosition);
+         comp->mTransformComponent->SetRotation(comp->mOrientation);
+      }
+
+      if(comp->mBatchIndex == NO_BATCH_SLOT)
+      {
+         comp->mBatchIndex = mBatch.Add();
+         mSlotOwners.push_back(comp);
+      }
+
+      mBatch.Set(comp->mBatchIndex, comp->mDeadRecAlg, comp->mTimeLastReceive,
+                 comp->mPosition, comp->mOrientation, comp->mVelocity,
+                 comp->mAcceleration, comp->mAngularVelocity);
    }
 
 }
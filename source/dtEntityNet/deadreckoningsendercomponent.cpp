@@ -29,6 +29,9 @@
 #include <dtEntity/systemmessages.h>
 #include <dtEntity/messagefactory.h>
 #include <dtEntity/protobufmapencoder.h>
+#include <algorithm>
+#include <float.h>
+#include <sstream>
 
 namespace dtEntityNet
 {
@@ -37,6 +40,7 @@ namespace dtEntityNet
    ////////////////////////////////////////////////////////////////////////////
    const dtEntity::StringId DeadReckoningSenderComponent::TYPE(dtEntity::SID("DeadReckoningSender"));
    const dtEntity::StringId DeadReckoningSenderComponent::DeadReckoningAlgorithmId(dtEntity::SID("DeadReckoningAlgorithm"));
+   const dtEntity::StringId DeadReckoningSenderComponent::PriorityId(dtEntity::SID("Priority"));
 
    DeadReckoningSenderComponent::DeadReckoningSenderComponent()
       : mDeadReckoningAlgorithm (
@@ -49,8 +53,11 @@ namespace dtEntityNet
       , mTimeLastSend(-1)
       , mUniqueId(dtEntity::CreateUniqueIdString())
       , mIsInScene(false)
+      , mAccumulatedPriority(0)
    {
       Register(DeadReckoningAlgorithmId, &mDeadReckoningAlgorithm);
+      Register(PriorityId, &mPriority);
+      mPriority.Set(1.0f);
    }
 
    ////////////////////////////////////////////////////////////////////////////
@@ -80,10 +87,12 @@ namespace dtEntityNet
    ////////////////////////////////////////////////////////////////////////////
    void DeadReckoningSenderComponent::FillMessage(UpdateTransformMessage& msg)
    {
+      msg.SetProtocolVersion(UpdateTransformMessage::PROTOCOL_VERSION);
       msg.SetUniqueId(mUniqueId);
       msg.SetPosition(mLastPosition);
       msg.SetOrientation(mLastOrientation);
       msg.SetVelocity(mLastVelocity);
+      msg.SetAcceleration(mLastAcceleration);
       msg.SetAngularVelocity(mLastAngularVelocity);
       msg.SetDeadReckoning(GetDeadReckoningAlgorithm());
       msg.SetSimTime(mTimeLastSend);
@@ -97,20 +106,31 @@ namespace dtEntityNet
    const dtEntity::StringId DeadReckoningSenderSystem::MinUpdateIntervalId(dtEntity::SID("MinUpdateInterval"));
    const dtEntity::StringId DeadReckoningSenderSystem::MaxPositionDeviationId(dtEntity::SID("MaxPositionDeviation"));
    const dtEntity::StringId DeadReckoningSenderSystem::MaxOrientationDeviationId(dtEntity::SID("MaxOrientationDeviation"));
+   const dtEntity::StringId DeadReckoningSenderSystem::BandwidthBudgetId(dtEntity::SID("BandwidthBudget"));
+   const dtEntity::StringId DeadReckoningSenderSystem::MaxUpdatesPerTickId(dtEntity::SID("MaxUpdatesPerTick"));
+   const dtEntity::StringId DeadReckoningSenderSystem::PriorityDistanceId(dtEntity::SID("PriorityDistance"));
 
    ////////////////////////////////////////////////////////////////////////////
    DeadReckoningSenderSystem::DeadReckoningSenderSystem(dtEntity::EntityManager& em)
       : BaseClass(em)
+      , mAvailableBytes(0)
+      , mUpdateMessageSize(0)
    {
       mMinUpdateInterval.Set(0.1f);
       mMaxUpdateInterval.Set(10.0f);
       mMaxPositionDeviation.Set(0.01f);
       mMaxOrientationDeviation.Set(0.01f);
+      mBandwidthBudget.Set(0);
+      mMaxUpdatesPerTick.Set(0);
+      mPriorityDistance.Set(100.0f);
 
       Register(MaxUpdateIntervalId, &mMaxUpdateInterval);
       Register(MinUpdateIntervalId, &mMinUpdateInterval);
       Register(MaxPositionDeviationId, &mMaxPositionDeviation);
       Register(MaxOrientationDeviationId, &mMaxOrientationDeviation);
+      Register(BandwidthBudgetId, &mBandwidthBudget);
+      Register(MaxUpdatesPerTickId, &mMaxUpdatesPerTick);
+      Register(PriorityDistanceId, &mPriorityDistance);
 
       mTickFunctor = dtEntity::MessageFunctor(this, &DeadReckoningSenderSystem::Tick);
       em.RegisterForMessages(dtEntity::TickMessage::TYPE,
@@ -135,17 +155,31 @@ namespace dtEntityNet
    ////////////////////////////////////////////////////////////////////////////
    void DeadReckoningSenderSystem::Tick(const dtEntity::Message& m)
    {
+      const dtEntity::TickMessage& msg = static_cast<const dtEntity::TickMessage&>(m);
+
+      double simtime = msg.GetSimulationTime();
+      float dt = msg.GetDeltaSimTime();
+
+      // refill byte budget, allow bursts of up to one second. Bucket holds at least
+      // one message so that a budget below the message size still lets updates through
+      float budget = GetBandwidthBudget();
+      unsigned int msgsize = 0;
+      if(budget > 0)
+      {
+         msgsize = GetUpdateMessageSize();
+         float capacity = osg::maximum(budget, static_cast<float>(msgsize));
+         mAvailableBytes = osg::minimum(mAvailableBytes + budget * dt, capacity);
+      }
+
       if(mComponents.empty())
       {
          return;
       }
 
-      const dtEntity::TickMessage& msg = static_cast<const dtEntity::TickMessage&>(m);
-
-      double simtime = msg.GetSimulationTime();
-
       osg::Vec3d newpos;
-      osg::Vec3 newori;
+      osg::Quat newori;
+
+      mUpdateCandidates.clear();
 
       for(ComponentStore::iterator i = mComponents.begin(); i != mComponents.end(); ++i)
       {
@@ -157,8 +191,15 @@ namespace dtEntityNet
             continue;
          }
 
-         if(comp->GetDeadReckoningAlgorithm() == DeadReckoningAlgorithm::DISABLED ||
-            comp->GetDeadReckoningAlgorithm() == DeadReckoningAlgorithm::STATIC)
+         DeadReckoningAlgorithm::e alg = comp->GetDeadReckoningAlgorithm();
+         if(alg == DeadReckoningAlgorithm::DISABLED ||
+            alg == DeadReckoningAlgorithm::STATIC)
+         {
+            continue;
+         }
+
+         // don't resend if not at least MinUpdateInterval seconds have passed since last send
+         if(simtime < comp->mTimeLastSend + GetMinUpdateInterval())
          {
             continue;
          }
@@ -174,75 +215,161 @@ namespace dtEntityNet
          }
 
          const osg::Vec3d currentTrans = comp->mTransformComponent->GetTranslation();
-         const osg::Vec3 currentAtt = QuatToEuler(comp->mTransformComponent->GetRotation());
+         const osg::Quat currentAtt = comp->mTransformComponent->GetRotation();
 
-         bool resend = false;
+         // always resend when no position was sent for MaxUpdateInterval seconds
+         bool expired = simtime > comp->mTimeLastSend + GetMaxUpdateInterval();
 
+         // deviation of dead reckoned state from actual state, relative to allowed deviation
+         float error = 0;
+         if(!expired)
+         {
+            CalculateDeadReckoning(alg,
+                                   comp->mLastPosition,
+                                   comp->mLastOrientation,
+                                   comp->mLastVelocity,
+                                   comp->mLastAcceleration,
+                                   comp->mLastAngularVelocity,
+                                   simtime - comp->mTimeLastSend,
+                                   newpos,
+                                   newori);
 
-         if(simtime < comp->mTimeLastSend + GetMinUpdateInterval())
+            float dist = (newpos - currentTrans).length();
+
+            // angle between dead reckoned and actual orientation
+            double cosHalfAngle = fabs(newori[0] * currentAtt[0] + newori[1] * currentAtt[1] +
+                                       newori[2] * currentAtt[2] + newori[3] * currentAtt[3]);
+            float angdiff = 2 * acos(osg::minimum(cosHalfAngle, 1.0));
+
+            float maxPosDev = GetMaxPositionDeviation();
+            float maxOriDev = GetMaxOrientationDeviation();
+            error = osg::maximum(maxPosDev > 0 ? dist / maxPosDev : FLT_MAX,
+                                 maxOriDev > 0 ? angdiff / maxOriDev : FLT_MAX);
+
+            if(error <= 1)
+            {
+               // dead reckoning is good enough, no update needed
+               comp->mAccumulatedPriority = 0;
+               continue;
+            }
+         }
+
+         // entities that are waiting for an update become more important each tick
+         float weight = comp->GetPriority() * GetDistanceFactor(currentTrans);
+         comp->mAccumulatedPriority += weight * osg::minimum(osg::maximum(error, 1.0f), 100.0f) * dt;
+
+         UpdateCandidate candidate;
+         candidate.mPriority = comp->mAccumulatedPriority;
+         candidate.mEntityId = id;
+         candidate.mComponent = comp;
+         mUpdateCandidates.push_back(candidate);
+      }
+
+      if(mUpdateCandidates.empty())
+      {
+         return;
+      }
+
+      unsigned int maxUpdates = GetMaxUpdatesPerTick();
+      if(budget > 0 || maxUpdates > 0)
+      {
+         std::sort(mUpdateCandidates.begin(), mUpdateCandidates.end(), &DeadReckoningSenderSystem::HigherPriority);
+      }
+
+      unsigned int numSent = 0;
+
+      for(UpdateCandidates::iterator i = mUpdateCandidates.begin(); i != mUpdateCandidates.end(); ++i)
+      {
+         if(maxUpdates > 0 && numSent >= maxUpdates)
          {
-            // don't resend if not at least MinUpdateInterval seconds have passed since last send
-            resend = false;
+            break;
          }
-         else if(simtime > comp->mTimeLastSend + GetMaxUpdateInterval())
+         if(budget > 0 && mAvailableBytes < msgsize)
          {
-            // always resend when no position was sent for MaxUpdateInterval seconds
-            resend = true;
+            break;
          }
-         else
+         if(SendUpdate(i->mEntityId, i->mComponent, simtime))
          {
-            // resend if dead reckoned position significantly deviates from actual position
+            mAvailableBytes -= msgsize;
+            ++numSent;
+         }
+      }
+   }
 
-            switch(comp->GetDeadReckoningAlgorithm())
-            {
-            case DeadReckoningAlgorithm::FPW:
-               CalculateDRFPW(comp->mLastPosition,
-                              comp->mLastOrientation,
-                              comp->mLastVelocity,
-                              comp->mLastAngularVelocity,
-                              simtime - comp->mTimeLastSend,
-                              newpos,
-                              newori);
-               break;
-            default: assert(false);
-            }
+   ////////////////////////////////////////////////////////////////////////////
+   bool DeadReckoningSenderSystem::SendUpdate(dtEntity::EntityId id, DeadReckoningSenderComponent* comp, double simtime)
+   {
+      if(comp->mDynamicsComponent == NULL)
+      {
+         bool success = GetEntityManager().GetComponent(id, comp->mDynamicsComponent, true);
+         if(!success)
+         {
+            LOG_ERROR("NetworSender Component expects a Dynamic Component!");
+            return false;
+         }
+      }
 
+      const osg::Quat currentAtt = comp->mTransformComponent->GetRotation();
 
-            float dist = (newpos - currentTrans).length();
-            osg::Vec3 angdiff = (newori - currentAtt);
-            if(dist > GetMaxPositionDeviation() ||
-                  fabs(angdiff[0]) > GetMaxOrientationDeviation() ||
-                  fabs(angdiff[1]) > GetMaxOrientationDeviation() ||
-                  fabs(angdiff[2]) > GetMaxOrientationDeviation()
-                  )
-            {
-               resend = true;
-            }
-         }
+      osg::Vec3 vel = comp->mDynamicsComponent->GetVelocity();
+      osg::Vec3 acc = comp->mDynamicsComponent->GetAcceleration();
+      if(DeadReckoningAlgorithm::IsBodyCoordinates(comp->GetDeadReckoningAlgorithm()))
+      {
+         osg::Quat toBody = currentAtt.inverse();
+         vel = toBody * vel;
+         acc = toBody * acc;
+      }
 
-         if(resend)
-         {
-            if(comp->mDynamicsComponent == NULL)
-            {
-               bool success = GetEntityManager().GetComponent(id, comp->mDynamicsComponent, true);
-               if(!success)
-               {
-                  LOG_ERROR("NetworSender Component expects a Dynamic Component!");
-                  continue;
-               }
-            }
+      comp->mLastPosition = comp->mTransformComponent->GetTranslation();
+      comp->mLastOrientation = currentAtt;
+      comp->mLastVelocity = vel;
+      comp->mLastAcceleration = acc;
+      comp->mLastAngularVelocity = AngularVelocityFromQuat(comp->mDynamicsComponent->GetAngularVelocity());
+      comp->mTimeLastSend = simtime;
+      comp->mAccumulatedPriority = 0;
+
+      UpdateTransformMessage msg;
+      comp->FillMessage(msg);
+      mOutgoing.EmitMessage(msg);
+      return true;
+   }
 
-            comp->mLastPosition = currentTrans;
-            comp->mLastOrientation = currentAtt;
-            comp->mLastVelocity = comp->mDynamicsComponent->GetVelocity();
-            comp->mLastAngularVelocity = QuatToEuler(comp->mDynamicsComponent->GetAngularVelocity());
-            comp->mTimeLastSend = simtime;
+   ////////////////////////////////////////////////////////////////////////////
+   float DeadReckoningSenderSystem::GetDistanceFactor(const osg::Vec3d& pos) const
+   {
+      float prioDist = GetPriorityDistance();
+      if(mObserverPositions.empty() || prioDist <= 0)
+      {
+         return 1;
+      }
 
-            UpdateTransformMessage msg;
-            comp->FillMessage(msg);
-            mOutgoing.EmitMessage(msg);
+      double mindist2 = DBL_MAX;
+      for(std::vector<osg::Vec3d>::const_iterator i = mObserverPositions.begin(); i != mObserverPositions.end(); ++i)
+      {
+         mindist2 = osg::minimum(mindist2, (*i - pos).length2());
+      }
+      return 1.0f / (1.0f + sqrt(mindist2) / prioDist);
+   }
+
+   ////////////////////////////////////////////////////////////////////////////
+   unsigned int DeadReckoningSenderSystem::GetUpdateMessageSize()
+   {
+      if(mUpdateMessageSize == 0)
+      {
+         UpdateTransformMessage msg;
+         msg.SetUniqueId(dtEntity::CreateUniqueIdString());
+         std::stringstream buf(std::ios::binary | std::ios::in | std::ios::out);
+         if(dtEntity::ProtoBufMapEncoder::EncodeMessage(msg, buf))
+         {
+            mUpdateMessageSize = buf.str().size();
+         }
+         else
+         {
+            LOG_ERROR("Could not encode update message to determine its size!");
+            mUpdateMessageSize = 1;
          }
       }
+      return mUpdateMessageSize;
    }
 
    ////////////////////////////////////////////////////////////////////////////
@@ -216,7 +216,7 @@ namespace dtEntityNet
          {
          case ENET_EVENT_TYPE_CONNECT:
          {
-            LOG_ALWAYS("A new client connected from " << event.peer->address.host << ":" << event.peer->address.port);
+            LOG_INFO("A new client connected from " << event.peer->address.host << ":" << event.peer->address.port);
 
             std::string uniqueId = dtEntity::CreateUniqueIdString();
             /* Store any relevant client information here. */
@@ -235,25 +235,19 @@ namespace dtEntityNet
          }
          case ENET_EVENT_TYPE_RECEIVE:
          {
-            LOG_ALWAYS("A packet of length " << event.packet->dataLength << " was received from " <<
-                    event.peer->data << " on channel " << (int)event.channelID << "\n");
+            LOG_DEBUG("A packet of length " << event.packet->dataLength << " was received from " <<
+                    event.peer->data << " on channel " << (int)event.channelID);
 
-            //std::istringstream is(reinterpret_cast<char*>(event.packet->data), std::ios_base::in | std::ios_base::binary);
-
-            std::stringstream ss;
-            ss.rdbuf()->sputn(reinterpret_cast<char*>(event.packet->data), event.packet->dataLength);
-
-            dtEntity::Message* msg = dtEntity::ProtoBufMapEncoder::DecodeMessage(ss);
+            // decode in place from packet buffer
+            dtEntity::Message* msg = mDecoder.Decode(event.packet->data, event.packet->dataLength);
             if(msg == NULL)
             {
                LOG_ERROR("Could not decode message!");
             }
             else
             {
-               LOG_ALWAYS("Received message of type " << dtEntity::GetStringFromSID(msg->GetType()));
                mIncoming.EmitMessage(*msg);
             }
-            delete msg;
 
             enet_packet_destroy(event.packet);
 
@@ -270,7 +264,7 @@ namespace dtEntityNet
                }
             }
 
-            LOG_ALWAYS ("" << event.peer->data << " disconected");
+            LOG_INFO("" << event.peer->data << " disconected");
 
             /* Reset the peer's client information. */
             event.peer -> data = NULL;
@@ -289,7 +283,7 @@ namespace dtEntityNet
       bool success = dtEntity::ProtoBufMapEncoder::EncodeMessage(msg, buf);
       if(success)
       {
-         LOG_ALWAYS("Sending to clients: " << dtEntity::GetStringFromSID(msg.GetType()));
+         LOG_DEBUG("Sending to clients: " << dtEntity::GetStringFromSID(msg.GetType()));
          const std::string byteArray = buf.str();
          ENetPacket* packet = enet_packet_create (byteArray.c_str(), byteArray.size(),
                                               ENET_PACKET_FLAG_RELIABLE);
@@ -324,7 +318,7 @@ namespace dtEntityNet
       bool success = dtEntity::ProtoBufMapEncoder::EncodeMessage(msg, buf);
       if(success)
       {
-         LOG_ALWAYS("Sending to peer: " << dtEntity::GetStringFromSID(msg.GetType()));
+         LOG_DEBUG("Sending to peer: " << dtEntity::GetStringFromSID(msg.GetType()));
          const std::string byteArray = buf.str();
          ENetPacket* packet = enet_packet_create (byteArray.c_str(), byteArray.size(),
                                               ENET_PACKET_FLAG_RELIABLE);
@@ -0,0 +1,483 @@
+/*
+* dtEntity Game and Simulation Engine
+*
+* This library is free software; you can redistribute it and/or modify it under
+* the terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; either version 2.1 of the License, or (at your option)
+* any later version.
+*
+* This library is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+* details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this library; if not, write to the Free Software Foundation, Inc.,
+* 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*
+* Martin Scheffler
+*/
+
+#include <dtEntityNet/loopbackcomponent.h>
+
+#include <dtEntityNet/messages.h>
+#include <dtEntityNet/deadreckoningreceivercomponent.h>
+#include <dtEntityNet/deadreckoningsendercomponent.h>
+#include <dtEntity/entitymanager.h>
+#include <dtEntity/log.h>
+#include <dtEntity/protobufmapencoder.h>
+#include <dtEntity/systemmessages.h>
+#include <algorithm>
+#include <sstream>
+
+namespace dtEntityNet
+{
+
+   // a lost reliable packet is resent at most this often before giving up
+   static const unsigned int MAX_RESENDS = 10;
+
+   ////////////////////////////////////////////////////////////////////////////
+   LoopbackNetwork::Statistics::Statistics()
+      : mPacketsSent(0)
+      , mPacketsDropped(0)
+      , mPacketsDelivered(0)
+      , mBytesSent(0)
+      , mBytesDelivered(0)
+   {
+   }
+
+   ////////////////////////////////////////////////////////////////////////////
+   ////////////////////////////////////////////////////////////////////////////
+   LoopbackNetwork::LoopbackNetwork(unsigned int seed)
+      : mLatency(0)
+      , mJitter(0)
+      , mPacketLoss(0)
+      , mBandwidth(0)
+      , mTime(0)
+      , mRandomState(seed)
+      , mSequence(0)
+      , mNextEndpoint(SERVER_ENDPOINT + 1)
+   {
+      mEndpoints.insert(SERVER_ENDPOINT);
+   }
+
+   ////////////////////////////////////////////////////////////////////////////
+   LoopbackNetwork::~LoopbackNetwork()
+   {
+      for(std::map<EndpointId, PacketQueue>::iterator i = mQueues.begin(); i != mQueues.end(); ++i)
+      {
+         for(PacketQueue::iterator j = i->second.begin(); j != i->second.end(); ++j)
+         {
+            delete *j;
+         }
+      }
+   }
+
+   ////////////////////////////////////////////////////////////////////////////
+   double LoopbackNetwork::Random()
+   {
+      // linear congruential generator, same sequence on all platforms
+      mRandomState = mRandomState * 1664525u + 1013904223u;
+      return (mRandomState >> 8) / 16777216.0;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////
+   LoopbackNetwork::EndpointId LoopbackNetwork::Connect()
+   {
+      EndpointId ep = mNextEndpoint++;
+      mEndpoints.insert(ep);
+      Enqueue(ep, SERVER_ENDPOINT, CONNECT, std::string(), true);
+      return ep;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////
+   void LoopbackNetwork::Disconnect(EndpointId ep)
+   {
+      if(!IsConnected(ep))
+      {
+         return;
+      }
+
+      // drop all packets still waiting for this endpoint
+      std::map<EndpointId, PacketQueue>::iterator q = mQueues.find(ep);
+      if(q != mQueues.end())
+      {
+         for(PacketQueue::iterator j = q->second.begin(); j != q->second.end(); ++j)
+         {
+            delete *j;
+         }
+         mQueues.erase(q);
+      }
+
+      if(ep == SERVER_ENDPOINT)
+      {
+         // server endpoint stays available, clients are notified
+         for(std::set<EndpointId>::iterator i = mEndpoints.begin(); i != mEndpoints.end(); ++i)
+         {
+            if(*i != SERVER_ENDPOINT)
+            {
+               Enqueue(SERVER_ENDPOINT, *i, DISCONNECT, std::string(), true);
+            }
+         }
+      }
+      else
+      {
+         mEndpoints.erase(ep);
+         Enqueue(ep, SERVER_ENDPOINT, DISCONNECT, std::string(), true);
+      }
+   }
+
+   ////////////////////////////////////////////////////////////////////////////
+   bool LoopbackNetwork::IsConnected(EndpointId ep) const
+   {
+      return mEndpoints.find(ep) != mEndpoints.end();
+   }
+
+   ////////////////////////////////////////////////////////////////////////////
+   void LoopbackNetwork::Send(EndpointId from, EndpointId to, const std::string& data, bool reliable)
+   {
+      if(!IsConnected(from) || !IsConnected(to))
+      {
+         LOG_WARNING("Cannot send packet, endpoint not connected");
+         return;
+      }
+      ++mStatistics.mPacketsSent;
+      mStatistics.mBytesSent += data.size();
+      Enqueue(from, to, DATA, data, reliable);
+   }
+
+   ////////////////////////////////////////////////////////////////////////////
+   void LoopbackNetwork::Enqueue(EndpointId from, EndpointId to, PacketType type, const std::string& data, bool reliable)
+   {
+      Link& link = mLinks[std::make_pair(from, to)];
+
+      // packets leave the sender one after another when bandwidth is limited
+      double departure = mTime;
+      if(mBandwidth > 0)
+      {
+         departure = std::max(mTime, link.mBusyUntil) + data.size() / mBandwidth;
+         link.mBusyUntil = departure;
+      }
+
+      double arrival = departure + mLatency + mJitter * Random();
+
+      if(mPacketLoss > 0)
+      {
+         unsigned int resends = 0;
+         while(Random() < mPacketLoss)
+         {
+            if(!reliable || resends == MAX_RESENDS)
+            {
+               if(type == DATA)
+               {
+                  ++mStatistics.mPacketsDropped;
+               }
+               return;
+            }
+            // resent after one round trip without acknowledgement
+            arrival += 2 * mLatency + mJitter * Random();
+            ++resends;
+         }
+      }
+
+      // packets of a link are delivered in the order they were sent
+      arrival = std::max(arrival, link.mLastArrival);
+      link.mLastArrival = arrival;
+
+      Packet* packet = new Packet();
+      packet->mArrivalTime = arrival;
+      packet->mSequence = mSequence++;
+      packet->mType = type;
+      packet->mFrom = from;
+      packet->mData = data;
+      mQueues[to].insert(packet);
+   }
+
+   ////////////////////////////////////////////////////////////////////////////
+   bool LoopbackNetwork::Receive(EndpointId ep, PacketType& type, EndpointId& from, std::string& data)
+   {
+      std::map<EndpointId, PacketQueue>::iterator q = mQueues.find(ep);
+      if(q == mQueues.end() || q->second.empty())
+      {
+         return false;
+      }
+
+      PacketQueue::iterator first = q->second.begin();
+      Packet* packet = *first;
+      if(packet->mArrivalTime > mTime)
+      {
+         return false;
+      }
+      q->second.erase(first);
+
+      type = packet->mType;
+      from = packet->mFrom;
+      data.swap(packet->mData);
+      delete packet;
+
+      if(type == DISCONNECT && ep != SERVER_ENDPOINT)
+      {
+         // server closed the connection, nothing more arrives at this client
+         for(PacketQueue::iterator j = q->second.begin(); j != q->second.end(); ++j)
+         {
+            delete *j;
+         }
+         mQueues.erase(q);
+         mEndpoints.erase(ep);
+      }
+
+      if(type == DATA)
+      {
+         ++mStatistics.mPacketsDelivered;
+         mStatistics.mBytesDelivered += data.size();
+      }
+      return true;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////
+   class LoopbackPeerReceiver : public dtEntity::MessageReceiver
+   {
+      LoopbackSystem* mLoopbackSystem;
+      LoopbackNetwork::EndpointId mPeer;
+
+   public:
+
+      LoopbackPeerReceiver(LoopbackSystem* sys, LoopbackNetwork::EndpointId peer)
+         : mLoopbackSystem(sys)
+         , mPeer(peer)
+      {
+      }
+
+      void Receive(const dtEntity::Message &msg)
+      {
+         mLoopbackSystem->SendToPeer(msg, mPeer);
+      }
+
+   };
+
+   ////////////////////////////////////////////////////////////////////////////
+   const dtEntity::StringId LoopbackSystem::TYPE(dtEntity::SID("Loopback"));
+
+   ////////////////////////////////////////////////////////////////////////////
+   ////////////////////////////////////////////////////////////////////////////
+   LoopbackSystem::LoopbackSystem(dtEntity::EntityManager& em)
+      : BaseClass(em)
+      , mActive(false)
+      , mIsServer(false)
+      , mEndpoint(LoopbackNetwork::SERVER_ENDPOINT)
+   {
+      mTickFunctor = dtEntity::MessageFunctor(this, &LoopbackSystem::Tick);
+   }
+
+   ////////////////////////////////////////////////////////////////////////////
+   LoopbackSystem::~LoopbackSystem()
+   {
+      Disconnect();
+   }
+
+   ////////////////////////////////////////////////////////////////////////////
+   void LoopbackSystem::OnAddedToEntityManager(dtEntity::EntityManager &em)
+   {
+      DeadReckoningReceiverSystem* receiversys;
+      bool deadRecReceiverSystemInEntityManager = em.GetES(receiversys);
+      assert(deadRecReceiverSystemInEntityManager);
+
+      GetIncomingMessagePump().RegisterForMessages(UpdateTransformMessage::TYPE,
+         dtEntity::MessageFunctor(receiversys, &DeadReckoningReceiverSystem::OnUpdateTransform),
+                                   dtEntity::FilterOptions::ORDER_LATE, "DeadReckoningReceiverSystem::OnUpdateTransform");
+
+      GetIncomingMessagePump().RegisterForMessages(JoinMessage::TYPE,
+         dtEntity::MessageFunctor(receiversys, &DeadReckoningReceiverSystem::OnJoin),
+                                   dtEntity::FilterOptions::ORDER_DEFAULT, "DeadReckoningReceiverSystem::OnJoin");
+
+      GetIncomingMessagePump().RegisterForMessages(ResignMessage::TYPE,
+         dtEntity::MessageFunctor(receiversys, &DeadReckoningReceiverSystem::OnResign),
+                                   dtEntity::FilterOptions::ORDER_DEFAULT, "DeadReckoningReceiverSystem::OnResign");
+
+      DeadReckoningSenderSystem* sendersys;
+      bool deadRecSenderSystemInEntityManager = em.GetES(sendersys);
+      assert(deadRecSenderSystemInEntityManager);
+
+      dtEntity::MessagePump& mp = sendersys->GetOutgoingMessagePump();
+      mp.RegisterForMessages(UpdateTransformMessage::TYPE,
+                                   dtEntity::MessageFunctor(this, &LoopbackSystem::SendToClients));
+      mp.RegisterForMessages(JoinMessage::TYPE,
+                                   dtEntity::MessageFunctor(this, &LoopbackSystem::SendToClients));
+      mp.RegisterForMessages(ResignMessage::TYPE,
+                                   dtEntity::MessageFunctor(this, &LoopbackSystem::SendToClients));
+   }
+
+   ////////////////////////////////////////////////////////////////////////////
+   void LoopbackSystem::SetNetwork(LoopbackNetwork* n)
+   {
+      Disconnect();
+      mNetwork = n;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////
+   bool LoopbackSystem::InitializeServer()
+   {
+      if(!mNetwork.valid())
+      {
+         LOG_ERROR("Cannot initialize loopback server, no network set!");
+         return false;
+      }
+      Disconnect();
+
+      mIsServer = true;
+      mEndpoint = LoopbackNetwork::SERVER_ENDPOINT;
+      mActive = true;
+
+      GetEntityManager().RegisterForMessages(dtEntity::TickMessage::TYPE,
+         mTickFunctor, dtEntity::FilterOptions::ORDER_LATE, "LoopbackSystem::Tick");
+      return true;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////
+   bool LoopbackSystem::Connect()
+   {
+      if(!mNetwork.valid())
+      {
+         LOG_ERROR("Cannot connect to loopback server, no network set!");
+         return false;
+      }
+      Disconnect();
+
+      mIsServer = false;
+      mEndpoint = mNetwork->Connect();
+      mActive = true;
+
+      GetEntityManager().RegisterForMessages(dtEntity::TickMessage::TYPE,
+         mTickFunctor, dtEntity::FilterOptions::ORDER_LATE, "LoopbackSystem::Tick");
+      return true;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////
+   bool LoopbackSystem::IsConnected() const
+   {
+      if(!mActive)
+      {
+         return false;
+      }
+      return mIsServer ? !mConnectedClients.empty() : mNetwork->IsConnected(mEndpoint);
+   }
+
+   ////////////////////////////////////////////////////////////////////////////
+   void LoopbackSystem::Disconnect()
+   {
+      if(mActive)
+      {
+         GetEntityManager().UnregisterForMessages(dtEntity::TickMessage::TYPE, mTickFunctor);
+         mNetwork->Disconnect(mEndpoint);
+         mConnectedClients.clear();
+         mActive = false;
+      }
+   }
+
+   ////////////////////////////////////////////////////////////////////////////
+   void LoopbackSystem::Tick(const dtEntity::Message& m)
+   {
+      LoopbackNetwork::PacketType type;
+      LoopbackNetwork::EndpointId from;
+
+      while(mActive && mNetwork->Receive(mEndpoint, type, from, mReceiveBuffer))
+      {
+         switch(type)
+         {
+         case LoopbackNetwork::CONNECT:
+         {
+            mConnectedClients.push_back(from);
+
+            DeadReckoningSenderSystem* sender;
+            if(GetEntityManager().GetES(sender))
+            {
+               LoopbackPeerReceiver peerrcvr(this, from);
+               sender->ResendJoinMessages(peerrcvr);
+            }
+            break;
+         }
+         case LoopbackNetwork::DISCONNECT:
+         {
+            if(!mIsServer)
+            {
+               LOG_INFO("Loopback server closed the connection");
+               GetEntityManager().UnregisterForMessages(dtEntity::TickMessage::TYPE, mTickFunctor);
+               mActive = false;
+               break;
+            }
+            Clients::iterator i = std::find(mConnectedClients.begin(), mConnectedClients.end(), from);
+            if(i != mConnectedClients.end())
+            {
+               mConnectedClients.erase(i);
+            }
+            break;
+         }
+         case LoopbackNetwork::DATA:
+         {
+            dtEntity::Message* msg = mDecoder.Decode(mReceiveBuffer.data(), mReceiveBuffer.size());
+            if(msg == NULL)
+            {
+               LOG_ERROR("Could not decode message!");
+            }
+            else
+            {
+               mIncoming.EmitMessage(*msg);
+            }
+            break;
+         }
+         }
+      }
+   }
+
+   ////////////////////////////////////////////////////////////////////////////
+   bool LoopbackSystem::Encode(const dtEntity::Message& msg)
+   {
+      std::stringstream buf(std::ios::binary | std::ios::out);
+      bool success = dtEntity::ProtoBufMapEncoder::EncodeMessage(msg, buf);
+      if(!success)
+      {
+         LOG_ERROR("Could not encode message!");
+         return false;
+      }
+      mSendBuffer = buf.str();
+      return true;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////
+   void LoopbackSystem::SendToClients(const dtEntity::Message& msg)
+   {
+      if(!mActive || mConnectedClients.empty() || !Encode(msg))
+      {
+         return;
+      }
+
+      // later transform updates supersede lost ones, no need to resend
+      bool reliable = (msg.GetType() != UpdateTransformMessage::TYPE);
+      for(Clients::iterator i = mConnectedClients.begin(); i != mConnectedClients.end(); ++i)
+      {
+         mNetwork->Send(mEndpoint, *i, mSendBuffer, reliable);
+      }
+   }
+
+   ////////////////////////////////////////////////////////////////////////////
+   void LoopbackSystem::SendToServer(const dtEntity::Message& msg)
+   {
+      if(!mActive || mIsServer)
+      {
+         LOG_ERROR("Cannot send to server, no connection!");
+         return;
+      }
+      SendToPeer(msg, LoopbackNetwork::SERVER_ENDPOINT);
+   }
+
+   ////////////////////////////////////////////////////////////////////////////
+   void LoopbackSystem::SendToPeer(const dtEntity::Message& msg, LoopbackNetwork::EndpointId peer)
+   {
+      if(!mActive || !Encode(msg))
+      {
+         return;
+      }
+      bool reliable = (msg.GetType() != UpdateTransformMessage::TYPE);
+      mNetwork->Send(mEndpoint, peer, mSendBuffer, reliable);
+   }
+}
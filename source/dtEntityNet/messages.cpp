@@ -77,9 +77,11 @@ namespace dtEntityNet
 
    ///////////////////////////////////////////////////////////////////////////////////////////////////////
    const dtEntity::MessageType UpdateTransformMessage::TYPE(dtEntity::SID("UpdateTransformMessage"));
+   const dtEntity::StringId UpdateTransformMessage::ProtocolVersionId(dtEntity::SID("ProtocolVersion"));
    const dtEntity::StringId UpdateTransformMessage::DeadReckoningAlgorithmId(dtEntity::SID("DeadReckoningAlgorithm"));
    const dtEntity::StringId UpdateTransformMessage::PositionId(dtEntity::SID("Position"));
    const dtEntity::StringId UpdateTransformMessage::VelocityId(dtEntity::SID("Velocity"));
+   const dtEntity::StringId UpdateTransformMessage::AccelerationId(dtEntity::SID("Acceleration"));
    const dtEntity::StringId UpdateTransformMessage::OrientationId(dtEntity::SID("Orientation"));
    const dtEntity::StringId UpdateTransformMessage::AngularVelocityId(dtEntity::SID("AngularVelocity"));
    const dtEntity::StringId UpdateTransformMessage::SimTimeId(dtEntity::SID("SimTime"));
@@ -88,9 +90,13 @@ namespace dtEntityNet
    UpdateTransformMessage::UpdateTransformMessage()
       : dtEntity::Message(TYPE)
    {
+      // stays 0 when decoding updates of senders that predate versioning
+      mProtocolVersion.Set(0);
+      Register(ProtocolVersionId, &mProtocolVersion);
       Register(DeadReckoningAlgorithmId, &mDeadReckoningAlgorithm);
       Register(PositionId, &mPosition);
       Register(VelocityId, &mVelocity);
+      Register(AccelerationId, &mAcceleration);
       Register(OrientationId, &mOrientation);
       Register(AngularVelocityId, &mAngularVelocity);
       Register(SimTimeId, &mSimTime);
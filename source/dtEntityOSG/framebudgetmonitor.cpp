@@ -0,0 +1,286 @@
+/* -*-c++-*-
+ * dtEntity Game and Simulation Engine
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation; either version 2.1 of the License, or (at your option)
+ * any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * Martin Scheffler
+ */
+
+#include <dtEntityOSG/framebudgetmonitor.h>
+
+#include <dtEntity/log.h>
+#include <dtEntity/messagepump.h>
+#include <dtEntity/systemmessages.h>
+#include <osg/Timer>
+#include <algorithm>
+#include <sstream>
+
+namespace dtEntityOSG
+{
+   namespace
+   {
+      const unsigned int NUM_BUCKETS = 100;
+      const double BUCKET_WIDTH = 0.001;
+
+      const char* s_stageNames[FrameStage::NUM_STAGES] = {
+         "post frame", "tick", "queued messages", "end of frame", "render"
+      };
+
+      typedef std::pair<double, dtEntity::StringId> SubscriberTime;
+
+      bool SlowerThan(const SubscriberTime& a, const SubscriberTime& b)
+      {
+         return a.first > b.first;
+      }
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   FrameBudgetMonitor::FrameBudgetMonitor(dtEntity::MessagePump& mp)
+      : mMessagePump(&mp)
+      , mEnabled(false)
+      , mFrameStarted(false)
+      , mNumReportedSubscribers(5)
+      , mNumHitches(0)
+      , mFrameStart(0)
+      , mLastFrameTime(0)
+      , mHistoryIndex(0)
+      , mHistoryCount(0)
+      , mBucketWidth(BUCKET_WIDTH)
+      , mHistogram(NUM_BUCKETS, 0)
+   {
+      for(unsigned int i = 0; i < FrameStage::NUM_STAGES; ++i)
+      {
+         mStageStart[i] = 0;
+         mStageTimes[i] = 0;
+         mLastStageTimes[i] = 0;
+         mStageSums[i] = 0;
+      }
+      SetHistorySize(600);
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   FrameBudgetMonitor::~FrameBudgetMonitor()
+   {
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void FrameBudgetMonitor::SetEnabled(bool v)
+   {
+      if(v == mEnabled)
+      {
+         return;
+      }
+      mEnabled = v;
+      mMessagePump->SetSubscriberTimingEnabled(v);
+      mMessagePump->ResetSubscriberTimings();
+      mFrameStarted = false;
+      if(v)
+      {
+         Reset();
+      }
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void FrameBudgetMonitor::SetHistorySize(unsigned int v)
+   {
+      if(v == 0)
+      {
+         v = 1;
+      }
+      mFrameTimes.assign(v, 0);
+      for(unsigned int i = 0; i < FrameStage::NUM_STAGES; ++i)
+      {
+         mStageHistory[i].assign(v, 0);
+      }
+      Reset();
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void FrameBudgetMonitor::Reset()
+   {
+      std::fill(mHistogram.begin(), mHistogram.end(), 0);
+      std::fill(mFrameTimes.begin(), mFrameTimes.end(), 0);
+      for(unsigned int i = 0; i < FrameStage::NUM_STAGES; ++i)
+      {
+         std::fill(mStageHistory[i].begin(), mStageHistory[i].end(), 0);
+         mStageSums[i] = 0;
+         mLastStageTimes[i] = 0;
+      }
+      mHistoryIndex = 0;
+      mHistoryCount = 0;
+      mLastFrameTime = 0;
+      mNumHitches = 0;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void FrameBudgetMonitor::BeginFrame(double budget)
+   {
+      if(!mEnabled)
+      {
+         return;
+      }
+
+      dtEntity::Timer_t now = osg::Timer::instance()->tick();
+      if(mFrameStarted)
+      {
+         // render stage lasts until next frame begins
+         mStageTimes[FrameStage::RENDER] += osg::Timer::instance()->delta_s(mStageStart[FrameStage::RENDER], now);
+         mLastFrameTime = osg::Timer::instance()->delta_s(mFrameStart, now);
+         EndFrame(budget);
+      }
+
+      for(unsigned int i = 0; i < FrameStage::NUM_STAGES; ++i)
+      {
+         mStageTimes[i] = 0;
+         mStageStart[i] = now;
+      }
+      mFrameStart = now;
+      mFrameStarted = true;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void FrameBudgetMonitor::BeginStage(FrameStage::e stage)
+   {
+      if(mEnabled)
+      {
+         mStageStart[stage] = osg::Timer::instance()->tick();
+      }
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void FrameBudgetMonitor::EndStage(FrameStage::e stage)
+   {
+      if(mEnabled)
+      {
+         mStageTimes[stage] += osg::Timer::instance()->delta_s(mStageStart[stage], osg::Timer::instance()->tick());
+      }
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   double FrameBudgetMonitor::GetAverageStageTime(FrameStage::e stage) const
+   {
+      if(mHistoryCount == 0)
+      {
+         return 0;
+      }
+      return mStageSums[stage] / mHistoryCount;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   unsigned int FrameBudgetMonitor::GetBucket(double frametime) const
+   {
+      unsigned int bucket = static_cast<unsigned int>(frametime / mBucketWidth);
+      return std::min(bucket, static_cast<unsigned int>(mHistogram.size()) - 1);
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void FrameBudgetMonitor::EndFrame(double budget)
+   {
+      unsigned int historySize = static_cast<unsigned int>(mFrameTimes.size());
+
+      // remove oldest frame from histogram when history is full
+      if(mHistoryCount == historySize)
+      {
+         --mHistogram[GetBucket(mFrameTimes[mHistoryIndex])];
+         for(unsigned int i = 0; i < FrameStage::NUM_STAGES; ++i)
+         {
+            mStageSums[i] -= mStageHistory[i][mHistoryIndex];
+         }
+      }
+      else
+      {
+         ++mHistoryCount;
+      }
+
+      mFrameTimes[mHistoryIndex] = mLastFrameTime;
+      ++mHistogram[GetBucket(mLastFrameTime)];
+      for(unsigned int i = 0; i < FrameStage::NUM_STAGES; ++i)
+      {
+         mStageHistory[i][mHistoryIndex] = mStageTimes[i];
+         mStageSums[i] += mStageTimes[i];
+         mLastStageTimes[i] = mStageTimes[i];
+      }
+      mHistoryIndex = (mHistoryIndex + 1) % historySize;
+
+      if(budget > 0 && mLastFrameTime > budget)
+      {
+         ReportHitch(mLastFrameTime, budget);
+      }
+      mMessagePump->ResetSubscriberTimings();
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void FrameBudgetMonitor::ReportHitch(double frametime, double budget)
+   {
+      ++mNumHitches;
+
+      const dtEntity::MessagePump::SubscriberTimingMap& timings = mMessagePump->GetSubscriberTimings();
+      std::vector<SubscriberTime> slowest;
+      slowest.reserve(timings.size());
+      dtEntity::MessagePump::SubscriberTimingMap::const_iterator i;
+      for(i = timings.begin(); i != timings.end(); ++i)
+      {
+         if(i->second.mNumCalls != 0)
+         {
+            slowest.push_back(std::make_pair(i->second.mTime, i->first));
+         }
+      }
+      unsigned int numReported = std::min(mNumReportedSubscribers, static_cast<unsigned int>(slowest.size()));
+      std::partial_sort(slowest.begin(), slowest.begin() + numReported, slowest.end(), SlowerThan);
+
+      std::ostringstream os;
+      os << "Frame hitch: " << frametime * 1000 << " ms, budget " << budget * 1000 << " ms (";
+      for(unsigned int j = 0; j < FrameStage::NUM_STAGES; ++j)
+      {
+         os << (j == 0 ? "" : ", ") << s_stageNames[j] << " " << mStageTimes[j] * 1000 << " ms";
+      }
+      os << ")";
+      if(numReported != 0)
+      {
+         os << ". Slowest subscribers:";
+         for(unsigned int j = 0; j < numReported; ++j)
+         {
+            os << " " << dtEntity::GetStringFromSID(slowest[j].second) << " " << slowest[j].first * 1000 << " ms";
+         }
+      }
+      LOG_WARNING(os.str());
+
+      dtEntity::PropertyArray subscribers;
+      for(unsigned int j = 0; j < numReported; ++j)
+      {
+         dtEntity::GroupProperty* grp = new dtEntity::GroupProperty();
+         grp->Add(dtEntity::FrameHitchMessage::NameId, new dtEntity::StringProperty(dtEntity::GetStringFromSID(slowest[j].second)));
+         grp->Add(dtEntity::FrameHitchMessage::TimeId, new dtEntity::DoubleProperty(slowest[j].first));
+         subscribers.push_back(grp);
+      }
+
+      dtEntity::FrameHitchMessage msg;
+      msg.SetFrameTime(frametime);
+      msg.SetFrameBudget(budget);
+      msg.SetPostFrameTime(mStageTimes[FrameStage::POST_FRAME]);
+      msg.SetTickTime(mStageTimes[FrameStage::TICK]);
+      msg.SetQueuedMessagesTime(mStageTimes[FrameStage::QUEUED_MESSAGES]);
+      msg.SetEndOfFrameTime(mStageTimes[FrameStage::END_OF_FRAME]);
+      msg.SetRenderTime(mStageTimes[FrameStage::RENDER]);
+      msg.SetSlowestSubscribers(subscribers);
+
+      for(dtEntity::PropertyArray::iterator j = subscribers.begin(); j != subscribers.end(); ++j)
+      {
+         delete *j;
+      }
+
+      mMessagePump->EmitMessage(msg);
+   }
+}
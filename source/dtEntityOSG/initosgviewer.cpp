@@ -33,6 +33,7 @@
 #include <dtEntityOSG/osgwindowinterface.h>
 #include <dtEntityOSG/layercomponent.h>
 #include <dtEntityOSG/componentfactories.h>
+#include <dtEntity/dtentity_config.h>
 #include <dtEntity/systemmessages.h>
 
 #include <osgGA/GUIEventAdapter>
@@ -40,6 +41,10 @@
 #include <osgViewer/View>
 #include <osgViewer/ViewerEventHandlers>
 
+#if DTENTITY_PROFILING_ENABLED
+#include <dtEntity/profile.h>
+#endif
+
 namespace dtEntityOSG
 {
 
@@ -80,6 +85,26 @@ namespace dtEntityOSG
       // give application system access to viewer
       OSGSystemInterface* iface = static_cast<OSGSystemInterface*>(dtEntity::GetSystemInterface());
       iface->SetViewer(&viewer);
+
+      for(int curArg = 1; curArg < argc - 1; ++curArg)
+      {
+         if(std::string(argv[curArg]) == "--frameMonitor")
+         {
+            double budget = 0;
+            std::istringstream iss(argv[curArg + 1]);
+            iss >> budget;
+            if(budget > 0)
+            {
+               iface->SetFrameBudget(budget / 1000.0);
+            }
+            iface->GetFrameBudgetMonitor().SetEnabled(true);
+         }
+      }
+
+#if DTENTITY_PROFILING_ENABLED
+      CProfileManager::Setup_From_Command_Line(argc, argv);
+#endif
+
       bool success = DoScreenSetup(argc, argv, viewer, em);
       if(!success)
       {
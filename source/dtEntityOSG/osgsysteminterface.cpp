@@ -32,6 +32,7 @@
 #include <osgViewer/GraphicsWindow>
 #include <osgViewer/Viewer>
 #include <osgViewer/CompositeViewer>
+#include <algorithm>
 #include <assert.h>
 
 namespace dtEntityOSG
@@ -99,18 +100,21 @@ namespace dtEntityOSG
    class OSGSystemInterface::Impl
    {
    public:
-	   Impl() 
+	   Impl(dtEntity::MessagePump& mp) 
 		   : mUpdateCallback(new DtEntityUpdateCallback())
+		   , mFrameBudgetMonitor(mp)
 	   {
 	   }
 		
 	   osg::ref_ptr<DtEntityUpdateCallback> mUpdateCallback;
+	   FrameBudgetMonitor mFrameBudgetMonitor;
    };
 
    ////////////////////////////////////////////////////////////////////////////////
    OSGSystemInterface::OSGSystemInterface(dtEntity::MessagePump& mp)
       : mMessagePump(&mp)
-      , mImpl(new Impl())
+      , mFrameBudget(1.0 / 60.0)
+      , mImpl(new Impl(mp))
    {
    }
 
@@ -135,36 +139,49 @@ namespace dtEntityOSG
       float simtimescale = GetTimeScale();
       double simulationtime = GetSimulationTime();
 
+      FrameBudgetMonitor& monitor = mImpl->mFrameBudgetMonitor;
+      monitor.BeginFrame(mFrameBudget);
 
       {
+         monitor.BeginStage(FrameStage::POST_FRAME);
          dtEntity::PostFrameMessage msg;
          msg.SetDeltaSimTime(deltasimtime);
          msg.SetDeltaRealTime(deltarealtime);
          msg.SetSimTimeScale(simtimescale);
          msg.SetSimulationTime(simulationtime);
          mMessagePump->EmitMessage(msg);
+         monitor.EndStage(FrameStage::POST_FRAME);
       }
 
       {
+         monitor.BeginStage(FrameStage::TICK);
          dtEntity::TickMessage msg;
          msg.SetDeltaSimTime(deltasimtime);
          msg.SetDeltaRealTime(deltarealtime);
          msg.SetSimTimeScale(simtimescale);
          msg.SetSimulationTime(simulationtime);
          mMessagePump->EmitMessage(msg);
+         monitor.EndStage(FrameStage::TICK);
       }
 
+      monitor.BeginStage(FrameStage::QUEUED_MESSAGES);
       mMessagePump->EmitQueuedMessages(simulationtime);
+      monitor.EndStage(FrameStage::QUEUED_MESSAGES);
 
       {
+         monitor.BeginStage(FrameStage::END_OF_FRAME);
          dtEntity::EndOfFrameMessage msg;
          msg.SetDeltaSimTime(deltasimtime);
          msg.SetDeltaRealTime(deltarealtime);
          msg.SetSimTimeScale(simtimescale);
          msg.SetSimulationTime(simulationtime);
          mMessagePump->EmitMessage(msg);
+         monitor.EndStage(FrameStage::END_OF_FRAME);
       }
 
+      // ended by next call to BeginFrame
+      monitor.BeginStage(FrameStage::RENDER);
+
    }
 
    //////////////////////////////////////////////////////////////////////////////
@@ -283,6 +300,20 @@ namespace dtEntityOSG
       return osg::Timer::instance()->tick();
    }
 
+   ////////////////////////////////////////////////////////////////////////////////
+   FrameBudgetMonitor& OSGSystemInterface::GetFrameBudgetMonitor()
+   {
+      return mImpl->mFrameBudgetMonitor;
+   }
+
+   //////////////////////////////////////////////////////////////////////////////
+   double OSGSystemInterface::GetFrameTimeLeft() const
+   {
+      osg::Timer* timer = osg::Timer::instance();
+      double elapsed = timer->delta_s(mImpl->mUpdateCallback->mStartOfFrameTick, timer->tick());
+      return std::max(0.0, mFrameBudget - elapsed);
+   }
+
    ////////////////////////////////////////////////////////////////////////////////
    bool OSGSystemInterface::GetIntersections(const dtEntity::Vec3d& start, const dtEntity::Vec3d& end, 
          std::vector<dtEntity::SystemInterface::Intersection>& isects, unsigned int nodemask) const
@@ -22,6 +22,7 @@
 * Martin Scheffler
 */
 
+#include <dtEntity/applicationcomponent.h>
 #include <dtEntity/core.h>
 #include <dtEntity/dtentity_config.h>
 #include <dtEntity/entity.h>
@@ -48,6 +49,7 @@ int main(int argc, char** argv)
 {
     std::string script = "Scripts/autostart.js";
     bool profiling_enabled = false;
+    bool memory_report = false;
     int curArg = 1;
 
     while (curArg < argc)
@@ -67,6 +69,10 @@ int main(int argc, char** argv)
           {
              profiling_enabled = true;
           }
+          else if (curArgv == "--memory-report")
+          {
+             memory_report = true;
+          }
         }
        ++curArg;
     }
@@ -120,14 +126,24 @@ int main(int argc, char** argv)
 #if DTENTITY_PROFILING_ENABLED
    if(profiling_enabled)
    {
-      static dtEntity::StringId frameId = dtEntity::SID("Frame");
-      static dtEntity::StringId frameAdvanceId = dtEntity::SID("Frame_Advance");
-      static dtEntity::StringId frameEvTrId = dtEntity::SID("Frame_EventTraversal");
-      static dtEntity::StringId frameUpTrId = dtEntity::SID("Frame_UpdateTraversal");
-      static dtEntity::StringId frameRenderTrId = dtEntity::SID("Frame_RenderingTraversals");
-
-      unsigned int framecount = 0;
-      while (!viewer.done()) 
+      CProfileManager::Set_Enabled_Categories(ProfileCategory::ALL);
+   }
+
+   static dtEntity::StringId frameId = dtEntity::SID("Frame");
+   static dtEntity::StringId frameAdvanceId = dtEntity::SID("Frame_Advance");
+   static dtEntity::StringId frameEvTrId = dtEntity::SID("Frame_EventTraversal");
+   static dtEntity::StringId frameUpTrId = dtEntity::SID("Frame_UpdateTraversal");
+   static dtEntity::StringId frameRenderTrId = dtEntity::SID("Frame_RenderingTraversals");
+
+   CProfileManager::Set_Thread_Name("Main");
+   unsigned int framecount = 0;
+#endif
+
+   while (!viewer.done())
+   {
+#if DTENTITY_PROFILING_ENABLED
+      // categories can be switched on and off while running
+      if(CProfileManager::Get_Enabled_Categories() != ProfileCategory::NONE)
       {
          CProfileManager::Increment_Frame_Counter();
 			CProfileManager::Start_Profile(frameId);
@@ -157,18 +173,22 @@ int main(int argc, char** argv)
             framecount = 0;
             CProfileManager::Reset();
          }
+         continue;
       }
-   }
-   else
 #endif
+      viewer.advance(DBL_MAX);
+      viewer.eventTraversal();
+      iface->EmitTickMessagesAndQueuedMessages();
+      viewer.updateTraversal();
+      viewer.renderingTraversals();
+   }
+
+   if(memory_report)
    {
-      while (!viewer.done())
+      dtEntity::ApplicationSystem* appsys;
+      if(entityManager.GetES(appsys))
       {
-         viewer.advance(DBL_MAX);
-         viewer.eventTraversal();
-         iface->EmitTickMessagesAndQueuedMessages();
-         viewer.updateTraversal();
-         viewer.renderingTraversals();
+         std::cout << appsys->GetMemoryReport();
       }
    }
 
@@ -21,8 +21,13 @@
 #include <dtEntity/entitymanager.h>
 #include <dtEntity/entity.h>
 #include <dtEntity/entitysystem.h>
+#include <dtEntity/headlesssysteminterface.h>
+#include <dtEntityOSG/framebudgetmonitor.h>
 #include <dtEntityOSG/layercomponent.h>
 #include <dtEntity/mapcomponent.h>
+#include <dtEntity/profile.h>
+#include <dtEntity/systemmessages.h>
+#include <OpenThreads/Thread>
 #include <UnitTest++.h>
 
 using namespace UnitTest;
@@ -147,4 +152,268 @@ namespace EMTest
       delete em;
    }
 
+   //------------------------------------------------------------------
+   struct TickCounter
+   {
+      TickCounter() : mCount(0) {}
+      void OnTick(const Message&) { ++mCount; }
+      unsigned int mCount;
+   };
+
+   //------------------------------------------------------------------
+   TEST(MessageStatistics)
+   {
+      EntityManager* em = new EntityManager();
+      TickCounter counter;
+      MessageFunctor functor(&counter, &TickCounter::OnTick);
+      em->RegisterForMessages(TickMessage::TYPE, functor);
+
+      MessageTypeStatistics stats;
+      TickMessage msg;
+      em->EmitMessage(msg);
+      CHECK(!em->GetMessagePump().GetStatistics(TickMessage::TYPE, stats));
+
+      em->GetMessagePump().SetStatisticsEnabled(true);
+      em->EmitMessage(msg);
+      em->EnqueueMessage(msg);
+      em->EnqueueMessage(msg);
+
+      CHECK(em->GetMessagePump().GetStatistics(TickMessage::TYPE, stats));
+      CHECK_EQUAL((unsigned int)1, stats.mNumEmitted);
+      CHECK_EQUAL((unsigned int)2, stats.mNumEnqueued);
+      CHECK_EQUAL((unsigned int)1, stats.mNumSubscribers);
+      CHECK_EQUAL((unsigned int)2, stats.mQueueDepth);
+
+      em->EmitQueuedMessages(0);
+      CHECK(em->GetMessagePump().GetStatistics(TickMessage::TYPE, stats));
+      CHECK_EQUAL((unsigned int)3, stats.mNumEmitted);
+      CHECK_EQUAL((unsigned int)0, stats.mQueueDepth);
+      CHECK_EQUAL((unsigned int)2, stats.mMaxQueueDepth);
+      CHECK_EQUAL((unsigned int)4, counter.mCount);
+
+      em->GetMessagePump().ResetStatistics();
+      CHECK(em->GetMessagePump().GetStatistics(TickMessage::TYPE, stats));
+      CHECK_EQUAL((unsigned int)0, stats.mNumEmitted);
+
+      em->UnregisterForMessages(TickMessage::TYPE, functor);
+      delete em;
+   }
+
+   //------------------------------------------------------------------
+   TEST(ComponentMemoryStatistics)
+   {
+      EntityManager* em = new EntityManager();
+      em->AddEntitySystem(*new MapSystem(*em));
+
+      Entity* entity;
+      em->CreateEntity(entity);
+      MapComponent* mapcomp;
+      CHECK(em->CreateComponent(entity->GetId(), mapcomp));
+
+      EntityManager::MemoryStatisticsMap stats;
+      em->GetMemoryStatistics(stats);
+      CHECK(stats.find(MapComponent::TYPE) != stats.end());
+      CHECK_EQUAL((unsigned int)1, stats[MapComponent::TYPE].mNumComponents);
+      CHECK_EQUAL(sizeof(MapComponent), stats[MapComponent::TYPE].mBytesAllocated);
+
+      em->DeleteComponent(entity->GetId(), MapComponent::TYPE);
+      stats.clear();
+      em->GetMemoryStatistics(stats);
+      CHECK_EQUAL((unsigned int)0, stats[MapComponent::TYPE].mNumComponents);
+      CHECK_EQUAL((unsigned int)1, stats[MapComponent::TYPE].mPeakNumComponents);
+      CHECK_EQUAL((std::size_t)0, stats[MapComponent::TYPE].mBytesAllocated);
+      CHECK_EQUAL(sizeof(MapComponent), stats[MapComponent::TYPE].mPeakBytesAllocated);
+
+      delete em;
+   }
+
+   //------------------------------------------------------------------
+   TEST(SubscriberTiming)
+   {
+      EntityManager* em = new EntityManager();
+      TickCounter counter;
+      MessageFunctor functor(&counter, &TickCounter::OnTick);
+      em->RegisterForMessages(TickMessage::TYPE, functor, "TickCounter::OnTick");
+
+      MessagePump& pump = em->GetMessagePump();
+      TickMessage msg;
+      em->EmitMessage(msg);
+      CHECK(pump.GetSubscriberTimings().empty());
+
+      pump.SetSubscriberTimingEnabled(true);
+      em->EmitMessage(msg);
+      em->EmitMessage(msg);
+
+      MessagePump::SubscriberTimingMap::const_iterator i = pump.GetSubscriberTimings().find(SID("TickCounter::OnTick"));
+      CHECK(i != pump.GetSubscriberTimings().end());
+      if(i != pump.GetSubscriberTimings().end())
+      {
+         CHECK_EQUAL((unsigned int)2, i->second.mNumCalls);
+         CHECK(i->second.mTime >= 0);
+      }
+
+      pump.ResetSubscriberTimings();
+      i = pump.GetSubscriberTimings().find(SID("TickCounter::OnTick"));
+      CHECK(i != pump.GetSubscriberTimings().end() && i->second.mNumCalls == 0);
+
+      em->UnregisterForMessages(TickMessage::TYPE, functor);
+      delete em;
+   }
+
+   //------------------------------------------------------------------
+   struct SlowSubscriber
+   {
+      void OnTick(const Message&) { OpenThreads::Thread::microSleep(20000); }
+   };
+
+   //------------------------------------------------------------------
+   struct HitchReceiver
+   {
+      HitchReceiver() : mCount(0) {}
+      void OnFrameHitch(const Message& m)
+      {
+         ++mCount;
+         PropertyArray subscribers = static_cast<const FrameHitchMessage&>(m).GetSlowestSubscribers();
+         mSlowestSubscriber = "";
+         if(!subscribers.empty())
+         {
+            PropertyGroup grp = subscribers.front()->GroupValue();
+            mSlowestSubscriber = grp[FrameHitchMessage::NameId]->StringValue();
+         }
+      }
+      unsigned int mCount;
+      std::string mSlowestSubscriber;
+   };
+
+   //------------------------------------------------------------------
+   TEST(FrameBudgetMonitorReportsHitch)
+   {
+      EntityManager* em = new EntityManager();
+      SlowSubscriber slow;
+      MessageFunctor slowFunctor(&slow, &SlowSubscriber::OnTick);
+      em->RegisterForMessages(TickMessage::TYPE, slowFunctor, "SlowSubscriber::OnTick");
+      HitchReceiver receiver;
+      MessageFunctor hitchFunctor(&receiver, &HitchReceiver::OnFrameHitch);
+      em->RegisterForMessages(FrameHitchMessage::TYPE, hitchFunctor);
+
+      dtEntityOSG::FrameBudgetMonitor monitor(em->GetMessagePump());
+      monitor.SetEnabled(true);
+
+      // one frame with a 1 ms budget, subscriber sleeps for 20 ms
+      const double budget = 0.001;
+      monitor.BeginFrame(budget);
+      monitor.BeginStage(dtEntityOSG::FrameStage::TICK);
+      TickMessage msg;
+      em->EmitMessage(msg);
+      monitor.EndStage(dtEntityOSG::FrameStage::TICK);
+      CHECK_EQUAL((unsigned int)0, monitor.GetNumHitches());
+
+      // frame is finished and reported when the next one begins
+      monitor.BeginFrame(budget);
+
+      unsigned int numFrames = 0;
+      const std::vector<unsigned int>& histogram = monitor.GetHistogram();
+      for(std::vector<unsigned int>::const_iterator i = histogram.begin(); i != histogram.end(); ++i)
+      {
+         numFrames += *i;
+      }
+      CHECK_EQUAL((unsigned int)1, numFrames);
+      CHECK(histogram.front() == 0);
+      CHECK_EQUAL((unsigned int)1, monitor.GetNumHitches());
+      CHECK(monitor.GetLastStageTime(dtEntityOSG::FrameStage::TICK) >= 0.015);
+      CHECK(monitor.GetLastFrameTime() > budget);
+
+      CHECK_EQUAL((unsigned int)1, receiver.mCount);
+      CHECK_EQUAL("SlowSubscriber::OnTick", receiver.mSlowestSubscriber);
+
+      monitor.SetEnabled(false);
+      em->UnregisterForMessages(TickMessage::TYPE, slowFunctor);
+      em->UnregisterForMessages(FrameHitchMessage::TYPE, hitchFunctor);
+      delete em;
+   }
+
+   //------------------------------------------------------------------
+   TEST(HeadlessSystemInterfaceFixedTimeStep)
+   {
+      EntityManager* em = new EntityManager();
+      TickCounter counter;
+      MessageFunctor functor(&counter, &TickCounter::OnTick);
+      em->RegisterForMessages(TickMessage::TYPE, functor);
+
+      HeadlessSystemInterface iface(em->GetMessagePump());
+      iface.SetFixedTimeStep(0.5f);
+      iface.SetTimeScale(2);
+      iface.EmitTickMessagesAndQueuedMessages();
+      iface.EmitTickMessagesAndQueuedMessages();
+
+      CHECK_EQUAL((unsigned int)2, counter.mCount);
+      CHECK_EQUAL((unsigned int)2, iface.GetNumTicks());
+      CHECK_CLOSE(0.5f, iface.GetDeltaRealTime(), 0.0001f);
+      CHECK_CLOSE(1.0f, iface.GetDeltaSimTime(), 0.0001f);
+      CHECK_CLOSE(2.0, iface.GetSimulationTime(), 0.0001);
+      CHECK_EQUAL((Timer_t)2000000, iface.GetSimulationClockTime());
+
+      iface.SetSimulationTime(10);
+      CHECK_CLOSE(10.0, iface.GetSimulationTime(), 0.0001);
+      CHECK_EQUAL((Timer_t)2000000, iface.GetSimulationClockTime());
+
+      em->UnregisterForMessages(TickMessage::TYPE, functor);
+      delete em;
+   }
+
+   //------------------------------------------------------------------
+   TEST(ProfileCategories)
+   {
+      unsigned int categories;
+      CHECK(CProfileManager::Parse_Categories("messages,io", categories));
+      CHECK_EQUAL((unsigned int)(ProfileCategory::MESSAGES | ProfileCategory::IO), categories);
+      CHECK(!CProfileManager::Parse_Categories("systems,unknown", categories));
+      CHECK_EQUAL((unsigned int)ProfileCategory::SYSTEMS, categories);
+
+      CProfileManager::Set_Enabled_Categories(ProfileCategory::SCRIPTS);
+      CHECK(CProfileManager::Is_Enabled(ProfileCategory::SCRIPTS));
+      CHECK(!CProfileManager::Is_Enabled(ProfileCategory::MESSAGES | ProfileCategory::IO));
+      CProfileManager::Set_Enabled_Categories(ProfileCategory::NONE);
+      CHECK(!CProfileManager::Is_Enabled(ProfileCategory::ALL));
+   }
+
+   //------------------------------------------------------------------
+   TEST(ProfileLookupCounts)
+   {
+      EntityManager* em = new EntityManager();
+      em->AddEntitySystem(*new MapSystem(*em));
+
+      Entity* entity;
+      em->CreateEntity(entity);
+      MapComponent* mapcomp;
+      CHECK(em->CreateComponent(entity->GetId(), mapcomp));
+
+      CProfileManager::Set_Enabled_Categories(ProfileCategory::LOOKUPS);
+      CProfileManager::Start_Profile(SID("ProfileLookupCountsTest"));
+      for(unsigned int i = 0; i < 3; ++i)
+      {
+         CHECK(entity->GetComponent(mapcomp));
+         CHECK(em->HasComponent(entity->GetId(), MapComponent::TYPE));
+      }
+      CProfileManager::Stop_Profile();
+      CProfileManager::Set_Enabled_Categories(ProfileCategory::NONE);
+
+      unsigned int getcount = 0;
+      unsigned int hascount = 0;
+      std::vector<CProfileLookupCount> counts;
+      CProfileManager::Get_Lookup_Counts(counts);
+      for(std::vector<CProfileLookupCount>::const_iterator i = counts.begin(); i != counts.end(); ++i)
+      {
+         if(i->Caller == SID("ProfileLookupCountsTest") && i->ComponentType == MapComponent::TYPE)
+         {
+            if(i->Kind == ProfileLookup::GET_COMPONENT) getcount += i->Count;
+            if(i->Kind == ProfileLookup::HAS_COMPONENT) hascount += i->Count;
+         }
+      }
+      CHECK_EQUAL((unsigned int)3, getcount);
+      CHECK_EQUAL((unsigned int)3, hascount);
+
+      delete em;
+   }
+
 }
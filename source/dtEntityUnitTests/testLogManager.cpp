@@ -0,0 +1,150 @@
+/*
+* dtEntity Game and Simulation Engine
+*
+* This library is free software; you can redistribute it and/or modify it under
+* the terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; either version 2.1 of the License, or (at your option)
+* any later version.
+*
+* This library is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+* details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this library; if not, write to the Free Software Foundation, Inc.,
+* 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*
+* Martin Scheffler
+*/
+
+#include <dtEntity/logmanager.h>
+#include <OpenThreads/Thread>
+#include <UnitTest++.h>
+
+using namespace UnitTest;
+using namespace dtEntity;
+
+namespace LogTest
+{
+   // remembers received messages, optionally blocks in LogMessage until released
+   class RecordingListener : public LogListener
+   {
+   public:
+      RecordingListener(bool* destroyed = NULL)
+         : mBlocking(false)
+         , mEntered(false)
+         , mDestroyed(destroyed)
+      {
+      }
+
+      virtual void LogMessage(LogLevel::e level, const std::string& filename, const std::string& methodname, int linenumber,
+                      const std::string& msg)
+      {
+         mEntered = true;
+         while(mBlocking)
+         {
+            OpenThreads::Thread::microSleep(1000);
+         }
+         mLevels.push_back(level);
+         mMessages.push_back(msg);
+      }
+
+      volatile bool mBlocking;
+      volatile bool mEntered;
+      std::vector<LogLevel::e> mLevels;
+      std::vector<std::string> mMessages;
+
+   protected:
+      ~RecordingListener()
+      {
+         if(mDestroyed != NULL)
+         {
+            *mDestroyed = true;
+         }
+      }
+
+   private:
+      bool* mDestroyed;
+   };
+
+   //------------------------------------------------------------------
+   TEST(LogLevelFilter)
+   {
+      LogManager lm;
+
+      // nothing is enabled without a listener
+      CHECK(!lm.IsEnabled(LogLevel::LVL_ALWAYS));
+
+      osg::ref_ptr<RecordingListener> listener = new RecordingListener();
+      lm.AddListener(listener.get());
+      CHECK(lm.IsEnabled(LogLevel::LVL_DEBUG));
+      CHECK(lm.IsEnabled(LogLevel::LVL_INFO));
+
+      lm.SetLogLevel(LogLevel::LVL_WARNING);
+      CHECK(!lm.IsEnabled(LogLevel::LVL_DEBUG));
+      CHECK(!lm.IsEnabled(LogLevel::LVL_INFO));
+      CHECK(lm.IsEnabled(LogLevel::LVL_WARNING));
+      CHECK(lm.IsEnabled(LogLevel::LVL_ERROR));
+      CHECK(lm.IsEnabled(LogLevel::LVL_ALWAYS));
+
+      lm.SetLogLevel(LogLevel::LVL_ERROR);
+      CHECK(!lm.IsEnabled(LogLevel::LVL_WARNING));
+      CHECK(lm.IsEnabled(LogLevel::LVL_ERROR));
+      CHECK(lm.IsEnabled(LogLevel::LVL_ALWAYS));
+
+      lm.RemoveListener(listener.get());
+      CHECK(!lm.IsEnabled(LogLevel::LVL_ERROR));
+      CHECK_EQUAL(0u, (unsigned int)lm.GetNumListeners());
+   }
+
+   //------------------------------------------------------------------
+   TEST(RemovedListenerIsReleased)
+   {
+      LogManager lm;
+      bool destroyed = false;
+      lm.AddListener(new RecordingListener(&destroyed));
+      lm.LogMessage(LogLevel::LVL_INFO, __FILE__, __FUNCTION__, __LINE__, "test");
+      CHECK(!destroyed);
+
+      // no log call is running, so the replaced list is deleted right away
+      lm.RemoveListener(lm.GetListener(0));
+      CHECK(destroyed);
+   }
+
+   //------------------------------------------------------------------
+   TEST(AsyncLogListenerDropsAndFlushes)
+   {
+      osg::ref_ptr<RecordingListener> target = new RecordingListener();
+      target->mBlocking = true;
+      osg::ref_ptr<AsyncLogListener> async = new AsyncLogListener(target.get(), 2);
+
+      // writer thread takes the first message and blocks in the target
+      async->LogMessage(LogLevel::LVL_INFO, __FILE__, __FUNCTION__, __LINE__, "0");
+      for(int i = 0; i < 5000 && !target->mEntered; ++i)
+      {
+         OpenThreads::Thread::microSleep(1000);
+      }
+      CHECK(target->mEntered);
+
+      // two messages fill the ring buffer, the rest is dropped
+      async->LogMessage(LogLevel::LVL_INFO, __FILE__, __FUNCTION__, __LINE__, "1");
+      async->LogMessage(LogLevel::LVL_INFO, __FILE__, __FUNCTION__, __LINE__, "2");
+      async->LogMessage(LogLevel::LVL_INFO, __FILE__, __FUNCTION__, __LINE__, "3");
+      async->LogMessage(LogLevel::LVL_INFO, __FILE__, __FUNCTION__, __LINE__, "4");
+      CHECK_EQUAL(2u, async->GetNumDropped());
+
+      target->mBlocking = false;
+      async->Flush();
+
+      // a warning about the dropped messages is written before the next message
+      CHECK_EQUAL(4u, (unsigned int)target->mMessages.size());
+      if(target->mMessages.size() == 4)
+      {
+         CHECK_EQUAL("0", target->mMessages[0]);
+         CHECK_EQUAL(LogLevel::LVL_WARNING, target->mLevels[1]);
+         CHECK_EQUAL("1", target->mMessages[2]);
+         CHECK_EQUAL("2", target->mMessages[3]);
+      }
+   }
+}
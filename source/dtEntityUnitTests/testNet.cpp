@@ -0,0 +1,310 @@
+/*
+* dtEntity Game and Simulation Engine
+*
+* This library is free software; you can redistribute it and/or modify it under
+* the terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; either version 2.1 of the License, or (at your option)
+* any later version.
+*
+* This library is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+* details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this library; if not, write to the Free Software Foundation, Inc.,
+* 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*
+* Martin Scheffler
+*/
+
+
+#include <UnitTest++.h>
+#include <dtEntityNet/deadreckoning.h>
+#include <dtEntityNet/loopbackcomponent.h>
+#include <math.h>
+
+using namespace UnitTest;
+using namespace dtEntityNet;
+
+namespace
+{
+   const double EPSILON = 0.0001;
+
+   void CheckVec(const osg::Vec3d& expected, const osg::Vec3d& actual)
+   {
+      CHECK_CLOSE(expected[0], actual[0], EPSILON);
+      CHECK_CLOSE(expected[1], actual[1], EPSILON);
+      CHECK_CLOSE(expected[2], actual[2], EPSILON);
+   }
+
+   void CheckQuat(const osg::Quat& expected, const osg::Quat& actual)
+   {
+      // q and -q are the same rotation
+      double sign = (expected.asVec4() * actual.asVec4()) < 0 ? -1 : 1;
+      for(unsigned int i = 0; i < 4; ++i)
+      {
+         CHECK_CLOSE(expected[i], actual[i] * sign, EPSILON);
+      }
+   }
+
+   struct DeadReckoningFixture
+   {
+      DeadReckoningFixture()
+         : mPos(1, 2, 3)
+         , mVel(2, 0, 1)
+         , mAcc(0.5, -1, 0)
+         , mAngVel(0, 0, 0.8f)
+         , mTime(1.5)
+      {
+      }
+
+      void Calculate(DeadReckoningAlgorithm::e alg, const osg::Quat& rot)
+      {
+         CalculateDeadReckoning(alg, mPos, rot, mVel, mAcc, mAngVel, mTime, mNewPos, mNewRot);
+      }
+
+      osg::Vec3d mPos;
+      osg::Vec3f mVel;
+      osg::Vec3f mAcc;
+      osg::Vec3f mAngVel;
+      float mTime;
+      osg::Vec3d mNewPos;
+      osg::Quat mNewRot;
+   };
+}
+
+TEST_FIXTURE(DeadReckoningFixture, DeadReckoningStatic)
+{
+   osg::Quat rot(0.3, osg::Vec3d(1, 0, 0));
+   Calculate(DeadReckoningAlgorithm::STATIC, rot);
+   CheckVec(mPos, mNewPos);
+   CheckQuat(rot, mNewRot);
+}
+
+TEST_FIXTURE(DeadReckoningFixture, DeadReckoningWorldCoordinates)
+{
+   osg::Quat rot(0.3, osg::Vec3d(1, 0, 0));
+   const double t = mTime;
+   const osg::Vec3d linear = mPos + osg::Vec3d(mVel) * t;
+   const osg::Vec3d accelerated = linear + osg::Vec3d(mAcc) * (0.5 * t * t);
+   const osg::Quat turned = rot * osg::Quat(mAngVel.length() * t, osg::Vec3d(0, 0, 1));
+
+   Calculate(DeadReckoningAlgorithm::FPW, rot);
+   CheckVec(linear, mNewPos);
+   CheckQuat(rot, mNewRot);
+
+   Calculate(DeadReckoningAlgorithm::FVW, rot);
+   CheckVec(accelerated, mNewPos);
+   CheckQuat(rot, mNewRot);
+
+   Calculate(DeadReckoningAlgorithm::RPW, rot);
+   CheckVec(linear, mNewPos);
+   CheckQuat(turned, mNewRot);
+
+   Calculate(DeadReckoningAlgorithm::RVW, rot);
+   CheckVec(accelerated, mNewPos);
+   CheckQuat(turned, mNewRot);
+}
+
+TEST_FIXTURE(DeadReckoningFixture, DeadReckoningFixedBodyCoordinates)
+{
+   // body x axis points along world y
+   osg::Quat rot(osg::PI_2, osg::Vec3d(0, 0, 1));
+   const double t = mTime;
+   const osg::Vec3d vel(-mVel[1], mVel[0], mVel[2]);
+   const osg::Vec3d acc(-mAcc[1], mAcc[0], mAcc[2]);
+
+   Calculate(DeadReckoningAlgorithm::FPB, rot);
+   CheckVec(mPos + vel * t, mNewPos);
+   CheckQuat(rot, mNewRot);
+
+   Calculate(DeadReckoningAlgorithm::FVB, rot);
+   CheckVec(mPos + vel * t + acc * (0.5 * t * t), mNewPos);
+   CheckQuat(rot, mNewRot);
+}
+
+TEST_FIXTURE(DeadReckoningFixture, DeadReckoningRotatingBodyCoordinates)
+{
+   // Turning about z with rate w, body velocity (v, 0, 0) drives a circle:
+   // x = v / w * sin(w t), y = v / w * (1 - cos(w t))
+   // Body acceleration (a, 0, 0) from rest gives world velocity a s (cos(w s), sin(w s)):
+   // x = a * (w t sin(w t) + cos(w t) - 1) / w^2, y = a * (sin(w t) - w t cos(w t)) / w^2
+   mVel.set(2, 0, 0);
+   mAngVel.set(0, 0, 0.8f);
+   const double w = mAngVel[2];
+   const double t = mTime;
+   const double wt = w * t;
+   osg::Quat rot;
+
+   Calculate(DeadReckoningAlgorithm::RPB, rot);
+   CheckVec(mPos + osg::Vec3d(2 / w * sin(wt), 2 / w * (1 - cos(wt)), 0), mNewPos);
+   CheckQuat(osg::Quat(wt, osg::Vec3d(0, 0, 1)), mNewRot);
+
+   mVel.set(0, 0, 0);
+   mAcc.set(3, 0, 0);
+   Calculate(DeadReckoningAlgorithm::RVB, rot);
+   CheckVec(mPos + osg::Vec3d(3 * (wt * sin(wt) + cos(wt) - 1) / (w * w),
+                              3 * (sin(wt) - wt * cos(wt)) / (w * w), 0), mNewPos);
+   CheckQuat(osg::Quat(wt, osg::Vec3d(0, 0, 1)), mNewRot);
+
+   // velocity parallel to rotation axis is not turned
+   mVel.set(0, 0, 2);
+   mAcc.set(0, 0, 3);
+   Calculate(DeadReckoningAlgorithm::RVB, rot);
+   CheckVec(mPos + osg::Vec3d(0, 0, 2 * t + 1.5 * t * t), mNewPos);
+}
+
+TEST_FIXTURE(DeadReckoningFixture, DeadReckoningBatchMatchesSingle)
+{
+   osg::Quat rot(0.4, osg::Vec3d(0, 1, 0));
+   const double sendtime = 10;
+   DeadReckoningBatch batch;
+   for(unsigned int alg = DeadReckoningAlgorithm::STATIC; alg <= DeadReckoningAlgorithm::FVB; ++alg)
+   {
+      unsigned int idx = batch.Add();
+      batch.Set(idx, static_cast<DeadReckoningAlgorithm::e>(alg), sendtime, mPos, rot, mVel, mAcc, mAngVel);
+   }
+   batch.Extrapolate(sendtime + mTime);
+
+   for(unsigned int idx = 0; idx < batch.Size(); ++idx)
+   {
+      Calculate(batch.GetAlgorithm(idx), rot);
+      CheckVec(mNewPos, batch.GetPosition(idx));
+      CheckQuat(mNewRot, batch.GetOrientation(idx));
+   }
+}
+
+namespace
+{
+   // send count unreliable packets from server to client, return number received
+   unsigned int SendLossy(unsigned int seed, unsigned int count)
+   {
+      osg::ref_ptr<LoopbackNetwork> net = new LoopbackNetwork(seed);
+      LoopbackNetwork::EndpointId client = net->Connect();
+      net->SetPacketLoss(0.5f);
+      for(unsigned int i = 0; i < count; ++i)
+      {
+         net->Send(LoopbackNetwork::SERVER_ENDPOINT, client, "x", false);
+      }
+      LoopbackNetwork::PacketType type;
+      LoopbackNetwork::EndpointId from;
+      std::string data;
+      unsigned int received = 0;
+      while(net->Receive(client, type, from, data))
+      {
+         ++received;
+      }
+      CHECK_EQUAL(count, net->GetStatistics().mPacketsSent);
+      CHECK_EQUAL(count, net->GetStatistics().mPacketsDropped + net->GetStatistics().mPacketsDelivered);
+      CHECK_EQUAL(received, net->GetStatistics().mPacketsDelivered);
+      return received;
+   }
+}
+
+TEST(LoopbackDeliveryAndLatency)
+{
+   osg::ref_ptr<LoopbackNetwork> net = new LoopbackNetwork(1);
+   net->SetLatency(0.1);
+
+   LoopbackNetwork::PacketType type;
+   LoopbackNetwork::EndpointId from;
+   std::string data;
+
+   LoopbackNetwork::EndpointId client = net->Connect();
+   CHECK(!net->Receive(LoopbackNetwork::SERVER_ENDPOINT, type, from, data));
+
+   net->SetTime(0.1);
+   CHECK(net->Receive(LoopbackNetwork::SERVER_ENDPOINT, type, from, data));
+   CHECK_EQUAL(LoopbackNetwork::CONNECT, type);
+   CHECK_EQUAL(client, from);
+
+   net->Send(client, LoopbackNetwork::SERVER_ENDPOINT, "first", true);
+   net->Send(client, LoopbackNetwork::SERVER_ENDPOINT, "second", false);
+
+   net->SetTime(0.15);
+   CHECK(!net->Receive(LoopbackNetwork::SERVER_ENDPOINT, type, from, data));
+
+   net->SetTime(0.2);
+   CHECK(net->Receive(LoopbackNetwork::SERVER_ENDPOINT, type, from, data));
+   CHECK_EQUAL(LoopbackNetwork::DATA, type);
+   CHECK_EQUAL("first", data);
+   CHECK(net->Receive(LoopbackNetwork::SERVER_ENDPOINT, type, from, data));
+   CHECK_EQUAL("second", data);
+   CHECK(!net->Receive(LoopbackNetwork::SERVER_ENDPOINT, type, from, data));
+
+   CHECK_EQUAL(2u, net->GetStatistics().mPacketsDelivered);
+   CHECK_EQUAL(11u, net->GetStatistics().mBytesDelivered);
+}
+
+TEST(LoopbackPacketLossIsSeeded)
+{
+   unsigned int received = SendLossy(42, 1000);
+   CHECK(received > 400 && received < 600);
+
+   // same seed, same schedule
+   CHECK_EQUAL(received, SendLossy(42, 1000));
+}
+
+TEST(LoopbackReliablePacketsAreResent)
+{
+   osg::ref_ptr<LoopbackNetwork> net = new LoopbackNetwork(7);
+   net->SetLatency(0.05);
+   net->SetPacketLoss(0.2f);
+   LoopbackNetwork::EndpointId client = net->Connect();
+   for(unsigned int i = 0; i < 100; ++i)
+   {
+      net->Send(LoopbackNetwork::SERVER_ENDPOINT, client, "x", true);
+   }
+
+   LoopbackNetwork::PacketType type;
+   LoopbackNetwork::EndpointId from;
+   std::string data;
+   unsigned int received = 0;
+
+   // lost packets arrive late, after at least one resend round trip
+   net->SetTime(0.05);
+   while(net->Receive(client, type, from, data))
+   {
+      ++received;
+   }
+   CHECK(received < 100);
+
+   net->SetTime(100);
+   while(net->Receive(client, type, from, data))
+   {
+      ++received;
+   }
+   CHECK_EQUAL(100u, received);
+   CHECK_EQUAL(0u, net->GetStatistics().mPacketsDropped);
+}
+
+TEST(LoopbackServerDisconnectReachesAllClients)
+{
+   osg::ref_ptr<LoopbackNetwork> net = new LoopbackNetwork(3);
+   net->SetLatency(0.1);
+   LoopbackNetwork::EndpointId client1 = net->Connect();
+   LoopbackNetwork::EndpointId client2 = net->Connect();
+
+   net->Send(LoopbackNetwork::SERVER_ENDPOINT, client1, "stale", true);
+   net->Disconnect(LoopbackNetwork::SERVER_ENDPOINT);
+
+   LoopbackNetwork::PacketType type;
+   LoopbackNetwork::EndpointId from;
+   std::string data;
+
+   net->SetTime(1);
+   CHECK(net->Receive(client1, type, from, data));
+   CHECK_EQUAL(LoopbackNetwork::DATA, type);
+   CHECK(net->IsConnected(client1));
+
+   LoopbackNetwork::EndpointId clients[] = { client1, client2 };
+   for(unsigned int i = 0; i < 2; ++i)
+   {
+      CHECK(net->Receive(clients[i], type, from, data));
+      CHECK_EQUAL(LoopbackNetwork::DISCONNECT, type);
+      CHECK_EQUAL(LoopbackNetwork::SERVER_ENDPOINT, from);
+      CHECK(!net->IsConnected(clients[i]));
+      CHECK(!net->Receive(clients[i], type, from, data));
+   }
+}
@@ -19,8 +19,18 @@
 */
 
 #include <UnitTest++.h>
+#include <dtEntity/core.h>
+#include <dtEntity/headlesssysteminterface.h>
+#include <dtEntityWrappers/bytestorage.h>
+#include <dtEntityWrappers/messages.h>
 #include <dtEntityWrappers/scriptcomponent.h>
 #include <dtEntityWrappers/v8helpers.h>
+#include <dtEntityWrappers/workerpool.h>
+#include <OpenThreads/Thread>
+#include <osgDB/FileUtils>
+#include <fstream>
+#include <stdio.h>
+#include <stdlib.h>
 
 using namespace dtEntityWrappers;
 using namespace dtEntity;
@@ -69,3 +79,124 @@ TEST(Println)
    f.mScriptSystem->ExecuteFile("Scripts/test.js");
 
 }
+
+void CountRelease(char* data, size_t length, void* userdata)
+{
+   ++*static_cast<int*>(userdata);
+}
+
+TEST(ByteStorageExternalMemory)
+{
+   char data[] = "external";
+   int released = 0;
+   ByteStorage* bs = new ByteStorage(data, 8, CountRelease, &released);
+   CHECK(bs->getData() == data);
+   ByteStorage* view = new ByteStorage(bs, 2, 5);
+   CHECK_EQUAL(view->getByte(0), 't');
+   delete bs;
+   CHECK_EQUAL(released, 0);
+   delete view;
+   CHECK_EQUAL(released, 1);
+}
+
+struct WorkerResultReceiver
+{
+   WorkerResultReceiver(EntityManager& em)
+      : mEntityManager(&em)
+      , mNumResults(0)
+      , mJobId(0)
+      , mValue(0)
+   {
+      mFunctor = MessageFunctor(this, &WorkerResultReceiver::OnWorkerMessage);
+      em.RegisterForMessages(WorkerMessage::TYPE, mFunctor);
+   }
+
+   ~WorkerResultReceiver()
+   {
+      mEntityManager->UnregisterForMessages(WorkerMessage::TYPE, mFunctor);
+   }
+
+   void OnWorkerMessage(const Message& m)
+   {
+      const WorkerMessage& msg = static_cast<const WorkerMessage&>(m);
+      ++mNumResults;
+      mModule = msg.GetModule();
+      mJobId = msg.GetJobId();
+      PropertyGroup data = msg.GetData();
+      PropertyGroup::const_iterator i = data.find(SID("value"));
+      if(i != data.end())
+      {
+         mValue = i->second->DoubleValue();
+      }
+   }
+
+   EntityManager* mEntityManager;
+   MessageFunctor mFunctor;
+   unsigned int mNumResults;
+   std::string mModule;
+   unsigned int mJobId;
+   double mValue;
+};
+
+static std::string GetTempDirectory()
+{
+   const char* vars[] = { "TMPDIR", "TEMP", "TMP" };
+   for(unsigned int i = 0; i < 3; ++i)
+   {
+      const char* dir = getenv(vars[i]);
+      if(dir != NULL && dir[0] != '\0')
+      {
+         return dir;
+      }
+   }
+   return "/tmp";
+}
+
+TEST(WorkerPoolRoundTrip)
+{
+   EntityManager em;
+   if(GetSystemInterface() == NULL)
+   {
+      SetSystemInterface(new HeadlessSystemInterface(em.GetMessagePump()));
+   }
+
+   // module is written to a temp dir so no files are left in the working directory
+   const std::string dir = GetTempDirectory() + "/dtEntityUnitTests";
+   CHECK(osgDB::makeDirectory(dir));
+   const std::string module = dir + "/workerpooltest.js";
+   {
+      std::ofstream out(module.c_str());
+      out << "function onmessage(data, buffers, jobid) { postMessage({value: data.value * 2}); }";
+   }
+
+   WorkerResultReceiver receiver(em);
+   {
+      WorkerPool pool(em);
+      pool.SetNumThreads(1);
+      CHECK(pool.AddModule(module));
+
+      // modules that were not added from C++ are refused
+      CHECK_EQUAL(pool.Post("notallowed.js", new GroupProperty(), WorkerPool::Buffers()), 0u);
+
+      GroupProperty* data = new GroupProperty();
+      data->Add(SID("value"), new DoubleProperty(21));
+      unsigned int jobid = pool.Post(module, data, WorkerPool::Buffers());
+      CHECK(jobid != 0);
+
+      // give worker up to five seconds to answer
+      for(int i = 0; i < 500 && receiver.mNumResults == 0; ++i)
+      {
+         OpenThreads::Thread::microSleep(10000);
+         em.EmitQueuedMessages(0);
+      }
+
+      CHECK_EQUAL(receiver.mNumResults, 1u);
+      CHECK_EQUAL(receiver.mModule, module);
+      CHECK_EQUAL(receiver.mJobId, jobid);
+      CHECK_CLOSE(receiver.mValue, 42.0, 0.0001);
+      CHECK_EQUAL(pool.GetNumPendingJobs(), 0u);
+   }
+   remove(module.c_str());
+   // only removes the directory if it is empty
+   remove(dir.c_str());
+}
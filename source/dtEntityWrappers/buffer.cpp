@@ -37,9 +37,6 @@
 
 namespace dtEntityWrappers{
 
-	v8::Persistent<v8::FunctionTemplate> bufferTemplate;
-	v8::Persistent<v8::Function> buffer;
-
 	////////////////////////////////////////////////////////////////////////////////
 	size_t firstIndex(v8::Handle<v8::Value> index, size_t length) {
 		int i = 0;
@@ -140,7 +137,7 @@ namespace dtEntityWrappers{
 				Buffer_fromArray(args);
 			} else if (args[0]->IsObject()) {
 				Handle<Object> obj = Handle<Object>::Cast(args[0]);
-				if (INSTANCEOF(obj, bufferTemplate)) {
+				if (IS_BUFFER(v8::Context::GetCurrent(), obj)) {
 					Buffer_fromBuffer(args, obj);
 				} else { WRONG_CTOR; }
 			} else if (args[0]->IsString()) {
@@ -203,8 +200,7 @@ namespace dtEntityWrappers{
 		size_t index2 = lastIndex(args[1], bs->getLength());
 
 		ByteStorage * bs2 = new ByteStorage(bs, index1, index2);
-		v8::Handle<v8::Value> newargs[] = { v8::External::New((void*)bs2) };
-		return buffer->NewInstance(1, newargs);
+		return BYTESTORAGE_TO_JS(v8::Context::GetCurrent(), bs2);
 	}
 
 	////////////////////////////////////////////////////////////////////////////////
@@ -216,8 +212,7 @@ namespace dtEntityWrappers{
 		size_t length = index2-index1;
 		ByteStorage * bs2 = new ByteStorage(bs->getData() + index1, length);
 
-		v8::Handle<v8::Value> newargs[] = { v8::External::New((void*)bs2) };
-		return buffer->NewInstance(1, newargs);
+		return BYTESTORAGE_TO_JS(v8::Context::GetCurrent(), bs2);
 	}
 
 	////////////////////////////////////////////////////////////////////////////////
@@ -254,7 +249,7 @@ namespace dtEntityWrappers{
 			length = arr->Length();
 		} else if (args[0]->IsObject()) {
 			v8::Handle<v8::Object> obj = v8::Handle<v8::Object>::Cast(args[0]);
-			if (!INSTANCEOF(obj, bufferTemplate)) { return JS_TYPE_ERROR(errmsg); }
+			if (!IS_BUFFER(v8::Context::GetCurrent(), obj)) { return JS_TYPE_ERROR(errmsg); }
 			bs2 = BS_OTHER(obj);
 			length = bs2->getLength();
 		} else { return JS_TYPE_ERROR(errmsg); }
@@ -346,7 +341,7 @@ namespace dtEntityWrappers{
       using namespace v8;
 		HandleScope handle_scope;
 
-		bufferTemplate = Persistent<FunctionTemplate>::New(FunctionTemplate::New(_Buffer));
+		Handle<FunctionTemplate> bufferTemplate = FunctionTemplate::New(_Buffer);
 		bufferTemplate->SetClassName(JS_STR("Buffer"));
 
 		Handle<ObjectTemplate> bufferPrototype = bufferTemplate->PrototypeTemplate();
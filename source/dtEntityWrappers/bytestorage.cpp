@@ -73,6 +73,33 @@ namespace dtEntityWrappers
       this->data = bs->getData() + index1;
    }
 
+   /**
+    * Wrap external memory, release function is called when last view is deleted
+    */
+   ByteStorage::ByteStorage(char * data, size_t length, ByteStorageReleaseFunc release, void * userdata) {
+      this->length = length;
+      this->storage = new ByteStorageData(data, length, release, userdata);
+      this->data = data;
+   }
+
+   static void mmap_release(char * data, size_t length, void * userdata) {
+      mmap_free(data, length);
+   }
+
+   /**
+    * Map file contents into memory. Pages are copy-on-write, changes
+    * to the buffer are not written back to the file
+    */
+   ByteStorage * ByteStorage::mapFile(const char * name) {
+      size_t size = (size_t) -1;
+      char * data = (char *) mmap_read((char *) name, &size);
+      if (!data) {
+         /* empty files cannot be mapped */
+         return (size == 0) ? new ByteStorage((size_t) 0) : NULL;
+      }
+      return new ByteStorage(data, size, mmap_release, NULL);
+   }
+
    ByteStorage::~ByteStorage() {
       this->data = NULL;
       size_t inst = this->storage->getInstances();
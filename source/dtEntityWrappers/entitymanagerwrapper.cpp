@@ -36,6 +36,7 @@
 #include <dtEntityWrappers/wrappers.h>
 #include <iostream>
 #include <sstream>
+#include <vector>
 #include <assert.h>
 
 using namespace v8;
@@ -95,6 +96,115 @@ namespace dtEntityWrappers
       return scope.Close(o);
    }
 
+   ////////////////////////////////////////////////////////////////////////////////
+   // Message objects passed to script message handlers are created from a
+   // template per message type. Property values are read from the native
+   // message only when the script accesses them.
+   struct MessageTemplate
+   {
+      Persistent<FunctionTemplate> mTemplate;
+      std::vector<dtEntity::StringId> mPropertyNames;
+   };
+
+   typedef std::map<dtEntity::MessageType, MessageTemplate> MessageTemplateMap;
+   static MessageTemplateMap s_messageTemplates;
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void ClearMessageTemplates()
+   {
+      for(MessageTemplateMap::iterator i = s_messageTemplates.begin(); i != s_messageTemplates.end(); ++i)
+      {
+         i->second.mTemplate.Dispose();
+      }
+      s_messageTemplates.clear();
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   Handle<Value> MessagePropertyGetter(Local<String> propname, const AccessorInfo& info)
+   {
+      // values assigned by the script take precedence
+      Handle<Value> assigned = info.Holder()->GetHiddenValue(propname);
+      if(!assigned.IsEmpty())
+      {
+         return assigned;
+      }
+
+      dtEntity::Message* msg;
+      GetInternal(info.Holder(), 0, msg);
+      if(msg == NULL)
+      {
+         // message object was kept beyond the message handler call
+         return Undefined();
+      }
+      const dtEntity::Property* prop = msg->Get(UnwrapSID(info.Data()));
+      if(prop == NULL)
+      {
+         return Undefined();
+      }
+      return ConvertPropertyToValue(Context::GetCurrent(), prop);
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void MessagePropertySetter(Local<String> propname, Local<Value> value, const AccessorInfo& info)
+   {
+      // native message is shared with other handlers, keep the value on the script object only
+      info.Holder()->SetHiddenValue(propname, value);
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   bool HasPropertyNames(const MessageTemplate& templt, const dtEntity::PropertyGroup& params)
+   {
+      if(templt.mPropertyNames.size() != params.size())
+      {
+         return false;
+      }
+      std::vector<dtEntity::StringId>::const_iterator i = templt.mPropertyNames.begin();
+      dtEntity::PropertyGroup::const_iterator j;
+      for(j = params.begin(); j != params.end(); ++j, ++i)
+      {
+         if(*i != j->first)
+         {
+            return false;
+         }
+      }
+      return true;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   Handle<FunctionTemplate> GetMessageTemplate(const dtEntity::Message& msg)
+   {
+      const dtEntity::PropertyGroup& params = msg.Get();
+
+      MessageTemplateMap::iterator i = s_messageTemplates.find(msg.GetType());
+      if(i != s_messageTemplates.end())
+      {
+         // messages with a different set of properties are converted eagerly
+         if(!HasPropertyNames(i->second, params))
+         {
+            return Handle<FunctionTemplate>();
+         }
+         return i->second.mTemplate;
+      }
+
+      HandleScope scope;
+      Handle<FunctionTemplate> templt = FunctionTemplate::New();
+      templt->SetClassName(GetString(msg.GetType()));
+
+      Handle<ObjectTemplate> instt = templt->InstanceTemplate();
+      instt->SetInternalFieldCount(1);
+
+      MessageTemplate& entry = s_messageTemplates[msg.GetType()];
+      entry.mTemplate = Persistent<FunctionTemplate>::New(templt);
+
+      dtEntity::PropertyGroup::const_iterator j;
+      for(j = params.begin(); j != params.end(); ++j)
+      {
+         instt->SetAccessor(GetString(j->first), MessagePropertyGetter, MessagePropertySetter, WrapSID(j->first));
+         entry.mPropertyNames.push_back(j->first);
+      }
+      return scope.Close(templt);
+   }
+
    ////////////////////////////////////////////////////////////////////////////////
    struct MessageFunctorHolder
    {
@@ -120,9 +230,26 @@ namespace dtEntityWrappers
    
          TryCatch try_catch;
 
-         Handle<Value> argv[2] = { mMessageTypeStr, ConvertMessageToJS(context, msg) };
+         Handle<Value> result;
+         Handle<FunctionTemplate> templt = GetMessageTemplate(msg);
+         if(templt.IsEmpty())
+         {
+            Handle<Value> argv[2] = { mMessageTypeStr, ConvertMessageToJS(context, msg) };
+            result = mFunction->Call(mFunction, 2, argv);
+         }
+         else
+         {
+            // each call gets its own message object. It points to the native
+            // message only while the handler runs, a handler that keeps the
+            // object afterwards reads undefined for values it did not assign
+            Handle<Object> msgobj = templt->GetFunction()->NewInstance();
+            msgobj->SetPointerInInternalField(0, const_cast<dtEntity::Message*>(&msg));
+
+            Handle<Value> argv[2] = { mMessageTypeStr, msgobj };
+            result = mFunction->Call(mFunction, 2, argv);
 
-         Handle<Value> result = mFunction->Call(mFunction, 2, argv);
+            msgobj->SetPointerInInternalField(0, NULL);
+         }
 
          if(result.IsEmpty()) 
          {
@@ -422,6 +549,38 @@ namespace dtEntityWrappers
          "hasComponent(), getComponent(), createComponent(), deleteComponent() and getEntitiesInSystem()");
    }
 
+   ////////////////////////////////////////////////////////////////////////////////
+   Handle<Value> EMTransferProperties(const v8::Arguments& args, bool write)
+   {
+      if(args.Length() < 4 || !args[0]->IsString())
+      {
+         return ThrowError(write ?
+            "usage: writeProperties(string componentType, propertyname, entityids, typedarray values)" :
+            "usage: readProperties(string componentType, propertyname, entityids, typedarray result)");
+      }
+      dtEntity::EntityManager* em = UnwrapEntityManager(args.This());
+      dtEntity::ComponentType t = dtEntity::SIDHash(ToStdString(args[0]));
+      dtEntity::EntitySystem* es = em->GetEntitySystem(t);
+      if(es == NULL)
+      {
+         return ThrowError("No entity system of type " + ToStdString(args[0]));
+      }
+      dtEntity::StringId propname = args[1]->IsString() ? dtEntity::SIDHash(ToStdString(args[1])) : UnwrapSID(args[1]);
+      return TransferPropertyValues(es, propname, args[2], args[3], write);
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   Handle<Value> EMReadProperties(const v8::Arguments& args)
+   {
+      return EMTransferProperties(args, false);
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   Handle<Value> EMWriteProperties(const v8::Arguments& args)
+   {
+      return EMTransferProperties(args, true);
+   }
+
    ////////////////////////////////////////////////////////////////////////////////
    Handle<Value> EMGetEntitySystem(const v8::Arguments& args)
    {  
@@ -494,11 +653,13 @@ namespace dtEntityWrappers
         proto->Set("getEntitySystem", FunctionTemplate::New(EMGetEntitySystem));
         proto->Set("hasEntitySystem", FunctionTemplate::New(EMHasEntitySystem));
         proto->Set("killEntity", FunctionTemplate::New(EMKillEntity));
+        proto->Set("readProperties", FunctionTemplate::New(EMReadProperties));
         proto->Set("addPlugin", FunctionTemplate::New(EMAddPlugin));
         proto->Set("registerForMessages", FunctionTemplate::New(EMRegisterForMessages));
         proto->Set("unregisterForMessages", FunctionTemplate::New(EMUnregisterForMessages));
         proto->Set("removeFromScene", FunctionTemplate::New(EMRemoveFromScene));
         proto->Set("toString", FunctionTemplate::New(EMToString));
+        proto->Set("writeProperties", FunctionTemplate::New(EMWriteProperties));
 
         GetScriptSystem()->SetTemplateBySID(s_entityManagerWrapper, templt);
 
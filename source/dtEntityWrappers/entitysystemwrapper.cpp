@@ -31,6 +31,7 @@
 
 #include <iostream>
 #include <sstream>
+#include <vector>
 #include <assert.h>
 
 using namespace v8;
@@ -224,6 +225,169 @@ namespace dtEntityWrappers
       return SetValueFromProperty(prop, args[1]);
    }
    
+   ////////////////////////////////////////////////////////////////////////////////
+   // get entity ids from plain array or Uint32Array
+   bool GetEntityIdList(Handle<Value> val, std::vector<dtEntity::EntityId>& ids)
+   {
+      if(val.IsEmpty() || !val->IsObject())
+      {
+         return false;
+      }
+      Handle<Object> obj = Handle<Object>::Cast(val);
+      if(obj->HasIndexedPropertiesInExternalArrayData() &&
+         obj->GetIndexedPropertiesExternalArrayDataType() == kExternalUnsignedIntArray)
+      {
+         unsigned int* data = static_cast<unsigned int*>(obj->GetIndexedPropertiesExternalArrayData());
+         ids.assign(data, data + obj->GetIndexedPropertiesExternalArrayDataLength());
+         return true;
+      }
+      if(!val->IsArray())
+      {
+         return false;
+      }
+      Handle<Array> arr = Handle<Array>::Cast(val);
+      unsigned int len = arr->Length();
+      ids.resize(len);
+      for(unsigned int i = 0; i < len; ++i)
+      {
+         ids[i] = arr->Get(i)->Uint32Value();
+      }
+      return true;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   template <typename T>
+   void CopyValues(void* data, unsigned int offset, double* values, unsigned int count, bool store)
+   {
+      T* d = static_cast<T*>(data) + offset;
+      for(unsigned int i = 0; i < count; ++i)
+      {
+         if(store)
+         {
+            d[i] = static_cast<T>(values[i]);
+         }
+         else
+         {
+            values[i] = static_cast<double>(d[i]);
+         }
+      }
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   // store values to typed array storage or load them from it
+   void CopyTypedArrayValues(ExternalArrayType type, void* data, unsigned int offset,
+      double* values, unsigned int count, bool store)
+   {
+      switch(type)
+      {
+      case kExternalByteArray:          CopyValues<signed char>(data, offset, values, count, store); break;
+      case kExternalUnsignedByteArray:  CopyValues<unsigned char>(data, offset, values, count, store); break;
+      case kExternalShortArray:         CopyValues<short>(data, offset, values, count, store); break;
+      case kExternalUnsignedShortArray: CopyValues<unsigned short>(data, offset, values, count, store); break;
+      case kExternalIntArray:           CopyValues<int>(data, offset, values, count, store); break;
+      case kExternalUnsignedIntArray:   CopyValues<unsigned int>(data, offset, values, count, store); break;
+      case kExternalFloatArray:         CopyValues<float>(data, offset, values, count, store); break;
+      case kExternalDoubleArray:        CopyValues<double>(data, offset, values, count, store); break;
+      default: assert(false && "Unsupported typed array type!");
+      }
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   Handle<Value> TransferPropertyValues(dtEntity::EntitySystem* es, dtEntity::StringId propname,
+      Handle<Value> entityids, Handle<Value> values, bool write)
+   {
+      std::vector<dtEntity::EntityId> ids;
+      if(!GetEntityIdList(entityids, ids))
+      {
+         return ThrowError("Expected array of entity ids!");
+      }
+
+      if(values.IsEmpty() || !values->IsObject())
+      {
+         return ThrowError("Expected typed array for property values!");
+      }
+      Handle<Object> arr = Handle<Object>::Cast(values);
+      if(!arr->HasIndexedPropertiesInExternalArrayData() ||
+         arr->GetIndexedPropertiesExternalArrayDataType() == kExternalPixelArray)
+      {
+         return ThrowError("Expected typed array for property values!");
+      }
+      ExternalArrayType type = arr->GetIndexedPropertiesExternalArrayDataType();
+      void* data = arr->GetIndexedPropertiesExternalArrayData();
+      unsigned int len = arr->GetIndexedPropertiesExternalArrayDataLength();
+
+      double buf[16];
+      unsigned int stride = 0;
+      unsigned int count = 0;
+      for(unsigned int i = 0; i < ids.size(); ++i)
+      {
+         dtEntity::Component* comp;
+         if(!es->GetComponent(ids[i], comp))
+         {
+            continue;
+         }
+         dtEntity::Property* prop = comp->Get(propname);
+         if(prop == NULL)
+         {
+            continue;
+         }
+
+         if(stride == 0)
+         {
+            stride = GetNumPackedValues(prop->GetDataType());
+            if(stride == 0)
+            {
+               return ThrowError("Cannot transfer values of non-numeric property " + dtEntity::GetStringFromSID(propname));
+            }
+         }
+         unsigned int offset = i * stride;
+         if(offset + stride > len)
+         {
+            return ThrowError("Typed array too short for property values!");
+         }
+
+         if(write)
+         {
+            CopyTypedArrayValues(type, data, offset, buf, stride, false);
+            UnpackProperty(buf, *prop);
+#if CALL_ONPROPERTYCHANGED_METHOD
+            comp->OnPropertyChanged(propname, *prop);
+#endif
+         }
+         else
+         {
+            PackProperty(*prop, buf);
+            CopyTypedArrayValues(type, data, offset, buf, stride, true);
+         }
+         ++count;
+      }
+      return Integer::New(count);
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   Handle<Value> ESReadProperties(const Arguments& args)
+   {
+      if(args.Length() < 3)
+      {
+         return ThrowError("Usage: readProperties(propertyname, entityids, typedarray result)");
+      }
+      dtEntity::EntitySystem* es = UnwrapEntitySystem(args.This());
+      dtEntity::StringId propname = args[0]->IsString() ? dtEntity::SIDHash(ToStdString(args[0])) : UnwrapSID(args[0]);
+      return TransferPropertyValues(es, propname, args[1], args[2], false);
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   Handle<Value> ESWriteProperties(const Arguments& args)
+   {
+      if(args.Length() < 3)
+      {
+         return ThrowError("Usage: writeProperties(propertyname, entityids, typedarray values)");
+      }
+      dtEntity::EntitySystem* es = UnwrapEntitySystem(args.This());
+      dtEntity::StringId propname = args[0]->IsString() ? dtEntity::SIDHash(ToStdString(args[0])) : UnwrapSID(args[0]);
+      return TransferPropertyValues(es, propname, args[1], args[2], true);
+   }
+
    ////////////////////////////////////////////////////////////////////////////////
    Handle<Value> ESFinished(const Arguments& args)
    {
@@ -253,7 +417,17 @@ namespace dtEntityWrappers
          HandleScope scope;
          Handle<Value> val = args[idx];
 
-         if(val->IsArray())
+         double* data;
+         unsigned int len;
+         if(GetFloat64ArrayData(val, data, len))
+         {
+            dtEntity::Property* p = ConvertValueToProperty(val);
+            pargs.push_back(p);
+            Handle<Value> ret = ESCallScriptMethodRecursive(args, pargs, idx + 1);
+            delete p;
+            return scope.Close(ret);
+         }
+         else if(val->IsArray())
          {
             Handle<Array> arr = Handle<Array>::Cast(val);
 
@@ -467,6 +641,8 @@ namespace dtEntityWrappers
         proto->Set("deleteComponent", FunctionTemplate::New(ESDeleteComponent));
         proto->Set("copyPropertyValues", FunctionTemplate::New(ESCopyPropertyValues));
         proto->Set("finished", FunctionTemplate::New(ESFinished));
+        proto->Set("readProperties", FunctionTemplate::New(ESReadProperties));
+        proto->Set("writeProperties", FunctionTemplate::New(ESWriteProperties));
 
         proto->Set("storeComponentToMap", FunctionTemplate::New(ESStoreComponentToMap));
         proto->Set("allowComponentCreationBySpawner", FunctionTemplate::New(ESAllowComponentCreationBySpawner));
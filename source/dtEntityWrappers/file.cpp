@@ -22,8 +22,16 @@
 
 #include <dtEntity/core.h>
 #include <dtEntity/systeminterface.h>
+#include <dtEntity/threadsafequeue.h>
+#include <dtEntityWrappers/bytestorage.h>
 #include <dtEntityWrappers/v8helpers.h>
+#include <OpenThreads/Condition>
+#include <OpenThreads/Mutex>
+#include <OpenThreads/ScopedLock>
+#include <OpenThreads/Thread>
+#include <deque>
 #include <iostream>
+#include <stdio.h>
 #include <v8.h>
 #include <sys/stat.h>
 
@@ -37,6 +45,216 @@ namespace dtEntityWrappers
 
    Persistent<Function> s_file;
 
+   ////////////////////////////////////////////////////////////////////////////////
+   // use file from data paths if it exists there, else use name as it is
+   std::string ResolvePath(const std::string& name)
+   {
+      std::string abspath = dtEntity::GetSystemInterface()->FindDataFile(name);
+      return (abspath == "") ? name : abspath;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   // read whole file into a new storage, NULL on error
+   ByteStorage* ReadFileToStorage(const std::string& path)
+   {
+      FILE* f = fopen(path.c_str(), "rb");
+      if(f == NULL)
+      {
+         return NULL;
+      }
+      ByteStorage* bs = NULL;
+      if(fseek(f, 0, SEEK_END) == 0)
+      {
+         long size = ftell(f);
+         if(size >= 0 && fseek(f, 0, SEEK_SET) == 0)
+         {
+            bs = new ByteStorage(static_cast<size_t>(size));
+            if(size > 0 && fread(bs->getData(), 1, size, f) != static_cast<size_t>(size))
+            {
+               delete bs;
+               bs = NULL;
+            }
+         }
+      }
+      fclose(f);
+      return bs;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   struct AsyncFileRequest
+   {
+      bool mWrite;
+      std::string mPath;
+      ByteStorage* mData;
+      bool mSuccess;
+      Persistent<Function> mCallback;
+   };
+
+   ////////////////////////////////////////////////////////////////////////////////
+   /**
+    * Reads and writes files in the background. Finished requests are
+    * queued, their callbacks are called from ProcessAsyncFileRequests.
+    * Files are read completely on this thread. A mapped file would only
+    * be read when its pages are first touched, which happens on the
+    * main thread.
+    */
+   class AsyncFileThread : public OpenThreads::Thread
+   {
+   public:
+
+      AsyncFileThread()
+         : mQuit(false)
+      {
+      }
+
+      void Push(AsyncFileRequest* req)
+      {
+         OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+         mRequests.push_back(req);
+         mRequestAvailable.signal();
+      }
+
+      // stop thread and return requests that were not started
+      void Quit(std::deque<AsyncFileRequest*>& remaining)
+      {
+         {
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+            mQuit = true;
+            mRequestAvailable.broadcast();
+         }
+         join();
+         remaining.swap(mRequests);
+      }
+
+      virtual void run()
+      {
+         while(true)
+         {
+            AsyncFileRequest* req;
+            {
+               OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+               while(mRequests.empty() && !mQuit)
+               {
+                  mRequestAvailable.wait(&mMutex);
+               }
+               if(mQuit)
+               {
+                  return;
+               }
+               req = mRequests.front();
+               mRequests.pop_front();
+            }
+
+            if(req->mWrite)
+            {
+               req->mSuccess = (mmap_write((char*)req->mPath.c_str(), req->mData->getData(), req->mData->getLength()) == 0);
+            }
+            else
+            {
+               req->mData = ReadFileToStorage(req->mPath);
+               req->mSuccess = (req->mData != NULL);
+            }
+            mFinished.Push(req);
+         }
+      }
+
+      dtEntity::ThreadSafeQueue<AsyncFileRequest*> mFinished;
+
+   private:
+
+      OpenThreads::Mutex mMutex;
+      OpenThreads::Condition mRequestAvailable;
+      std::deque<AsyncFileRequest*> mRequests;
+      bool mQuit;
+   };
+
+   AsyncFileThread* s_asyncFileThread = NULL;
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void PushAsyncFileRequest(AsyncFileRequest* req)
+   {
+      if(s_asyncFileThread == NULL)
+      {
+         s_asyncFileThread = new AsyncFileThread();
+         s_asyncFileThread->start();
+      }
+      s_asyncFileThread->Push(req);
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void DeleteAsyncFileRequest(AsyncFileRequest* req)
+   {
+      delete req->mData;
+      req->mCallback.Dispose();
+      delete req;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   unsigned int ProcessAsyncFileRequests()
+   {
+      if(s_asyncFileThread == NULL)
+      {
+         return 0;
+      }
+
+      unsigned int count = 0;
+      while(!s_asyncFileThread->mFinished.Empty())
+      {
+         AsyncFileRequest* req = s_asyncFileThread->mFinished.Pop();
+
+         HandleScope scope;
+         Handle<Context> context = req->mCallback->CreationContext();
+         Context::Scope context_scope(context);
+
+         Handle<Value> arg;
+         if(req->mWrite)
+         {
+            arg = JS_BOOL(req->mSuccess);
+         }
+         else if(req->mSuccess)
+         {
+            // buffer takes ownership of file contents
+            arg = BYTESTORAGE_TO_JS(context, req->mData);
+            req->mData = NULL;
+         }
+         else
+         {
+            arg = Null();
+         }
+
+         TryCatch try_catch;
+         req->mCallback->Call(context->Global(), 1, &arg);
+         if(try_catch.HasCaught())
+         {
+            ReportException(&try_catch);
+         }
+         DeleteAsyncFileRequest(req);
+         ++count;
+      }
+      return count;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void ShutdownAsyncFileIO()
+   {
+      if(s_asyncFileThread == NULL)
+      {
+         return;
+      }
+      std::deque<AsyncFileRequest*> remaining;
+      s_asyncFileThread->Quit(remaining);
+      for(std::deque<AsyncFileRequest*>::iterator i = remaining.begin(); i != remaining.end(); ++i)
+      {
+         DeleteAsyncFileRequest(*i);
+      }
+      while(!s_asyncFileThread->mFinished.Empty())
+      {
+         DeleteAsyncFileRequest(s_asyncFileThread->mFinished.Pop());
+      }
+      delete s_asyncFileThread;
+      s_asyncFileThread = NULL;
+   }
+
    ////////////////////////////////////////////////////////////////////////////////
    JS_METHOD(_file)
    {
@@ -59,16 +277,7 @@ namespace dtEntityWrappers
        return JS_ERROR("File already opened");
      }
 
-     FILE * f;
-     std::string abspath = dtEntity::GetSystemInterface()->FindDataFile(*name);
-     if(abspath == "") 
-     {
-        f = fopen(*name, *mode);
-     }
-     else
-     {
-        f = fopen(abspath.c_str(), *mode);
-     }
+     FILE * f = fopen(ResolvePath(*name).c_str(), *mode);
      if (!f) {
        return JS_ERROR("Cannot open file");
      }
@@ -93,24 +302,86 @@ namespace dtEntityWrappers
        count = args[0]->IntegerValue();
      }
 
-     std::string data;
-     size_t size = 0;
-     if (count == 0) { /* all */
+     long pos = ftell(f);
+     if (count == 0 && (pos < 0 || fseek(f, 0, SEEK_END) != 0)) {
+       /* stream without known size, read in chunks */
+       std::string data;
+       char buf[4096];
        size_t tmp;
-       char * buf = new char[1024];
-       do {
-         tmp = fread(buf, sizeof(char), sizeof(buf), f);
-         size += tmp;
-         data.insert(data.length(), buf, tmp);
-       } while (tmp == sizeof(buf));
-       delete[] buf;
-     } else {
-       char * tmp = new char[count];
-       size = fread(tmp, sizeof(char), count, f);
-       data.insert(0, tmp, size);
-       delete[] tmp;
+       while ((tmp = fread(buf, sizeof(char), sizeof(buf), f)) > 0) {
+         data.append(buf, tmp);
+       }
+       return JS_BUFFER(args.This()->CreationContext(), (char *) data.data(), data.size());
+     }
+
+     if (count == 0) { /* rest of file */
+       count = ftell(f) - pos;
+       fseek(f, pos, SEEK_SET);
+     }
+
+     /* read directly into buffer storage */
+     ByteStorage * bs = new ByteStorage(count);
+     size_t size = fread(bs->getData(), sizeof(char), count, f);
+     if (size < count) {
+       ByteStorage * view = new ByteStorage(bs, 0, size);
+       delete bs;
+       bs = view;
      }
-     return JS_BUFFER(args.This()->CreationContext(), (char *) data.data(), size);
+     return BYTESTORAGE_TO_JS(args.This()->CreationContext(), bs);
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   JS_METHOD(_map) {
+      v8::String::Utf8Value name(LOAD_VALUE(0));
+      ByteStorage * bs = ByteStorage::mapFile(ResolvePath(*name).c_str());
+      if (!bs) {
+         return JS_ERROR("Cannot map file");
+      }
+      return BYTESTORAGE_TO_JS(args.This()->CreationContext(), bs);
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   JS_METHOD(_readasync) {
+      if (args.Length() < 1 || !args[0]->IsFunction()) {
+         return JS_TYPE_ERROR("Bad arguments. Use 'file.readAsync(callback)'");
+      }
+      v8::String::Utf8Value name(LOAD_VALUE(0));
+
+      AsyncFileRequest* req = new AsyncFileRequest();
+      req->mWrite = false;
+      req->mPath = ResolvePath(*name);
+      req->mData = NULL;
+      req->mSuccess = false;
+      req->mCallback = Persistent<Function>::New(Handle<Function>::Cast(args[0]));
+      PushAsyncFileRequest(req);
+      return args.This();
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   JS_METHOD(_writeasync) {
+      if (args.Length() < 2 || !args[1]->IsFunction()) {
+         return JS_TYPE_ERROR("Bad arguments. Use 'file.writeAsync(data, callback)'");
+      }
+      v8::String::Utf8Value name(LOAD_VALUE(0));
+
+      ByteStorage * bs;
+      if (IS_BUFFER(args.This()->CreationContext(), args[0])) {
+         /* view keeps buffer contents alive until write is finished */
+         ByteStorage * src = JS_TO_BYTESTORAGE(args[0]);
+         bs = new ByteStorage(src, 0, src->getLength());
+      } else {
+         v8::String::Utf8Value data(args[0]);
+         bs = new ByteStorage(*data, data.length());
+      }
+
+      AsyncFileRequest* req = new AsyncFileRequest();
+      req->mWrite = true;
+      req->mPath = ResolvePath(*name);
+      req->mData = bs;
+      req->mSuccess = false;
+      req->mCallback = Persistent<Function>::New(Handle<Function>::Cast(args[1]));
+      PushAsyncFileRequest(req);
+      return args.This();
    }
 
    ////////////////////////////////////////////////////////////////////////////////
@@ -206,12 +477,13 @@ namespace dtEntityWrappers
 
 	////////////////////////////////////////////////////////////////////////////////
 	v8::Handle<v8::Value> _copy(char * name1, char * name2) {
-		size_t size = 0;
+		size_t size = (size_t) -1;
 		void * data = mmap_read(name1, &size);
-		if (data == NULL) { return JS_ERROR("Cannot open source file"); }
+		/* empty files are not mapped */
+		if (data == NULL && size != 0) { return JS_ERROR("Cannot open source file"); }
 
 		int result = mmap_write(name2, data, size);
-		mmap_free((char *)data, size);
+		if (data != NULL) { mmap_free((char *)data, size); }
 
 		if (result == -1) { return JS_ERROR("Cannot open target file"); }
 		return JS_BOOL(true);
@@ -302,6 +574,9 @@ namespace dtEntityWrappers
      pt->Set("copy", v8::FunctionTemplate::New(_copyfile));
      pt->Set("stat", v8::FunctionTemplate::New(_stat));
      pt->Set("isFile", v8::FunctionTemplate::New(_isfile));
+     pt->Set("map", v8::FunctionTemplate::New(_map));
+     pt->Set("readAsync", v8::FunctionTemplate::New(_readasync));
+     pt->Set("writeAsync", v8::FunctionTemplate::New(_writeasync));
 
      s_file = v8::Persistent<v8::Function>::New(ft->GetFunction());
      return ft->GetFunction();
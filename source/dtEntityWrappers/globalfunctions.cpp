@@ -144,6 +144,97 @@ namespace dtEntityWrappers
       return Undefined();
    }
 
+   ////////////////////////////////////////////////////////////////////////////////
+   Handle<Value> SetProfilingCategories(const Arguments& args)
+   {
+      if(args.Length() != 1)
+      {
+         return ThrowError("usage: setProfilingCategories(string categories)");
+      }
+      unsigned int categories;
+      if(!CProfileManager::Parse_Categories(ToStdString(args[0]), categories))
+      {
+         return ThrowError("Unknown profiling category, use messages, systems, scripts, io, lookups or all");
+      }
+      CProfileManager::Set_Enabled_Categories(categories);
+      return Undefined();
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   Handle<Value> GetProfilingCategories(const Arguments& args)
+   {
+      static const char* names[] = { "messages", "systems", "scripts", "io", "lookups" };
+      HandleScope scope;
+      Handle<Array> arr = Array::New();
+      unsigned int categories = CProfileManager::Get_Enabled_Categories();
+      unsigned int index = 0;
+      for(unsigned int i = 0; i < 5; ++i)
+      {
+         if((categories & (1u << i)) != 0)
+         {
+            arr->Set(Integer::New(index++), String::New(names[i]));
+         }
+      }
+      return scope.Close(arr);
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   Handle<Value> StartTraceCapture(const Arguments& args)
+   {
+      if(args.Length() > 0 && args[0]->IsUint32())
+      {
+         CProfileManager::Start_Capture(args[0]->Uint32Value());
+      }
+      else
+      {
+         CProfileManager::Start_Capture();
+      }
+      return Undefined();
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   Handle<Value> StopTraceCapture(const Arguments& args)
+   {
+      CProfileManager::Stop_Capture();
+      return Undefined();
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   Handle<Value> WriteTraceCapture(const Arguments& args)
+   {
+      if(args.Length() != 1)
+      {
+         return ThrowError("usage: writeTraceCapture(string path)");
+      }
+      return Boolean::New(CProfileManager::Write_Capture(ToStdString(args[0])));
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   Handle<Value> RegisterUpdate(const Arguments& args)
+   {
+      if(args.Length() != 2 || !args[0]->IsUint32() || !args[1]->IsFunction())
+      {
+         return ThrowError("usage: registerUpdate(int entityId, function(dt, time, clocktime, entityId))");
+      }
+      GetScriptSystem()->AddUpdateFunction(args[0]->Uint32Value(), Handle<Function>::Cast(args[1]));
+      return Undefined();
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   Handle<Value> UnregisterUpdate(const Arguments& args)
+   {
+      if(args.Length() < 1 || !args[0]->IsUint32())
+      {
+         return ThrowError("usage: unregisterUpdate(int entityId, [function])");
+      }
+      Handle<Function> func;
+      if(args.Length() > 1 && args[1]->IsFunction())
+      {
+         func = Handle<Function>::Cast(args[1]);
+      }
+      return Boolean::New(GetScriptSystem()->RemoveUpdateFunction(args[0]->Uint32Value(), func));
+   }
+
    ////////////////////////////////////////////////////////////////////////////////
    Handle<Value> SID(const Arguments& args)
    {
@@ -172,5 +263,12 @@ namespace dtEntityWrappers
       context->Global()->Set(String::New("getStringFromSid"), FunctionTemplate::New(GetStringFromSID)->GetFunction());
       context->Global()->Set(String::New("startProfile"), FunctionTemplate::New(StartProfile)->GetFunction());
       context->Global()->Set(String::New("stopProfile"), FunctionTemplate::New(StopProfile)->GetFunction());
+      context->Global()->Set(String::New("setProfilingCategories"), FunctionTemplate::New(SetProfilingCategories)->GetFunction());
+      context->Global()->Set(String::New("getProfilingCategories"), FunctionTemplate::New(GetProfilingCategories)->GetFunction());
+      context->Global()->Set(String::New("startTraceCapture"), FunctionTemplate::New(StartTraceCapture)->GetFunction());
+      context->Global()->Set(String::New("stopTraceCapture"), FunctionTemplate::New(StopTraceCapture)->GetFunction());
+      context->Global()->Set(String::New("writeTraceCapture"), FunctionTemplate::New(WriteTraceCapture)->GetFunction());
+      context->Global()->Set(String::New("registerUpdate"), FunctionTemplate::New(RegisterUpdate)->GetFunction());
+      context->Global()->Set(String::New("unregisterUpdate"), FunctionTemplate::New(UnregisterUpdate)->GetFunction());
    }
 }
@@ -69,6 +69,37 @@ namespace dtEntityWrappers
       return Undefined();
    }
 
+   ////////////////////////////////////////////////////////////////////////////////
+   Handle<Value> LogSetLogLevel(const Arguments& args)
+   {
+      std::string level = ToStdString(args[0]);
+      dtEntity::LogLevel::e lvl;
+      if(level == "DEBUG") lvl = dtEntity::LogLevel::LVL_DEBUG;
+      else if(level == "INFO") lvl = dtEntity::LogLevel::LVL_INFO;
+      else if(level == "WARNING") lvl = dtEntity::LogLevel::LVL_WARNING;
+      else if(level == "ERROR") lvl = dtEntity::LogLevel::LVL_ERROR;
+      else if(level == "ALWAYS") lvl = dtEntity::LogLevel::LVL_ALWAYS;
+      else
+      {
+         return ThrowError("Usage: setLogLevel(DEBUG|INFO|WARNING|ERROR|ALWAYS)");
+      }
+      dtEntity::LogManager::GetInstance().SetLogLevel(lvl);
+      return Undefined();
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   Handle<Value> LogGetLogLevel(const Arguments& args)
+   {
+      switch(dtEntity::LogManager::GetInstance().GetLogLevel())
+      {
+      case dtEntity::LogLevel::LVL_DEBUG:   return String::New("DEBUG");
+      case dtEntity::LogLevel::LVL_INFO:    return String::New("INFO");
+      case dtEntity::LogLevel::LVL_WARNING: return String::New("WARNING");
+      case dtEntity::LogLevel::LVL_ERROR:   return String::New("ERROR");
+      default:                              return String::New("ALWAYS");
+      }
+   }
+
    ////////////////////////////////////////////////////////////////////////////////
    class LogListenerHolder
          : public dtEntity::LogListener
@@ -225,6 +256,8 @@ namespace dtEntityWrappers
         proto->Set("warning", FunctionTemplate::New(LogWarning));
         proto->Set("addLogListener", FunctionTemplate::New(LogAddListener));
         proto->Set("processLogListeners", FunctionTemplate::New(LogProcessListeners));
+        proto->Set("setLogLevel", FunctionTemplate::New(LogSetLogLevel));
+        proto->Set("getLogLevel", FunctionTemplate::New(LogGetLogLevel));
         GetScriptSystem()->SetTemplateBySID(s_loggerWrapper, templt);
       }
       Local<Object> instance = templt->GetFunction()->NewInstance();
@@ -31,10 +31,17 @@ namespace dtEntityWrappers
    void RegisterMessageTypes(dtEntity::MessageFactory& em)
    {    
       em.RegisterMessageType<ExecuteScriptMessage>(ExecuteScriptMessage::TYPE);
+      em.RegisterMessageType<WorkerMessage>(WorkerMessage::TYPE);
    }
 
    const dtEntity::MessageType ExecuteScriptMessage::TYPE(dtEntity::SID("ExecuteScriptMessage"));
    const dtEntity::StringId ExecuteScriptMessage::PathId(dtEntity::SID("Path"));
    const dtEntity::StringId ExecuteScriptMessage::IncludeOnceId(dtEntity::SID("IncludeOnce"));
+
+   const dtEntity::MessageType WorkerMessage::TYPE(dtEntity::SID("WorkerMessage"));
+   const dtEntity::StringId WorkerMessage::ModuleId(dtEntity::SID("Module"));
+   const dtEntity::StringId WorkerMessage::JobIdId(dtEntity::SID("JobId"));
+   const dtEntity::StringId WorkerMessage::DataId(dtEntity::SID("Data"));
+   const dtEntity::StringId WorkerMessage::TransferIdId(dtEntity::SID("TransferId"));
   
 }
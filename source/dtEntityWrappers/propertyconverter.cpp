@@ -30,6 +30,117 @@ using namespace v8;
 namespace dtEntityWrappers
 {
 
+   ////////////////////////////////////////////////////////////////////////////////
+   unsigned int GetNumPackedValues(dtEntity::DataType::e dtype)
+   {
+      switch(dtype)
+      {
+      case DataType::BOOL:
+      case DataType::DOUBLE:
+      case DataType::FLOAT:
+      case DataType::INT:
+      case DataType::UINT:   return 1;
+      case DataType::VEC2:
+      case DataType::VEC2D:  return 2;
+      case DataType::VEC3:
+      case DataType::VEC3D:  return 3;
+      case DataType::VEC4:
+      case DataType::VEC4D:
+      case DataType::QUAT:   return 4;
+      case DataType::MATRIX: return 16;
+      default:               return 0;
+      }
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void PackProperty(const dtEntity::Property& prop, double* out)
+   {
+      switch(prop.GetDataType())
+      {
+      case DataType::BOOL:   out[0] = prop.BoolValue() ? 1 : 0; break;
+      case DataType::DOUBLE: out[0] = prop.DoubleValue(); break;
+      case DataType::FLOAT:  out[0] = prop.FloatValue(); break;
+      case DataType::INT:    out[0] = prop.IntValue(); break;
+      case DataType::UINT:   out[0] = prop.UIntValue(); break;
+      case DataType::VEC2:
+      {
+         Vec2f v = prop.Vec2Value();
+         out[0] = v[0]; out[1] = v[1];
+         break;
+      }
+      case DataType::VEC2D:
+      {
+         Vec2d v = prop.Vec2dValue();
+         out[0] = v[0]; out[1] = v[1];
+         break;
+      }
+      case DataType::VEC3:
+      {
+         Vec3f v = prop.Vec3Value();
+         out[0] = v[0]; out[1] = v[1]; out[2] = v[2];
+         break;
+      }
+      case DataType::VEC3D:
+      {
+         Vec3d v = prop.Vec3dValue();
+         out[0] = v[0]; out[1] = v[1]; out[2] = v[2];
+         break;
+      }
+      case DataType::VEC4:
+      {
+         Vec4f v = prop.Vec4Value();
+         out[0] = v[0]; out[1] = v[1]; out[2] = v[2]; out[3] = v[3];
+         break;
+      }
+      case DataType::VEC4D:
+      {
+         Vec4d v = prop.Vec4dValue();
+         out[0] = v[0]; out[1] = v[1]; out[2] = v[2]; out[3] = v[3];
+         break;
+      }
+      case DataType::QUAT:
+      {
+         Quat v = prop.QuatValue();
+         out[0] = v[0]; out[1] = v[1]; out[2] = v[2]; out[3] = v[3];
+         break;
+      }
+      case DataType::MATRIX:
+      {
+         Matrix m = prop.MatrixValue();
+         for(unsigned int i = 0; i < 16; ++i)
+         {
+            out[i] = m(i / 4, i % 4);
+         }
+         break;
+      }
+      default:
+         assert(false && "Property type cannot be packed!");
+      }
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void UnpackProperty(const double* in, dtEntity::Property& prop)
+   {
+      switch(prop.GetDataType())
+      {
+      case DataType::BOOL:   prop.SetBool(in[0] != 0); break;
+      case DataType::DOUBLE: prop.SetDouble(in[0]); break;
+      case DataType::FLOAT:  prop.SetFloat(static_cast<float>(in[0])); break;
+      case DataType::INT:    prop.SetInt(static_cast<int>(in[0])); break;
+      case DataType::UINT:   prop.SetUInt(static_cast<unsigned int>(in[0])); break;
+      case DataType::VEC2:   prop.SetVec2(Vec2f(in[0], in[1])); break;
+      case DataType::VEC2D:  prop.SetVec2D(Vec2d(in[0], in[1])); break;
+      case DataType::VEC3:   prop.SetVec3(Vec3f(in[0], in[1], in[2])); break;
+      case DataType::VEC3D:  prop.SetVec3D(Vec3d(in[0], in[1], in[2])); break;
+      case DataType::VEC4:   prop.SetVec4(Vec4f(in[0], in[1], in[2], in[3])); break;
+      case DataType::VEC4D:  prop.SetVec4D(Vec4d(in[0], in[1], in[2], in[3])); break;
+      case DataType::QUAT:   prop.SetQuat(Quat(in[0], in[1], in[2], in[3])); break;
+      case DataType::MATRIX: prop.SetMatrix(Matrix(in)); break;
+      default:
+         assert(false && "Property type cannot be packed!");
+      }
+   }
+
    ////////////////////////////////////////////////////////////////////////////////
    v8::Handle<v8::Value> ConvertPropertyToValue(v8::Handle<v8::Context> context, const dtEntity::Property* prop)
    {
@@ -90,7 +201,40 @@ namespace dtEntityWrappers
    ////////////////////////////////////////////////////////////////////////////////
    dtEntity::Property* ConvertValueToProperty(v8::Handle<v8::Value> val)
    {
-      if(val->IsArray())
+      double* data;
+      unsigned int len;
+      if(GetFloat64ArrayData(val, data, len))
+      {
+         HandleScope scope;
+         std::string h = ToStdString(Handle<Object>::Cast(val)->Get(String::New("__TYPE_HINT")));
+         if(h == "V2" && len >= 2)
+         {
+            return new Vec2dProperty(data[0], data[1]);
+         }
+         else if(h == "V3" && len >= 3)
+         {
+            return new Vec3dProperty(data[0], data[1], data[2]);
+         }
+         else if(h == "V4" && len >= 4)
+         {
+            return new Vec4dProperty(data[0], data[1], data[2], data[3]);
+         }
+         else if(h == "QT" && len >= 4)
+         {
+            return new QuatProperty(data[0], data[1], data[2], data[3]);
+         }
+         else if(h == "MT" && len >= 16)
+         {
+            return new MatrixProperty(dtEntity::Matrix(data));
+         }
+         ArrayProperty* prop = new ArrayProperty();
+         for(unsigned int i = 0; i < len; ++i)
+         {
+            prop->Add(new DoubleProperty(data[i]));
+         }
+         return prop;
+      }
+      else if(val->IsArray())
       {
 
          HandleScope scope;
@@ -137,30 +281,8 @@ namespace dtEntityWrappers
             }
             else if(h == "MT")
             {
-               Handle<Array> a0 = Handle<Array>::Cast(arr->Get(0));
-               Handle<Array> a1 = Handle<Array>::Cast(arr->Get(1));
-               Handle<Array> a2 = Handle<Array>::Cast(arr->Get(2));
-               Handle<Array> a3 = Handle<Array>::Cast(arr->Get(3));
-
-               double p1 = a0->Get(0)->NumberValue();
-               double p2 = a0->Get(1)->NumberValue();
-               double p3 = a0->Get(2)->NumberValue();
-               double p4 = a0->Get(3)->NumberValue();
-               double p5 = a1->Get(0)->NumberValue();
-               double p6 = a1->Get(1)->NumberValue();
-               double p7 = a1->Get(2)->NumberValue();
-               double p8 = a1->Get(3)->NumberValue();
-               double p9 = a2->Get(0)->NumberValue();
-               double p10 = a2->Get(1)->NumberValue();
-               double p11 = a2->Get(2)->NumberValue();
-               double p12 = a2->Get(3)->NumberValue();
-               double p13 = a3->Get(0)->NumberValue();
-               double p14 = a3->Get(1)->NumberValue();
-               double p15 = a3->Get(2)->NumberValue();
-               double p16 = a3->Get(3)->NumberValue();
-               dtEntity::Matrix m(p1,p2,p3,p4,p5,p6,p7,p8,
-                             p9,p10,p11,p12,p13,p14,p15,p16);
-               return new MatrixProperty(m);
+               // array of four rows as created by WrapMatrix, or flat array of 16 values
+               return new MatrixProperty(UnwrapMatrix(arr));
             }
          }
          ArrayProperty* prop = new ArrayProperty();
@@ -369,6 +491,20 @@ namespace dtEntityWrappers
    {
       using namespace v8;
 
+      // write vector values directly into typed array storage
+      unsigned int numvalues = GetNumPackedValues(prop->GetDataType());
+      double* data;
+      unsigned int len;
+      if(numvalues > 1 && GetFloat64ArrayData(val, data, len))
+      {
+         if(len < numvalues)
+         {
+            return ThrowError("Typed array is too short for property value!");
+         }
+         PackProperty(*prop, data);
+         return True();
+      }
+
       switch(prop->GetDataType())
       {
       case dtEntity::DataType::ARRAY:
@@ -423,6 +559,24 @@ namespace dtEntityWrappers
          {
             return ThrowError("Property only accepts matrix values!");
          }
+         if(!IsNumberArray(arr, 16))
+         {
+            // array of four rows, as created by WrapMatrix
+            for(unsigned int i = 0; i < 4; ++i)
+            {
+               Handle<Value> rowval = arr->Get(i);
+               if(rowval.IsEmpty() || !rowval->IsObject())
+               {
+                  return ThrowError("Property only accepts matrix values!");
+               }
+               Handle<Object> row = Handle<Object>::Cast(rowval);
+               for(unsigned int j = 0; j < 4; ++j)
+               {
+                  row->Set(j, Number::New(mat(i, j)));
+               }
+            }
+            break;
+         }
          arr->Set( 0, Number::New(mat(0,0)));
          arr->Set( 1, Number::New(mat(0,1)));
          arr->Set( 2, Number::New(mat(0,2)));
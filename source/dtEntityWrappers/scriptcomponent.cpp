@@ -23,6 +23,7 @@
 
 #include <dtEntity/core.h>
 #include <dtEntity/commandmessages.h>
+#include <dtEntity/dtentity_config.h>
 #include <dtEntity/entity.h>
 #include <dtEntity/inputinterface.h>
 #include <dtEntity/stringid.h>
@@ -30,19 +31,31 @@
 #include <dtEntity/systemmessages.h>
 #include <dtEntityWrappers/componentwrapper.h>
 #include <dtEntityWrappers/entitymanagerwrapper.h>
+#include <dtEntityWrappers/file.h>
 #include <dtEntityWrappers/globalfunctions.h>
 #include <dtEntityWrappers/inputhandlerwrapper.h>
 #include <dtEntityWrappers/jsproperty.h>
 #include <dtEntityWrappers/messages.h>
 #include <dtEntityWrappers/screenwrapper.h>
 #include <dtEntityWrappers/v8helpers.h>
+#include <dtEntityWrappers/workerpool.h>
 #include <dtEntityWrappers/wrappers.h>
 #include <osgDB/FileUtils>
 #include <osgDB/FileNameUtils>
+#include <algorithm>
+#include <fstream>
 #include <iostream>
+#include <map>
 #include <sstream>
+#include <stdio.h>
+#include <stdlib.h>
 #include <v8.h>
 #include <v8-debug.h>
+#include <v8-profiler.h>
+
+#if DTENTITY_PROFILING_ENABLED
+#include <dtEntity/profile.h>
+#endif
 
 using namespace v8;
 
@@ -53,38 +66,194 @@ namespace dtEntityWrappers
    ////////////////////////////////////////////////////////////////////////////
    void GCStartCallback(GCType type, GCCallbackFlags flags)
    {
-      //LOG_DEBUG("V8 garbage collection started");
+      ScriptSystem* ss = static_cast<ScriptSystem*>(Isolate::GetCurrent()->GetData());
+      if(ss != NULL)
+      {
+         ss->OnGCStarted();
+      }
    };
 
    ////////////////////////////////////////////////////////////////////////////
    void GCEndCallback(GCType type, GCCallbackFlags flags)
    {
-      //LOG_DEBUG("V8 garbage collection ended");
-      /*HeapStatistics stats;
-      V8::GetHeapStatistics(&stats);
-      std::cout << "Total: " << stats.total_heap_size() << " Used: " << stats.used_heap_size() <<"\n";
-      */
+      ScriptSystem* ss = static_cast<ScriptSystem*>(Isolate::GetCurrent()->GetData());
+      if(ss != NULL)
+      {
+         ss->OnGCEnded();
+      }
+   };
+
+#if DTENTITY_PROFILING_ENABLED
+   static const dtEntity::StringId s_gcProfileName(dtEntity::SID("V8 GC"));
+
+   ////////////////////////////////////////////////////////////////////////////
+   // prints script profile after the native profile tree
+   class ScriptProfileReport : public CProfileReportSection
+   {
+   public:
+      ScriptProfileReport(ScriptSystem* ss) : mScriptSystem(ss) {}
+      virtual void Dump() { mScriptSystem->DumpScriptProfile(); }
+   private:
+      ScriptSystem* mScriptSystem;
    };
+#else
+   class ScriptProfileReport {};
+#endif
+
+   static const char* s_cpuProfileTitle = "ScriptSystem";
+
+   ////////////////////////////////////////////////////////////////////////////
+   static bool CompareSelfTime(const ScriptSystem::ScriptFunctionProfile& a, const ScriptSystem::ScriptFunctionProfile& b)
+   {
+      return a.mSelfTime > b.mSelfTime;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////
+   // Add times of node and its children to profile. Nodes are merged by function
+   // name, script and line. Stack holds indices of the entries of all
+   // ancestors, so total time of recursive calls is only counted once.
+   static void CollectProfileNode(const CpuProfileNode* node, ScriptSystem::ScriptProfile& profile,
+      std::map<std::string, unsigned int>& indices, std::vector<unsigned int>& stack)
+   {
+      std::string funcname = ToStdString(node->GetFunctionName());
+      std::string scriptname = ToStdString(node->GetScriptResourceName());
+      if(funcname.empty())
+      {
+         funcname = "(anonymous function)";
+      }
+
+      std::ostringstream key;
+      key << funcname << "|" << scriptname << "|" << node->GetLineNumber();
+
+      unsigned int index;
+      std::map<std::string, unsigned int>::iterator i = indices.find(key.str());
+      if(i == indices.end())
+      {
+         ScriptSystem::ScriptFunctionProfile entry;
+         entry.mFunctionName = funcname;
+         entry.mScriptName = scriptname;
+         entry.mLineNumber = node->GetLineNumber();
+         entry.mSelfTime = 0;
+         entry.mTotalTime = 0;
+         entry.mSamples = 0;
+         index = profile.size();
+         profile.push_back(entry);
+         indices[key.str()] = index;
+      }
+      else
+      {
+         index = i->second;
+      }
+
+      ScriptSystem::ScriptFunctionProfile& entry = profile[index];
+      entry.mSelfTime += node->GetSelfTime();
+      entry.mSamples += static_cast<unsigned int>(node->GetSelfSamplesCount());
+      if(std::find(stack.begin(), stack.end(), index) == stack.end())
+      {
+         entry.mTotalTime += node->GetTotalTime();
+      }
+
+      stack.push_back(index);
+      for(int j = 0; j < node->GetChildrenCount(); ++j)
+      {
+         CollectProfileNode(node->GetChild(j), profile, indices, stack);
+      }
+      stack.pop_back();
+   }
+
+   ////////////////////////////////////////////////////////////////////////////
+   // Calls all update functions in one go. Before each call the index is written
+   // to state[0], so dispatch can resume after a function has thrown.
+   static const char* s_dispatchSource =
+      "(function(funcs, ids, state, dt, time, clocktime) {\n"
+      "  for(var i = state[0]; i < funcs.length; ++i) {\n"
+      "    var f = funcs[i];\n"
+      "    if(f !== null) {\n"
+      "      state[0] = i;\n"
+      "      f(dt, time, clocktime, ids[i]);\n"
+      "    }\n"
+      "  }\n"
+      "  state[0] = funcs.length;\n"
+      "})";
+
+   ////////////////////////////////////////////////////////////////////////////
+   // FNV-1a, used for code cache file names and content checks
+   static unsigned int HashString(const std::string& str)
+   {
+      unsigned int hash = 2166136261u;
+      for(std::string::const_iterator i = str.begin(); i != str.end(); ++i)
+      {
+         hash = (hash ^ static_cast<unsigned char>(*i)) * 16777619u;
+      }
+      return hash;
+   }
 
    ////////////////////////////////////////////////////////////////////////////
    const dtEntity::StringId ScriptSystem::TYPE(dtEntity::SID("Script")); 
    const dtEntity::StringId ScriptSystem::ScriptsId(dtEntity::SID("Scripts"));
    const dtEntity::StringId ScriptSystem::DebugPortId(dtEntity::SID("DebugPort"));
    const dtEntity::StringId ScriptSystem::DebugEnabledId(dtEntity::SID("DebugEnabled"));
+   const dtEntity::StringId ScriptSystem::CodeCacheEnabledId(dtEntity::SID("CodeCacheEnabled"));
+   const dtEntity::StringId ScriptSystem::CodeCacheDirId(dtEntity::SID("CodeCacheDir"));
+   const dtEntity::StringId ScriptSystem::IdleGCEnabledId(dtEntity::SID("IdleGCEnabled"));
+   const dtEntity::StringId ScriptSystem::GCBudgetId(dtEntity::SID("GCBudget"));
+   const dtEntity::StringId ScriptSystem::HeapTotalSizeId(dtEntity::SID("HeapTotalSize"));
+   const dtEntity::StringId ScriptSystem::HeapUsedSizeId(dtEntity::SID("HeapUsedSize"));
+   const dtEntity::StringId ScriptSystem::GCCountId(dtEntity::SID("GCCount"));
+   const dtEntity::StringId ScriptSystem::LastGCPauseId(dtEntity::SID("LastGCPause"));
+   const dtEntity::StringId ScriptSystem::MaxGCPauseId(dtEntity::SID("MaxGCPause"));
+   const dtEntity::StringId ScriptSystem::NumWorkerThreadsId(dtEntity::SID("NumWorkerThreads"));
+   const dtEntity::StringId ScriptSystem::WorkerModulesId(dtEntity::SID("WorkerModules"));
+   const dtEntity::StringId ScriptSystem::CPUProfilingEnabledId(dtEntity::SID("CPUProfilingEnabled"));
 
    ScriptSystem::ScriptSystem(dtEntity::EntityManager& em)
       : dtEntity::EntitySystem(em)
       , mDebugPortOpened(false)
+      , mNumScriptsCompiled(0)
+      , mNumCodeCacheHits(0)
+      , mScriptCompileTime(0)
+      , mTotalGCPause(0)
+      , mTotalIdleGCTime(0)
+      , mGCStartTick(0)
+      , mGCProfiled(false)
+      , mCPUProfiling(false)
+      , mProfileReport(NULL)
+      , mNumUpdateFunctions(0)
+      , mUpdateFunctionsChanged(false)
+      , mLastComponentWrappers(NULL)
    {      
 
       V8::Initialize();
       Register(ScriptsId, &mScripts);
       Register(DebugPortId, &mDebugPort);
       Register(DebugEnabledId, &mDebugEnabled);
+      Register(CodeCacheEnabledId, &mCodeCacheEnabled);
+      Register(CodeCacheDirId, &mCodeCacheDir);
+      Register(IdleGCEnabledId, &mIdleGCEnabled);
+      Register(GCBudgetId, &mGCBudget);
+      Register(HeapTotalSizeId, &mHeapTotalSize);
+      Register(HeapUsedSizeId, &mHeapUsedSize);
+      Register(GCCountId, &mGCCount);
+      Register(LastGCPauseId, &mLastGCPause);
+      Register(MaxGCPauseId, &mMaxGCPause);
+      Register(NumWorkerThreadsId, &mNumWorkerThreads);
+      Register(WorkerModulesId, &mWorkerModules);
+      Register(CPUProfilingEnabledId, &mCPUProfilingEnabled);
       mDebugPort.Set(9222);
+      mCodeCacheEnabled.Set(false);
+      mIdleGCEnabled.Set(true);
+      mGCBudget.Set(0.002f);
+      mNumWorkerThreads.Set(2);
+
+      mWorkerPool = new WorkerPool(em);
+
+#if DTENTITY_PROFILING_ENABLED
+      mProfileReport = new ScriptProfileReport(this);
+      CProfileManager::Add_Report_Section(mProfileReport);
+#endif
       
-      //V8::AddGCPrologueCallback(GCStartCallback);
-      //V8::AddGCEpilogueCallback(GCEndCallback);
+      V8::AddGCPrologueCallback(GCStartCallback);
+      V8::AddGCEpilogueCallback(GCEndCallback);
 
       mSceneLoadedFunctor = dtEntity::MessageFunctor(this, &ScriptSystem::OnSceneLoaded);
       GetEntityManager().RegisterForMessages(dtEntity::SceneLoadedMessage::TYPE, mSceneLoadedFunctor, "ScriptSystem::OnSceneLoaded");
@@ -92,9 +261,17 @@ namespace dtEntityWrappers
       mTickFunctor = dtEntity::MessageFunctor(this, &ScriptSystem::Tick);
       em.RegisterForMessages(dtEntity::TickMessage::TYPE, mTickFunctor, "ScriptSystem::Tick");
 
+      mEndOfFrameFunctor = dtEntity::MessageFunctor(this, &ScriptSystem::OnEndOfFrame);
+      em.RegisterForMessages(dtEntity::EndOfFrameMessage::TYPE, mEndOfFrameFunctor,
+         dtEntity::FilterOptions::ORDER_LATE, "ScriptSystem::OnEndOfFrame");
+
       mLoadScriptFunctor = dtEntity::MessageFunctor(this, &ScriptSystem::OnLoadScript);
       em.RegisterForMessages(ExecuteScriptMessage::TYPE, mLoadScriptFunctor, "ScriptSystem::OnLoadScript");
 
+      mEntityRemovedFunctor = dtEntity::MessageFunctor(this, &ScriptSystem::OnEntityRemovedFromScene);
+      em.RegisterForMessages(dtEntity::EntityRemovedFromSceneMessage::TYPE, mEntityRemovedFunctor,
+         "ScriptSystem::OnEntityRemovedFromScene");
+
       HandleScope scope;
       mEntityIdString = Persistent<String>::New(String::New("__entityid__"));
       mPropertyNamesString = Persistent<String>::New(String::New("__propertynames__"));
@@ -103,26 +280,51 @@ namespace dtEntityWrappers
    ////////////////////////////////////////////////////////////////////////////
    ScriptSystem::~ScriptSystem()
    {
-      //V8::RemoveGCPrologueCallback(GCStartCallback);
-      //V8::RemoveGCEpilogueCallback(GCEndCallback);
+      if(mCPUProfiling)
+      {
+         StopCPUProfiling();
+      }
+#if DTENTITY_PROFILING_ENABLED
+      CProfileManager::Remove_Report_Section(mProfileReport);
+#endif
+      delete mProfileReport;
+
+      delete mWorkerPool;
+      ShutdownAsyncFileIO();
+
+      V8::RemoveGCPrologueCallback(GCStartCallback);
+      V8::RemoveGCEpilogueCallback(GCEndCallback);
+
+      ClearUpdateFunctions();
+      mDispatchFunction.Dispose();
+      mDispatchState.Dispose();
 
-      for(ComponentMap::iterator i = mComponentMap.begin(); i != mComponentMap.end(); ++i)
+      for(std::vector<ComponentWrappers*>::iterator i = mComponentWrappers.begin(); i != mComponentWrappers.end(); ++i)
       {
-         i->second.Dispose();
+         ComponentWrapperMap& wrappers = (*i)->mWrappers;
+         for(ComponentWrapperMap::iterator j = wrappers.begin(); j != wrappers.end(); ++j)
+         {
+            j->second.Dispose();
+         }
+         delete *i;
       }
-      mComponentMap.clear();
+      mComponentWrappers.clear();
+      mLastComponentWrappers = NULL;
 
       for(TemplateMap::iterator i = mTemplateMap.begin(); i != mTemplateMap.end(); ++i)
       {
          i->second.Dispose();
       }
       mTemplateMap.clear();
+      ClearMessageTemplates();
 
       mGlobalContext.Dispose();
 
       GetEntityManager().UnregisterForMessages(dtEntity::SceneLoadedMessage::TYPE, mSceneLoadedFunctor);
       GetEntityManager().UnregisterForMessages(dtEntity::TickMessage::TYPE, mTickFunctor);
+      GetEntityManager().UnregisterForMessages(dtEntity::EndOfFrameMessage::TYPE, mEndOfFrameFunctor);
       GetEntityManager().UnregisterForMessages(ExecuteScriptMessage::TYPE, mLoadScriptFunctor);
+      GetEntityManager().UnregisterForMessages(dtEntity::EntityRemovedFromSceneMessage::TYPE, mEntityRemovedFunctor);
 
    }
 
@@ -135,6 +337,17 @@ namespace dtEntityWrappers
          mGlobalContext.Dispose();
       }
 
+      // update functions and message templates belong to the old context
+      ClearUpdateFunctions();
+      ClearMessageTemplates();
+      if(!mDispatchFunction.IsEmpty())
+      {
+         mDispatchFunction.Dispose();
+         mDispatchFunction.Clear();
+         mDispatchState.Dispose();
+         mDispatchState.Clear();
+      }
+
       // create a template for the global object
       Handle<ObjectTemplate> global = ObjectTemplate::New();
 
@@ -146,6 +359,7 @@ namespace dtEntityWrappers
 
       RegisterGlobalFunctions(this, mGlobalContext);
       RegisterPropertyFunctions(this, mGlobalContext);
+      InitializeVectorWrappers(mGlobalContext);
 
       InitializeAllWrappers(GetEntityManager());
 
@@ -170,6 +384,10 @@ namespace dtEntityWrappers
       context->Global()->Set(String::New("Priority"), WrapPriorities());
       context->Global()->Set(String::New("Order"), WrapPriorities());
 
+      Handle<Script> dispatch = Script::Compile(String::New(s_dispatchSource), String::New("<update dispatch>"));
+      mDispatchFunction = Persistent<Function>::New(Handle<Function>::Cast(dispatch->Run()));
+      mDispatchState = Persistent<Array>::New(Array::New(1));
+
    }
 
    ////////////////////////////////////////////////////////////////////////////
@@ -185,6 +403,17 @@ namespace dtEntityWrappers
          v8::Debug::EnableAgent("DtScript", dbgport);
          LOG_DEBUG("Enabling JavaScript debugging on port " << dbgport);
       }
+
+      mWorkerPool->SetNumThreads(mNumWorkerThreads.Get());
+      dtEntity::PropertyArray modules = mWorkerModules.Get();
+      for(dtEntity::PropertyArray::const_iterator i = modules.begin(); i != modules.end(); ++i)
+      {
+         std::string module = (*i)->StringValue();
+         if(!mWorkerPool->HasModule(module) && !mWorkerPool->AddModule(module))
+         {
+            LOG_ERROR("Could not load worker module " + module);
+         }
+      }
    }
 
    ////////////////////////////////////////////////////////////////////////////
@@ -211,6 +440,9 @@ namespace dtEntityWrappers
          v8::HandleScope scope;
          ExecuteFile(script);
       }
+
+      LOG_INFO("Compiled " << mNumScriptsCompiled << " scripts in " << mScriptCompileTime * 1000
+               << " ms, " << mNumCodeCacheHits << " from code cache");
    }
 
    ////////////////////////////////////////////////////////////////////////////
@@ -264,7 +496,9 @@ namespace dtEntityWrappers
    ////////////////////////////////////////////////////////////////////////////
    void ScriptSystem::Tick(const dtEntity::Message& m)
    {
-      if(mGlobalTickFunction.IsEmpty())
+      ProcessAsyncFileRequests();
+
+      if(mGlobalTickFunction.IsEmpty() && mNumUpdateFunctions == 0)
       {
          return;
       }
@@ -281,13 +515,318 @@ namespace dtEntityWrappers
          Uint32::New(osg::Timer::instance()->time_m())
       };
 
-      Handle<Value> ret = mGlobalTickFunction->Call(mGlobalTickFunction, 3, argv);
+      if(!mGlobalTickFunction.IsEmpty())
+      {
+#if DTENTITY_PROFILING_ENABLED
+         PROFILE_CATEGORY_SCOPE(ProfileCategory::SCRIPTS, "ScriptSystem::GlobalTick");
+#endif
+         Handle<Value> ret = mGlobalTickFunction->Call(mGlobalTickFunction, 3, argv);
+
+         if(ret.IsEmpty())
+         {
+            ReportException(&try_catch);
+            try_catch.Reset();
+         }
+      }
+
+      if(mNumUpdateFunctions != 0)
+      {
+         CallUpdateFunctions(argv, try_catch);
+      }
+   }
+
+   ////////////////////////////////////////////////////////////////////////////
+   void ScriptSystem::CallUpdateFunctions(Handle<Value>* tickargs, TryCatch& try_catch)
+   {
+#if DTENTITY_PROFILING_ENABLED
+      PROFILE_CATEGORY_SCOPE(ProfileCategory::SCRIPTS, "ScriptSystem::UpdateFunctions");
+#endif
+      if(mUpdateFunctionsChanged)
+      {
+         RebuildUpdateFunctionArrays();
+      }
+
+      mDispatchState->Set(0, Integer::New(0));
+      Handle<Value> argv[6] = {
+         mUpdateFunctionArray, mUpdateEntityIdArray, mDispatchState,
+         tickargs[0], tickargs[1], tickargs[2]
+      };
 
-      if(ret.IsEmpty())
+      while(mDispatchFunction->Call(mDispatchFunction, 6, argv).IsEmpty())
       {
+         // script execution was terminated from outside, do not resume
+         if(V8::IsExecutionTerminating())
+         {
+            break;
+         }
+         // an update function has thrown, report and continue with the next one
          ReportException(&try_catch);
+         try_catch.Reset();
+         mDispatchState->Set(0, Integer::New(mDispatchState->Get(0)->Int32Value() + 1));
+      }
+   }
+
+   ////////////////////////////////////////////////////////////////////////////
+   void ScriptSystem::OnEntityRemovedFromScene(const dtEntity::Message& m)
+   {
+      if(mNumUpdateFunctions == 0)
+      {
+         return;
+      }
+      const dtEntity::EntityRemovedFromSceneMessage& msg =
+         static_cast<const dtEntity::EntityRemovedFromSceneMessage&>(m);
+
+      HandleScope scope;
+      Context::Scope context_scope(GetGlobalContext());
+      RemoveUpdateFunction(msg.GetAboutEntityId(), Handle<Function>());
+   }
+
+   ////////////////////////////////////////////////////////////////////////////
+   void ScriptSystem::AddUpdateFunction(dtEntity::EntityId id, Handle<Function> func)
+   {
+      UpdateFunction f;
+      f.mEntityId = id;
+      f.mFunction = Persistent<Function>::New(func);
+      mUpdateFunctions.push_back(f);
+      ++mNumUpdateFunctions;
+      mUpdateFunctionsChanged = true;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////
+   bool ScriptSystem::RemoveUpdateFunction(dtEntity::EntityId id, Handle<Function> func)
+   {
+      HandleScope scope;
+      unsigned int numinarray = mUpdateFunctionArray.IsEmpty() ? 0 : mUpdateFunctionArray->Length();
+      bool found = false;
+      for(unsigned int i = 0; i < mUpdateFunctions.size(); ++i)
+      {
+         UpdateFunction& f = mUpdateFunctions[i];
+         if(f.mFunction.IsEmpty() || f.mEntityId != id || (!func.IsEmpty() && !f.mFunction->StrictEquals(func)))
+         {
+            continue;
+         }
+         f.mFunction.Dispose();
+         f.mFunction.Clear();
+         --mNumUpdateFunctions;
+         found = true;
+
+         // entries are only erased on rebuild, so indices match those of the
+         // arrays. Clear entry to stop dispatch if we are inside of it
+         if(i < numinarray)
+         {
+            mUpdateFunctionArray->Set(i, Null());
+         }
+      }
+      if(found)
+      {
+         mUpdateFunctionsChanged = true;
+      }
+      return found;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////
+   void ScriptSystem::RebuildUpdateFunctionArrays()
+   {
+      HandleScope scope;
+
+      std::vector<UpdateFunction> remaining;
+      remaining.reserve(mNumUpdateFunctions);
+      for(std::vector<UpdateFunction>::iterator i = mUpdateFunctions.begin(); i != mUpdateFunctions.end(); ++i)
+      {
+         if(!i->mFunction.IsEmpty())
+         {
+            remaining.push_back(*i);
+         }
+      }
+      mUpdateFunctions.swap(remaining);
+
+      Handle<Array> funcs = Array::New(mUpdateFunctions.size());
+      Handle<Array> ids = Array::New(mUpdateFunctions.size());
+      for(unsigned int i = 0; i < mUpdateFunctions.size(); ++i)
+      {
+         funcs->Set(i, mUpdateFunctions[i].mFunction);
+         ids->Set(i, Uint32::New(mUpdateFunctions[i].mEntityId));
+      }
+
+      if(!mUpdateFunctionArray.IsEmpty())
+      {
+         mUpdateFunctionArray.Dispose();
+         mUpdateEntityIdArray.Dispose();
+      }
+      mUpdateFunctionArray = Persistent<Array>::New(funcs);
+      mUpdateEntityIdArray = Persistent<Array>::New(ids);
+      mUpdateFunctionsChanged = false;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////
+   void ScriptSystem::ClearUpdateFunctions()
+   {
+      for(std::vector<UpdateFunction>::iterator i = mUpdateFunctions.begin(); i != mUpdateFunctions.end(); ++i)
+      {
+         if(!i->mFunction.IsEmpty())
+         {
+            i->mFunction.Dispose();
+         }
+      }
+      mUpdateFunctions.clear();
+      mNumUpdateFunctions = 0;
+      mUpdateFunctionsChanged = false;
+
+      if(!mUpdateFunctionArray.IsEmpty())
+      {
+         mUpdateFunctionArray.Dispose();
+         mUpdateFunctionArray.Clear();
+         mUpdateEntityIdArray.Dispose();
+         mUpdateEntityIdArray.Clear();
+      }
+   }
+
+   ////////////////////////////////////////////////////////////////////////////
+   void ScriptSystem::OnEndOfFrame(const dtEntity::Message& m)
+   {
+      if(mIdleGCEnabled.Get() && mGCBudget.Get() > 0)
+      {
+         double idletime = mGCBudget.Get();
+         dtEntity::SystemInterface* iface = dtEntity::GetSystemInterface();
+         if(iface != NULL && iface->GetFrameTimeLeft() >= 0)
+         {
+            idletime = std::min(idletime, iface->GetFrameTimeLeft());
+         }
+         if(idletime > 0)
+         {
+            DoIdleGC(idletime);
+         }
       }
 
+      HeapStatistics stats;
+      V8::GetHeapStatistics(&stats);
+      mHeapTotalSize.Set(static_cast<double>(stats.total_heap_size()));
+      mHeapUsedSize.Set(static_cast<double>(stats.used_heap_size()));
+   }
+
+   ////////////////////////////////////////////////////////////////////////////
+   void ScriptSystem::DoIdleGC(double idletime)
+   {
+      osg::Timer* timer = osg::Timer::instance();
+      osg::Timer_t start = timer->tick();
+
+      // hint is the expected idle time in milliseconds, V8 scales
+      // the size of each incremental marking step by it
+      int hint = std::max(1, static_cast<int>(idletime * 1000));
+      double elapsed = 0;
+      bool done = false;
+      while(!done && elapsed < idletime)
+      {
+         done = V8::IdleNotification(hint);
+         elapsed = timer->delta_s(start, timer->tick());
+      }
+      mTotalIdleGCTime += elapsed;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////
+   void ScriptSystem::OnGCStarted()
+   {
+      mGCStartTick = osg::Timer::instance()->tick();
+#if DTENTITY_PROFILING_ENABLED
+      mGCProfiled = CProfileManager::Is_Enabled(ProfileCategory::SCRIPTS);
+      if(mGCProfiled)
+      {
+         CProfileManager::Start_Profile(s_gcProfileName);
+      }
+#endif
+   }
+
+   ////////////////////////////////////////////////////////////////////////////
+   void ScriptSystem::OnGCEnded()
+   {
+#if DTENTITY_PROFILING_ENABLED
+      if(mGCProfiled)
+      {
+         CProfileManager::Stop_Profile();
+         mGCProfiled = false;
+      }
+#endif
+      double pause = osg::Timer::instance()->delta_s(mGCStartTick, osg::Timer::instance()->tick());
+      mGCCount.Set(mGCCount.Get() + 1);
+      mLastGCPause.Set(pause);
+      mMaxGCPause.Set(std::max(mMaxGCPause.Get(), pause));
+      mTotalGCPause += pause;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////
+   void ScriptSystem::OnPropertyChanged(dtEntity::StringId propname, dtEntity::Property& prop)
+   {
+      if(propname == CPUProfilingEnabledId)
+      {
+         if(prop.BoolValue() && !mCPUProfiling)
+         {
+            StartCPUProfiling();
+         }
+         else if(!prop.BoolValue() && mCPUProfiling)
+         {
+            StopCPUProfiling();
+         }
+      }
+   }
+
+   ////////////////////////////////////////////////////////////////////////////
+   void ScriptSystem::StartCPUProfiling()
+   {
+      if(mCPUProfiling)
+      {
+         return;
+      }
+      HandleScope scope;
+      CpuProfiler::StartProfiling(String::New(s_cpuProfileTitle));
+      mCPUProfiling = true;
+      mCPUProfilingEnabled.Set(true);
+   }
+
+   ////////////////////////////////////////////////////////////////////////////
+   void ScriptSystem::StopCPUProfiling()
+   {
+      if(!mCPUProfiling)
+      {
+         return;
+      }
+      mCPUProfiling = false;
+      mCPUProfilingEnabled.Set(false);
+
+      HandleScope scope;
+      const CpuProfile* profile = CpuProfiler::StopProfiling(String::New(s_cpuProfileTitle));
+      mScriptProfile.clear();
+      if(profile == NULL)
+      {
+         return;
+      }
+
+      // skip root node, it only represents the profiling run
+      std::map<std::string, unsigned int> indices;
+      std::vector<unsigned int> stack;
+      const CpuProfileNode* root = profile->GetTopDownRoot();
+      for(int i = 0; i < root->GetChildrenCount(); ++i)
+      {
+         CollectProfileNode(root->GetChild(i), mScriptProfile, indices, stack);
+      }
+      std::sort(mScriptProfile.begin(), mScriptProfile.end(), CompareSelfTime);
+
+      const_cast<CpuProfile*>(profile)->Delete();
+   }
+
+   ////////////////////////////////////////////////////////////////////////////
+   void ScriptSystem::DumpScriptProfile() const
+   {
+      if(mScriptProfile.empty())
+      {
+         return;
+      }
+      printf("---------- Script CPU Profile ----------\n");
+      printf("   self ms   total ms  samples  function\n");
+      for(ScriptProfile::const_iterator i = mScriptProfile.begin(); i != mScriptProfile.end(); ++i)
+      {
+         printf("%10.3f %10.3f %8u  %s (%s:%d)\n", i->mSelfTime, i->mTotalTime, i->mSamples,
+            i->mFunctionName.c_str(), i->mScriptName.c_str(), i->mLineNumber);
+      }
    }
 
    ////////////////////////////////////////////////////////////////////////////////
@@ -302,10 +841,27 @@ namespace dtEntityWrappers
          return Handle<Script>();
       }
 
+      osg::Timer_t start = osg::Timer::instance()->tick();
+
       HandleScope handle_scope;
       Context::Scope context_scope(GetGlobalContext());
+      Handle<String> source = ToJSString(code);
+
+      // ScriptData does not own its bytes, the buffer has to outlive Compile
+      std::vector<char> scriptdatabuf;
+      ScriptData* scriptdata = NULL;
+      if(mCodeCacheEnabled.Get())
+      {
+         scriptdata = GetScriptData(path, code, source, scriptdatabuf);
+      }
+
       TryCatch try_catch;
-      Local<Script> compiled_script = Script::Compile(ToJSString(code), ToJSString(path));
+      ScriptOrigin origin(ToJSString(path));
+      Local<Script> compiled_script = Script::Compile(source, &origin, scriptdata);
+      delete scriptdata;
+
+      ++mNumScriptsCompiled;
+      mScriptCompileTime += osg::Timer::instance()->delta_s(start, osg::Timer::instance()->tick());
 
       if(try_catch.HasCaught())
       {
@@ -316,9 +872,111 @@ namespace dtEntityWrappers
       return handle_scope.Close(compiled_script);
    }
 
+   ////////////////////////////////////////////////////////////////////////////////
+   std::string ScriptSystem::GetCodeCacheDir() const
+   {
+      std::string dir = mCodeCacheDir.Get();
+      if(!dir.empty())
+      {
+         return dir;
+      }
+
+      // per user cache directory, data paths may be read only or shared
+#ifdef WIN32
+      const char* base = getenv("LOCALAPPDATA");
+      if(base != NULL)
+      {
+         return std::string(base) + "/dtEntity/ScriptCache";
+      }
+#else
+      const char* base = getenv("XDG_CACHE_HOME");
+      if(base != NULL && base[0] != '\0')
+      {
+         return std::string(base) + "/dtEntity/ScriptCache";
+      }
+      base = getenv("HOME");
+      if(base != NULL)
+      {
+         return std::string(base) + "/.cache/dtEntity/ScriptCache";
+      }
+#endif
+      return "";
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   ScriptData* ScriptSystem::GetScriptData(const std::string& path, const std::string& code,
+                                           Handle<String> source, std::vector<char>& data)
+   {
+      std::string cachedir = GetCodeCacheDir();
+      if(cachedir.empty())
+      {
+         return NULL;
+      }
+
+      if(!osgDB::fileExists(cachedir) && !osgDB::makeDirectory(cachedir))
+      {
+         // nothing to store pre-parse data to, skip the extra pre-parse pass
+         LOG_WARNING("Could not create script code cache directory " + cachedir);
+         return NULL;
+      }
+
+      std::ostringstream os;
+      os << cachedir << "/" << std::hex << HashString(path) << ".jscache";
+      std::string cachefile = os.str();
+
+      // pre-parse data format depends on V8 version
+      unsigned int header[3];
+      header[0] = HashString(V8::GetVersion());
+      header[1] = HashString(code);
+
+      std::ifstream in(cachefile.c_str(), std::ios::in | std::ios::binary);
+      if(in)
+      {
+         unsigned int stored[3];
+         in.read(reinterpret_cast<char*>(stored), sizeof(stored));
+         if(in && stored[0] == header[0] && stored[1] == header[1] && stored[2] > 0)
+         {
+            data.resize(stored[2]);
+            in.read(&data[0], data.size());
+            if(in)
+            {
+               ScriptData* scriptdata = ScriptData::New(&data[0], data.size());
+               if(!scriptdata->HasError())
+               {
+                  ++mNumCodeCacheHits;
+                  return scriptdata;
+               }
+               delete scriptdata;
+            }
+         }
+         in.close();
+      }
+
+      // cache miss: the pre-parse data is stored and also handed to this
+      // compile, so the source is pre-parsed only once
+      ScriptData* scriptdata = ScriptData::PreCompile(source);
+      if(scriptdata == NULL || scriptdata->HasError())
+      {
+         delete scriptdata;
+         return NULL;
+      }
+
+      header[2] = scriptdata->Length();
+      std::ofstream out(cachefile.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+      if(out)
+      {
+         out.write(reinterpret_cast<const char*>(header), sizeof(header));
+         out.write(scriptdata->Data(), scriptdata->Length());
+      }
+      return scriptdata;
+   }
+
    ////////////////////////////////////////////////////////////////////////////////
    Handle<Value> ScriptSystem::ExecuteJS(const std::string& code, const std::string& path)
    {
+#if DTENTITY_PROFILING_ENABLED
+      PROFILE_CATEGORY_SCOPE(ProfileCategory::SCRIPTS, "ScriptSystem::ExecuteJS");
+#endif
        // Init JavaScript context
       HandleScope handle_scope;
       Context::Scope context_scope(GetGlobalContext());
@@ -353,6 +1011,9 @@ namespace dtEntityWrappers
    ////////////////////////////////////////////////////////////////////////////////
    Local<Value> ScriptSystem::ExecuteFile(const std::string& path)
    {
+#if DTENTITY_PROFILING_ENABLED
+      PROFILE_CATEGORY_SCOPE(ProfileCategory::SCRIPTS, "ScriptSystem::ExecuteFile");
+#endif
       HandleScope handle_scope;
 
       Handle<Script> script = GetScriptFromFile(path);
@@ -445,6 +1106,34 @@ namespace dtEntityWrappers
       //v.Dispose();
    }
 
+   ////////////////////////////////////////////////////////////////////////////
+   ScriptSystem::ComponentWrappers* ScriptSystem::GetComponentWrappers(dtEntity::ComponentType ct, bool create) const
+   {
+      if(mLastComponentWrappers != NULL && mLastComponentWrappers->mComponentType == ct)
+      {
+         return mLastComponentWrappers;
+      }
+
+      for(std::vector<ComponentWrappers*>::const_iterator i = mComponentWrappers.begin(); i != mComponentWrappers.end(); ++i)
+      {
+         if((*i)->mComponentType == ct)
+         {
+            mLastComponentWrappers = *i;
+            return *i;
+         }
+      }
+
+      if(!create)
+      {
+         return NULL;
+      }
+      ComponentWrappers* wrappers = new ComponentWrappers();
+      wrappers->mComponentType = ct;
+      mComponentWrappers.push_back(wrappers);
+      mLastComponentWrappers = wrappers;
+      return wrappers;
+   }
+
    ////////////////////////////////////////////////////////////////////////////
    void ScriptSystem::AddToComponentMap(dtEntity::ComponentType ct, dtEntity::EntityId eid, v8::Handle<v8::Object> obj)
    {
@@ -452,14 +1141,19 @@ namespace dtEntityWrappers
       Persistent<Object> pobj = Persistent<Object>::New(obj);
       pobj.MakeWeak(this, &ComponentWrapperDestructor);
       V8::AdjustAmountOfExternalAllocatedMemory(sizeof(dtEntity::Component));
-      mComponentMap[std::make_pair(ct, eid)] = pobj;
+      GetComponentWrappers(ct, true)->mWrappers[eid] = pobj;
    }
 
    ////////////////////////////////////////////////////////////////////////////
    Handle<Object> ScriptSystem::GetFromComponentMap(dtEntity::ComponentType ct, dtEntity::EntityId eid) const
    {
-      ComponentMap::const_iterator it = mComponentMap.find(std::make_pair(ct, eid));
-      if(it == mComponentMap.end())
+      ComponentWrappers* wrappers = GetComponentWrappers(ct, false);
+      if(wrappers == NULL)
+      {
+         return Handle<Object>();
+      }
+      ComponentWrapperMap::const_iterator it = wrappers->mWrappers.find(eid);
+      if(it == wrappers->mWrappers.end())
       {
          return Handle<Object>();
       }
@@ -469,8 +1163,13 @@ namespace dtEntityWrappers
    ////////////////////////////////////////////////////////////////////////////
    bool ScriptSystem::RemoveFromComponentMap(dtEntity::ComponentType ct, dtEntity::EntityId eid)
    {
-      ComponentMap::iterator it = mComponentMap.find(std::make_pair(ct, eid));
-      if(it == mComponentMap.end())
+      ComponentWrappers* wrappers = GetComponentWrappers(ct, false);
+      if(wrappers == NULL)
+      {
+         return false;
+      }
+      ComponentWrapperMap::iterator it = wrappers->mWrappers.find(eid);
+      if(it == wrappers->mWrappers.end())
       {
          return false;
       }
@@ -480,7 +1179,7 @@ namespace dtEntityWrappers
       // invalidate component wrapper
       obj->SetInternalField(0, External::New(0));
       obj.Dispose();
-      mComponentMap.erase(it);
+      wrappers->mWrappers.erase(it);
       V8::AdjustAmountOfExternalAllocatedMemory(-(int)sizeof(dtEntity::Component));
       return true;
 
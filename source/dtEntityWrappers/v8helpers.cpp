@@ -25,6 +25,8 @@
 #include <dtEntity/core.h>
 #include <dtEntity/log.h>
 #include <dtEntity/systeminterface.h>
+#include <algorithm>
+#include <cstring>
 #include <sstream>
 #include <iostream>
 #include <osgDB/FileUtils>
@@ -139,69 +141,159 @@ namespace dtEntityWrappers
    }
 
    ////////////////////////////////////////////////////////////////////////////////
-   v8::Handle<v8::Value> WrapVec2(const dtEntity::Vec2d& v)
+   // Vectors, quats and matrices are handed to scripts as Float64Arrays.
+   // The type hint lives on a shared prototype per type instead of being
+   // set on each instance.
+   enum VectorType
+   {
+      VT_VEC2,
+      VT_VEC3,
+      VT_VEC4,
+      VT_QUAT,
+      VT_MATRIX,
+      VT_NUM_TYPES
+   };
+
+   static const char* s_typeHints[VT_NUM_TYPES] = { "V2", "V3", "V4", "QT", "MT" };
+   Persistent<Function> s_float64ArrayConstructor;
+   Persistent<Object> s_vectorPrototypes[VT_NUM_TYPES];
+   // vector prototypes belong to the main script isolate, other
+   // isolates (script workers) get plain arrays
+   Isolate* s_vectorIsolate = NULL;
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void InitializeVectorWrappers(v8::Handle<v8::Context> context)
    {
       HandleScope scope;
-      Handle<Array> arr = Array::New(2);
-      arr->Set(0, Number::New(v[0]));
-      arr->Set(1, Number::New(v[1]));
-      arr->Set(String::New("__TYPE_HINT"), String::New("V2"));
-      return scope.Close(arr);
+      Context::Scope context_scope(context);
+
+      if(!s_float64ArrayConstructor.IsEmpty())
+      {
+         s_float64ArrayConstructor.Dispose();
+         s_float64ArrayConstructor.Clear();
+         for(unsigned int i = 0; i < VT_NUM_TYPES; ++i)
+         {
+            s_vectorPrototypes[i].Dispose();
+            s_vectorPrototypes[i].Clear();
+         }
+      }
+
+      Handle<Value> ctor = context->Global()->Get(String::New("Float64Array"));
+      if(ctor.IsEmpty() || !ctor->IsFunction())
+      {
+         LOG_WARNING("No typed array support in script engine, vectors are wrapped as plain arrays");
+         return;
+      }
+
+      Handle<Function> f = Handle<Function>::Cast(ctor);
+      Handle<Value> baseproto = f->Get(String::New("prototype"));
+      Handle<String> hintstr = String::New("__TYPE_HINT");
+      for(unsigned int i = 0; i < VT_NUM_TYPES; ++i)
+      {
+         Handle<Object> proto = Object::New();
+         proto->SetPrototype(baseproto);
+         proto->Set(hintstr, String::New(s_typeHints[i]), DontEnum);
+         s_vectorPrototypes[i] = Persistent<Object>::New(proto);
+      }
+      s_float64ArrayConstructor = Persistent<Function>::New(f);
+      s_vectorIsolate = Isolate::GetCurrent();
    }
 
    ////////////////////////////////////////////////////////////////////////////////
-   v8::Handle<v8::Value> WrapVec3(const dtEntity::Vec3d& v)
+   bool GetFloat64ArrayData(v8::Handle<v8::Value> v, double*& data, unsigned int& length)
+   {
+      if(v.IsEmpty() || !v->IsObject())
+      {
+         return false;
+      }
+      Handle<Object> obj = Handle<Object>::Cast(v);
+      if(!obj->HasIndexedPropertiesInExternalArrayData() ||
+         obj->GetIndexedPropertiesExternalArrayDataType() != kExternalDoubleArray)
+      {
+         return false;
+      }
+      data = static_cast<double*>(obj->GetIndexedPropertiesExternalArrayData());
+      length = obj->GetIndexedPropertiesExternalArrayDataLength();
+      return true;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   // creates typed array of given type and returns pointer to its storage in data.
+   // Returns a plain array of given length with type hint if no typed arrays are available
+   Handle<Object> NewVector(VectorType type, unsigned int length, double*& data)
    {
       HandleScope scope;
-      Handle<Array> arr = Array::New(3);
-      arr->Set(0, Number::New(v[0]));
-      arr->Set(1, Number::New(v[1]));
-      arr->Set(2, Number::New(v[2]));
-      arr->Set(String::New("__TYPE_HINT"), String::New("V3"));
+      if(s_float64ArrayConstructor.IsEmpty() || Isolate::GetCurrent() != s_vectorIsolate)
+      {
+         data = NULL;
+         Handle<Array> arr = Array::New(length);
+         arr->Set(String::New("__TYPE_HINT"), String::New(s_typeHints[type]));
+         return scope.Close(arr);
+      }
+      Handle<Value> argv[1] = { Integer::New(length) };
+      Handle<Object> arr = s_float64ArrayConstructor->NewInstance(1, argv);
+      arr->SetPrototype(s_vectorPrototypes[type]);
+      data = static_cast<double*>(arr->GetIndexedPropertiesExternalArrayData());
       return scope.Close(arr);
    }
 
    ////////////////////////////////////////////////////////////////////////////////
-   v8::Handle<v8::Value> WrapVec4(const dtEntity::Vec4d& v)
+   Handle<Object> NewVector(VectorType type, const double* values, unsigned int length)
    {
       HandleScope scope;
-      Handle<Array> arr = Array::New(4);
-      arr->Set(0, Number::New(v[0]));
-      arr->Set(1, Number::New(v[1]));
-      arr->Set(2, Number::New(v[2]));
-      arr->Set(3, Number::New(v[3]));
-      arr->Set(String::New("__TYPE_HINT"), String::New("V4"));
+      double* data;
+      Handle<Object> arr = NewVector(type, length, data);
+      if(data != NULL)
+      {
+         memcpy(data, values, length * sizeof(double));
+      }
+      else
+      {
+         for(unsigned int i = 0; i < length; ++i)
+         {
+            arr->Set(i, Number::New(values[i]));
+         }
+      }
       return scope.Close(arr);
    }
 
+   ////////////////////////////////////////////////////////////////////////////////
+   v8::Handle<v8::Value> WrapVec2(const dtEntity::Vec2d& v)
+   {
+      return NewVector(VT_VEC2, v.ptr(), 2);
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   v8::Handle<v8::Value> WrapVec3(const dtEntity::Vec3d& v)
+   {
+      return NewVector(VT_VEC3, v.ptr(), 3);
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   v8::Handle<v8::Value> WrapVec4(const dtEntity::Vec4d& v)
+   {
+      return NewVector(VT_VEC4, v.ptr(), 4);
+   }
+
    ////////////////////////////////////////////////////////////////////////////////
    v8::Handle<v8::Value> WrapQuat(const dtEntity::Quat& v)
    {
-      HandleScope scope;
-      Handle<Array> arr = Array::New(4);
-      arr->Set(0, Number::New(v[0]));
-      arr->Set(1, Number::New(v[1]));
-      arr->Set(2, Number::New(v[2]));
-      arr->Set(3, Number::New(v[3]));
-      arr->Set(String::New("__TYPE_HINT"), String::New("QT"));
-      return scope.Close(arr);
+      double vals[4] = { v[0], v[1], v[2], v[3] };
+      return NewVector(VT_QUAT, vals, 4);
    }
 
    ////////////////////////////////////////////////////////////////////////////////
+   // matrices are arrays of four rows, m[i][j], each row is a vector of 4 values
    v8::Handle<v8::Value> WrapMatrix(const dtEntity::Matrix& v)
    {
       HandleScope scope;
       Handle<Array> arr = Array::New(4);
       for(unsigned int i = 0; i < 4; ++i)
       {
-         Handle<Array> inner = Array::New(4);
-         inner->Set(0, Number::New(v(i, 0)));
-         inner->Set(1, Number::New(v(i, 1)));
-         inner->Set(2, Number::New(v(i, 2)));
-         inner->Set(3, Number::New(v(i, 3)));
-         arr->Set(i, inner);
+         double row[4] = { v(i, 0), v(i, 1), v(i, 2), v(i, 3) };
+         arr->Set(i, NewVector(VT_VEC4, row, 4));
       }
-      arr->Set(String::New("__TYPE_HINT"), String::New("MT"));
+      arr->Set(String::New("__TYPE_HINT"), String::New(s_typeHints[VT_MATRIX]));
       return scope.Close(arr);
    }
 
@@ -225,100 +317,151 @@ namespace dtEntityWrappers
 #endif
    }
 
+   ////////////////////////////////////////////////////////////////////////////////
+   // true if v is a typed or plain array with at least minlength entries
+   bool IsNumberArray(v8::Handle<v8::Value> v, unsigned int minlength)
+   {
+      if(v.IsEmpty())
+      {
+         return false;
+      }
+      double* data;
+      unsigned int length;
+      if(GetFloat64ArrayData(v, data, length))
+      {
+         return length >= minlength;
+      }
+      return v->IsArray() && Handle<Array>::Cast(v)->Length() >= minlength;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   // copy up to count numbers from typed or plain array to out,
+   // entries missing in v are set to 0
+   void UnwrapNumbers(v8::Handle<v8::Value> v, double* out, unsigned int count)
+   {
+      unsigned int num = 0;
+      double* data;
+      unsigned int length;
+      if(GetFloat64ArrayData(v, data, length))
+      {
+         num = std::min(count, length);
+         memcpy(out, data, num * sizeof(double));
+      }
+      else if(!v.IsEmpty() && v->IsArray())
+      {
+         HandleScope scope;
+         Handle<Array> arr = Handle<Array>::Cast(v);
+         num = std::min(count, arr->Length());
+         for(unsigned int i = 0; i < num; ++i)
+         {
+            out[i] = arr->Get(i)->NumberValue();
+         }
+      }
+      std::fill(out + num, out + count, 0.0);
+   }
+
    ////////////////////////////////////////////////////////////////////////////////
    bool IsVec2(v8::Handle<v8::Value> v)
    {
-      return (!v.IsEmpty() && v->IsArray() && Handle<Array>::Cast(v)->Length() >= 2);
+      return IsNumberArray(v, 2);
    }
 
    ////////////////////////////////////////////////////////////////////////////////
    bool IsVec3(v8::Handle<v8::Value> v)
    {
-      return (!v.IsEmpty() && v->IsArray() && Handle<Array>::Cast(v)->Length() >= 3);
+      return IsNumberArray(v, 3);
    }
 
    ////////////////////////////////////////////////////////////////////////////////
    bool IsVec4(v8::Handle<v8::Value> v)
    {
-      return (!v.IsEmpty() && v->IsArray() && Handle<Array>::Cast(v)->Length() >= 4);
+      return IsNumberArray(v, 4);
    }
 
    ////////////////////////////////////////////////////////////////////////////////
    bool IsQuat(v8::Handle<v8::Value> v)
    {
-      return (!v.IsEmpty() && v->IsArray() && Handle<Array>::Cast(v)->Length() >= 4);
+      return IsNumberArray(v, 4);
    }
 
    ////////////////////////////////////////////////////////////////////////////////
+   // array of four rows as created by WrapMatrix, or flat array of 16 values
    bool IsMatrix(v8::Handle<v8::Value> v)
    {
-      return (!v.IsEmpty() && v->IsArray() && Handle<Array>::Cast(v)->Length() >= 16);
+      if(IsNumberArray(v, 16))
+      {
+         return true;
+      }
+      if(v.IsEmpty() || !v->IsArray())
+      {
+         return false;
+      }
+      HandleScope scope;
+      Handle<Array> arr = Handle<Array>::Cast(v);
+      if(arr->Length() < 4)
+      {
+         return false;
+      }
+      for(unsigned int i = 0; i < 4; ++i)
+      {
+         if(!IsNumberArray(arr->Get(i), 4))
+         {
+            return false;
+         }
+      }
+      return true;
    }
 
    ////////////////////////////////////////////////////////////////////////////////
    dtEntity::Vec2d UnwrapVec2(v8::Handle<v8::Value> v)
    {
-      HandleScope scope;
-      Handle<Array> arr = Handle<Array>::Cast(v);
-      return dtEntity::Vec2d(arr->Get(0)->NumberValue(),
-                       arr->Get(1)->NumberValue());
+      dtEntity::Vec2d ret;
+      UnwrapNumbers(v, ret.ptr(), 2);
+      return ret;
    }
 
    ////////////////////////////////////////////////////////////////////////////////
    dtEntity::Vec3d UnwrapVec3(v8::Handle<v8::Value> v)
    {
-      HandleScope scope;
-      Handle<Array> arr = Handle<Array>::Cast(v);
-      return dtEntity::Vec3d(arr->Get(0)->NumberValue(),
-                       arr->Get(1)->NumberValue(),
-                       arr->Get(2)->NumberValue());
+      dtEntity::Vec3d ret;
+      UnwrapNumbers(v, ret.ptr(), 3);
+      return ret;
    }
 
    ////////////////////////////////////////////////////////////////////////////////
    dtEntity::Vec4d UnwrapVec4(v8::Handle<v8::Value> v)
    {
-      HandleScope scope;
-      Handle<Array> arr = Handle<Array>::Cast(v);
-      return dtEntity::Vec4d(arr->Get(0)->NumberValue(),
-                       arr->Get(1)->NumberValue(),
-                       arr->Get(2)->NumberValue(),
-                       arr->Get(3)->NumberValue());
+      dtEntity::Vec4d ret;
+      UnwrapNumbers(v, ret.ptr(), 4);
+      return ret;
    }
 
    ////////////////////////////////////////////////////////////////////////////////
    dtEntity::Quat UnwrapQuat(v8::Handle<v8::Value> v)
    {
-      HandleScope scope;
-      Handle<Array> arr = Handle<Array>::Cast(v);
-      return dtEntity::Quat(arr->Get(0)->NumberValue(),
-                       arr->Get(1)->NumberValue(),
-                       arr->Get(2)->NumberValue(),
-                       arr->Get(3)->NumberValue());
+      double vals[4];
+      UnwrapNumbers(v, vals, 4);
+      return dtEntity::Quat(vals[0], vals[1], vals[2], vals[3]);
    }
 
    ////////////////////////////////////////////////////////////////////////////////
    dtEntity::Matrix UnwrapMatrix(v8::Handle<v8::Value> v)
    {
-      HandleScope scope;
-      Handle<Array> arr = Handle<Array>::Cast(v);
-
-      return dtEntity::Matrix(arr->Get(0)->NumberValue(),
-                         arr->Get(1)->NumberValue(),
-                         arr->Get(2)->NumberValue(),
-                         arr->Get(3)->NumberValue(),
-						 arr->Get(4)->NumberValue(),
-						 arr->Get(5)->NumberValue(),
-						 arr->Get(6)->NumberValue(),
-						 arr->Get(7)->NumberValue(),
-						 arr->Get(8)->NumberValue(),
-						 arr->Get(9)->NumberValue(),
-						 arr->Get(10)->NumberValue(),
-						 arr->Get(11)->NumberValue(),
-						 arr->Get(12)->NumberValue(),
-						 arr->Get(13)->NumberValue(),
-						 arr->Get(14)->NumberValue(),
-						 arr->Get(15)->NumberValue()
-                       );
+      double vals[16];
+      if(IsNumberArray(v, 16) || v.IsEmpty() || !v->IsArray())
+      {
+         UnwrapNumbers(v, vals, 16);
+      }
+      else
+      {
+         HandleScope scope;
+         Handle<Array> arr = Handle<Array>::Cast(v);
+         for(unsigned int i = 0; i < 4; ++i)
+         {
+            UnwrapNumbers(arr->Get(i), vals + i * 4, 4);
+         }
+      }
+      return dtEntity::Matrix(vals);
    }
 
 
@@ -328,8 +471,11 @@ namespace dtEntityWrappers
       int f = open(name, O_RDONLY);
       if (f == -1) { return NULL; }
       *size = lseek(f, 0, SEEK_END);
-      void * data = mmap(0, *size, PROT_READ, MAP_SHARED, f, 0);
+      if (*size == 0) { close(f); return NULL; }
+      /* private writable mapping, so that buffers can be modified without touching the file */
+      void * data = mmap(0, *size, PROT_READ | PROT_WRITE, MAP_PRIVATE, f, 0);
       close(f);
+      if (data == MAP_FAILED) { return NULL; }
    #else
 #ifdef _WIN32
       #	pragma warning(push)
@@ -369,14 +515,13 @@ namespace dtEntityWrappers
    #ifdef HAVE_MMAN_H
       int f = open(name, O_RDWR | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
       if (f == -1) { return -1; }
+      if (size == 0) { close(f); return 0; }
       lseek(f, size - 1, SEEK_SET);
       size_t written = write(f, "", 1);
-      if (written != 1) { return -1; }
+      if (written != 1) { close(f); return -1; }
 
-   void * mmap_read(char * name, size_t * size);
-   void mmap_free(char * data, size_t size);
-   int mmap_write(char * name, void * data, size_t size);
       void * dst = mmap(0, size, PROT_WRITE, MAP_SHARED, f, 0);
+      if (dst == MAP_FAILED) { close(f); return -1; }
       memcpy(dst, data, size);
       munmap(dst, size);
       close(f);
@@ -0,0 +1,607 @@
+/*
+* dtEntity Game and Simulation Engine
+*
+* This library is free software; you can redistribute it and/or modify it under
+* the terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; either version 2.1 of the License, or (at your option)
+* any later version.
+*
+* This library is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+* FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+* details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this library; if not, write to the Free Software Foundation, Inc.,
+* 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*
+* Martin Scheffler
+*/
+
+#include <dtEntityWrappers/workerpool.h>
+
+#include <dtEntity/dtentity_config.h>
+#include <dtEntity/entitymanager.h>
+#include <dtEntity/log.h>
+#include <dtEntityWrappers/buffer.h>
+#include <dtEntityWrappers/bytestorage.h>
+#include <dtEntityWrappers/messages.h>
+#include <dtEntityWrappers/propertyconverter.h>
+#include <dtEntityWrappers/scriptcomponent.h>
+#include <dtEntityWrappers/v8helpers.h>
+#include <OpenThreads/ScopedLock>
+#include <OpenThreads/Thread>
+#include <algorithm>
+
+#if DTENTITY_PROFILING_ENABLED
+#include <dtEntity/profile.h>
+#endif
+
+using namespace v8;
+
+namespace dtEntityWrappers
+{
+   dtEntity::StringId s_workerPoolWrapper = dtEntity::SID("WorkerPoolWrapper");
+
+   ////////////////////////////////////////////////////////////////////////////////
+   // Move storage of a buffer object out of the script engine, the buffer
+   // is left empty. Storage shared with other buffers is copied instead,
+   // as its reference count is not thread safe
+   ByteStorage* DetachBuffer(Handle<Value> v)
+   {
+      Handle<Object> obj = Handle<Object>::Cast(v);
+      ByteStorage* bs = JS_TO_BYTESTORAGE(obj);
+      if(bs->getStorage()->getInstances() > 1)
+      {
+         return new ByteStorage(bs->getData(), bs->getLength());
+      }
+      obj->SetPointerInInternalField(0, new ByteStorage(0));
+      return bs;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   // detach all buffers in array. Returns false if val is not an array of buffers
+   bool GetTransferList(Handle<Context> context, Handle<Value> val, WorkerPool::Buffers& buffers)
+   {
+      if(val.IsEmpty() || val->IsUndefined())
+      {
+         return true;
+      }
+      if(!val->IsArray())
+      {
+         return false;
+      }
+      HandleScope scope;
+      Handle<Array> arr = Handle<Array>::Cast(val);
+      for(unsigned int i = 0; i < arr->Length(); ++i)
+      {
+         if(!IS_BUFFER(context, arr->Get(i)))
+         {
+            return false;
+         }
+      }
+      for(unsigned int i = 0; i < arr->Length(); ++i)
+      {
+         buffers.push_back(DetachBuffer(arr->Get(i)));
+      }
+      return true;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   // create buffer objects for storages, script engine takes ownership
+   Handle<Array> WrapTransferList(Handle<Context> context, const WorkerPool::Buffers& buffers)
+   {
+      HandleScope scope;
+      Handle<Array> arr = Array::New(buffers.size());
+      for(unsigned int i = 0; i < buffers.size(); ++i)
+      {
+         arr->Set(i, BYTESTORAGE_TO_JS(context, buffers[i]));
+      }
+      return scope.Close(arr);
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void DeleteBuffers(WorkerPool::Buffers& buffers)
+   {
+      for(WorkerPool::Buffers::iterator i = buffers.begin(); i != buffers.end(); ++i)
+      {
+         delete *i;
+      }
+      buffers.clear();
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   ////////////////////////////////////////////////////////////////////////////////
+   /**
+    * Thread owning a script engine isolate. The isolate is only ever
+    * entered from this thread, so no locking of the engine is needed.
+    */
+   class WorkerThread : public OpenThreads::Thread
+   {
+   public:
+
+      WorkerThread(WorkerPool& pool)
+         : mPool(&pool)
+         , mCurrentJob(NULL)
+      {
+      }
+
+      virtual void run();
+
+      Handle<Value> SendResult(const Arguments& args);
+
+   private:
+
+      Handle<Context> GetModuleContext(const std::string& module);
+      void RunJob(WorkerPool::Job& job);
+
+      WorkerPool* mPool;
+      WorkerPool::Job* mCurrentJob;
+
+      typedef std::map<std::string, Persistent<Context> > ModuleContexts;
+      ModuleContexts mModuleContexts;
+   };
+
+   ////////////////////////////////////////////////////////////////////////////////
+   Handle<Value> WorkerPostMessage(const Arguments& args)
+   {
+      WorkerThread* thread = static_cast<WorkerThread*>(Isolate::GetCurrent()->GetData());
+      return thread->SendResult(args);
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   Handle<Value> WorkerPrint(const Arguments& args)
+   {
+      LOG_ALWAYS(ToStdString(args[0]));
+      return Undefined();
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void WorkerThread::run()
+   {
+      Isolate* isolate = Isolate::New();
+      {
+         Isolate::Scope isolate_scope(isolate);
+         isolate->SetData(this);
+
+#if DTENTITY_PROFILING_ENABLED
+         CProfileManager::Set_Thread_Name("Script Worker");
+#endif
+         WorkerPool::Job* job;
+         while((job = mPool->WaitForJob()) != NULL)
+         {
+#if DTENTITY_PROFILING_ENABLED
+            // only hash module name if scripts are profiled
+            bool profiled = CProfileManager::Is_Enabled(ProfileCategory::SCRIPTS);
+            if(profiled)
+            {
+               CProfileManager::Start_Profile(dtEntity::SID(job->mModule));
+            }
+            RunJob(*job);
+            if(profiled)
+            {
+               CProfileManager::Stop_Profile();
+            }
+#else
+            RunJob(*job);
+#endif
+            delete job->mData;
+            DeleteBuffers(job->mBuffers);
+            delete job;
+            mPool->JobDone();
+         }
+
+         for(ModuleContexts::iterator i = mModuleContexts.begin(); i != mModuleContexts.end(); ++i)
+         {
+            i->second.Dispose();
+         }
+         mModuleContexts.clear();
+      }
+      isolate->Dispose();
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   Handle<Context> WorkerThread::GetModuleContext(const std::string& module)
+   {
+      ModuleContexts::iterator i = mModuleContexts.find(module);
+      if(i != mModuleContexts.end())
+      {
+         return i->second;
+      }
+
+      std::string source;
+      if(!mPool->GetModuleSource(module, source))
+      {
+         LOG_ERROR("Script module is not allowed in workers: " + module);
+         return Handle<Context>();
+      }
+
+      HandleScope scope;
+      Persistent<Context> context = Context::New();
+      mModuleContexts[module] = context;
+
+      Context::Scope context_scope(context);
+      Handle<Object> global = context->Global();
+      global->Set(String::New("Buffer"), CreateBuffer());
+      global->Set(String::New("postMessage"), FunctionTemplate::New(WorkerPostMessage)->GetFunction());
+      global->Set(String::New("print"), FunctionTemplate::New(WorkerPrint)->GetFunction());
+
+      TryCatch try_catch;
+      Handle<Script> script = Script::Compile(ToJSString(source), ToJSString(module));
+      if(!script.IsEmpty())
+      {
+         script->Run();
+      }
+      if(try_catch.HasCaught())
+      {
+         ReportException(&try_catch);
+      }
+      return context;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void WorkerThread::RunJob(WorkerPool::Job& job)
+   {
+      HandleScope scope;
+      Handle<Context> context = GetModuleContext(job.mModule);
+      if(context.IsEmpty())
+      {
+         return;
+      }
+
+      Context::Scope context_scope(context);
+      Handle<Value> onmessage = context->Global()->Get(String::New("onmessage"));
+      if(onmessage.IsEmpty() || !onmessage->IsFunction())
+      {
+         LOG_ERROR("Worker module does not define function onmessage: " + job.mModule);
+         return;
+      }
+
+      Handle<Value> argv[3] = {
+         ConvertPropertyToValue(context, job.mData),
+         WrapTransferList(context, job.mBuffers),
+         Uint32::New(job.mJobId)
+      };
+      // buffers are owned by script engine now
+      job.mBuffers.clear();
+
+      mCurrentJob = &job;
+      TryCatch try_catch;
+      Handle<Function>::Cast(onmessage)->Call(context->Global(), 3, argv);
+      if(try_catch.HasCaught())
+      {
+         ReportException(&try_catch);
+      }
+      mCurrentJob = NULL;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   Handle<Value> WorkerThread::SendResult(const Arguments& args)
+   {
+      if(mCurrentJob == NULL)
+      {
+         return ThrowError("postMessage can only be called from onmessage!");
+      }
+      if(args.Length() < 1 || !args[0]->IsObject() || args[0]->IsArray())
+      {
+         return ThrowError("Usage: postMessage(object data, [Array buffers])");
+      }
+
+      HandleScope scope;
+      WorkerPool::Buffers buffers;
+      if(!GetTransferList(Context::GetCurrent(), args[1], buffers))
+      {
+         return ThrowError("Second argument of postMessage has to be an array of buffers!");
+      }
+
+      dtEntity::Property* data = ConvertValueToProperty(args[0]);
+      if(data == NULL || data->GetDataType() != dtEntity::DataType::GROUP)
+      {
+         delete data;
+         DeleteBuffers(buffers);
+         return ThrowError("Cannot convert worker message data!");
+      }
+
+      mPool->PostResult(mCurrentJob->mModule, mCurrentJob->mJobId, *static_cast<dtEntity::GroupProperty*>(data), buffers);
+      delete data;
+      return Undefined();
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   ////////////////////////////////////////////////////////////////////////////////
+   WorkerPool::WorkerPool(dtEntity::EntityManager& em)
+      : mEntityManager(&em)
+      , mNumThreads(2)
+      , mQuit(false)
+      , mNextJobId(0)
+      , mNumPendingJobs(0)
+      , mNextTransferId(0)
+   {
+      mWorkerMessageFunctor = dtEntity::MessageFunctor(this, &WorkerPool::OnWorkerMessage);
+      em.RegisterForMessages(WorkerMessage::TYPE, mWorkerMessageFunctor,
+         dtEntity::FilterOptions::ORDER_LATE, "WorkerPool::OnWorkerMessage");
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   WorkerPool::~WorkerPool()
+   {
+      StopThreads();
+      mEntityManager->UnregisterForMessages(WorkerMessage::TYPE, mWorkerMessageFunctor);
+
+      for(std::deque<Job*>::iterator i = mJobs.begin(); i != mJobs.end(); ++i)
+      {
+         delete (*i)->mData;
+         DeleteBuffers((*i)->mBuffers);
+         delete *i;
+      }
+      mJobs.clear();
+
+      for(std::map<unsigned int, Buffers>::iterator i = mTransfers.begin(); i != mTransfers.end(); ++i)
+      {
+         DeleteBuffers(i->second);
+      }
+      mTransfers.clear();
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   bool WorkerPool::AddModule(const std::string& path)
+   {
+      std::string source;
+      if(!GetFileContents(path, source))
+      {
+         return false;
+      }
+      OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+      mModules[path] = source;
+      return true;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   bool WorkerPool::HasModule(const std::string& path) const
+   {
+      OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+      return mModules.find(path) != mModules.end();
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   bool WorkerPool::GetModuleSource(const std::string& path, std::string& source) const
+   {
+      OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+      std::map<std::string, std::string>::const_iterator i = mModules.find(path);
+      if(i == mModules.end())
+      {
+         return false;
+      }
+      source = i->second;
+      return true;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   unsigned int WorkerPool::Post(const std::string& module, dtEntity::GroupProperty* data, const Buffers& buffers)
+   {
+      if(!HasModule(module))
+      {
+         LOG_ERROR("Cannot post job, script module is not allowed in workers: " + module);
+         delete data;
+         Buffers b = buffers;
+         DeleteBuffers(b);
+         return 0;
+      }
+
+      if(mThreads.empty())
+      {
+         StartThreads();
+      }
+
+      Job* job = new Job();
+      job->mModule = module;
+      job->mData = data;
+      job->mBuffers = buffers;
+
+      OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+      job->mJobId = ++mNextJobId;
+      mJobs.push_back(job);
+      ++mNumPendingJobs;
+      mJobAvailable.signal();
+      return job->mJobId;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   unsigned int WorkerPool::GetNumPendingJobs() const
+   {
+      OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+      return mNumPendingJobs;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void WorkerPool::StartThreads()
+   {
+      mQuit = false;
+      unsigned int num = std::max(mNumThreads, 1u);
+      for(unsigned int i = 0; i < num; ++i)
+      {
+         WorkerThread* thread = new WorkerThread(*this);
+         mThreads.push_back(thread);
+         thread->start();
+      }
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void WorkerPool::StopThreads()
+   {
+      {
+         OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+         mQuit = true;
+         mJobAvailable.broadcast();
+      }
+      for(std::vector<WorkerThread*>::iterator i = mThreads.begin(); i != mThreads.end(); ++i)
+      {
+         (*i)->join();
+         delete *i;
+      }
+      mThreads.clear();
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   WorkerPool::Job* WorkerPool::WaitForJob()
+   {
+      OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+      while(mJobs.empty() && !mQuit)
+      {
+         mJobAvailable.wait(&mMutex);
+      }
+      if(mQuit)
+      {
+         return NULL;
+      }
+      Job* job = mJobs.front();
+      mJobs.pop_front();
+      return job;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void WorkerPool::JobDone()
+   {
+      OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+      --mNumPendingJobs;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void WorkerPool::PostResult(const std::string& module, unsigned int jobid, const dtEntity::GroupProperty& data, const Buffers& buffers)
+   {
+      unsigned int transferid = 0;
+      if(!buffers.empty())
+      {
+         OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+         transferid = ++mNextTransferId;
+         mTransfers[transferid] = buffers;
+      }
+
+      WorkerMessage msg;
+      msg.SetModule(module);
+      msg.SetJobId(jobid);
+      msg.SetData(data.Get());
+      msg.SetTransferId(transferid);
+      mEntityManager->EnqueueMessage(msg);
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   bool WorkerPool::TakeTransfer(unsigned int transferid, Buffers& buffers)
+   {
+      OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+      std::map<unsigned int, Buffers>::iterator i = mTransfers.find(transferid);
+      if(i == mTransfers.end())
+      {
+         return false;
+      }
+      buffers.insert(buffers.end(), i->second.begin(), i->second.end());
+      mTransfers.erase(i);
+      return true;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void WorkerPool::OnWorkerMessage(const dtEntity::Message& m)
+   {
+      const WorkerMessage& msg = static_cast<const WorkerMessage&>(m);
+      if(msg.GetTransferId() == 0)
+      {
+         return;
+      }
+      Buffers buffers;
+      if(TakeTransfer(msg.GetTransferId(), buffers))
+      {
+         DeleteBuffers(buffers);
+      }
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   ////////////////////////////////////////////////////////////////////////////////
+   WorkerPool* UnwrapWorkerPool(Handle<Value> val)
+   {
+      WorkerPool* v;
+      GetInternal(Handle<Object>::Cast(val), 0, v);
+      return v;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   Handle<Value> WPPost(const Arguments& args)
+   {
+      if(args.Length() < 2 || !args[1]->IsObject() || args[1]->IsArray())
+      {
+         return ThrowError("Usage: post(string module, object data, [Array buffers])");
+      }
+      WorkerPool* pool = UnwrapWorkerPool(args.This());
+      std::string module = ToStdString(args[0]);
+      if(!pool->HasModule(module))
+      {
+         return ThrowError("Script module is not allowed in workers: " + module);
+      }
+
+      HandleScope scope;
+      WorkerPool::Buffers buffers;
+      if(!GetTransferList(Context::GetCurrent(), args[2], buffers))
+      {
+         return ThrowError("Third argument of post has to be an array of buffers!");
+      }
+      dtEntity::Property* data = ConvertValueToProperty(args[1]);
+      if(data == NULL || data->GetDataType() != dtEntity::DataType::GROUP)
+      {
+         delete data;
+         DeleteBuffers(buffers);
+         return ThrowError("Cannot convert worker job data!");
+      }
+      return scope.Close(Uint32::New(pool->Post(module, static_cast<dtEntity::GroupProperty*>(data), buffers)));
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   Handle<Value> WPTakeBuffers(const Arguments& args)
+   {
+      WorkerPool* pool = UnwrapWorkerPool(args.This());
+      WorkerPool::Buffers buffers;
+      if(!pool->TakeTransfer(args[0]->Uint32Value(), buffers))
+      {
+         return Undefined();
+      }
+      return WrapTransferList(Context::GetCurrent(), buffers);
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   Handle<Value> WPGetNumPendingJobs(const Arguments& args)
+   {
+      WorkerPool* pool = UnwrapWorkerPool(args.This());
+      return Uint32::New(pool->GetNumPendingJobs());
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   Handle<Value> WPToString(const Arguments& args)
+   {
+      return String::New("<WorkerPool>");
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   Handle<Object> WrapWorkerPool(WorkerPool* v)
+   {
+      HandleScope handle_scope;
+
+      Handle<FunctionTemplate> templt = GetScriptSystem()->GetTemplateBySID(s_workerPoolWrapper);
+
+      if(templt.IsEmpty())
+      {
+         templt = FunctionTemplate::New();
+         templt->SetClassName(String::New("WorkerPool"));
+         templt->InstanceTemplate()->SetInternalFieldCount(1);
+
+         Handle<ObjectTemplate> proto = templt->PrototypeTemplate();
+
+         proto->Set("getNumPendingJobs", FunctionTemplate::New(WPGetNumPendingJobs));
+         proto->Set("post", FunctionTemplate::New(WPPost));
+         proto->Set("takeBuffers", FunctionTemplate::New(WPTakeBuffers));
+         proto->Set("toString", FunctionTemplate::New(WPToString));
+
+         GetScriptSystem()->SetTemplateBySID(s_workerPoolWrapper, templt);
+      }
+      Local<Object> instance = templt->GetFunction()->NewInstance();
+      instance->SetInternalField(0, External::New(v));
+      return handle_scope.Close(instance);
+   }
+}
@@ -33,6 +33,7 @@
 #include <dtEntityWrappers/mapsystemwrapper.h>
 #include <dtEntityWrappers/scriptcomponent.h>
 #include <dtEntityWrappers/v8helpers.h>
+#include <dtEntityWrappers/workerpool.h>
 #include <dtEntity/dtentity_config.h>
 #include <v8.h>
 
@@ -99,6 +100,7 @@ namespace dtEntityWrappers
       context->Global()->Set(String::New("Buffer"), CreateBuffer());
       context->Global()->Set(String::New("File"), CreateFile());
       context->Global()->Set(String::New("Log"), WrapLogger(context));
+      context->Global()->Set(String::New("Workers"), WrapWorkerPool(&scriptsystem->GetWorkerPool()));
 
       InitMapSystemWrapper(scriptsystem);
       